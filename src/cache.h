@@ -184,7 +184,7 @@ __attribute__((always_inline)) INLINE int cache_read_particles(
     const struct cell *restrict const ci,
     struct cache *restrict const ci_cache) {
 
-#if defined(GADGET2_SPH)
+#if defined(HYDRO_VEC_DENSITY_LOOP)
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -265,7 +265,7 @@ __attribute__((always_inline)) INLINE int cache_read_particles_subset_self(
     const struct cell *restrict const ci,
     struct cache *restrict const ci_cache) {
 
-#if defined(GADGET2_SPH)
+#if defined(HYDRO_VEC_DENSITY_LOOP)
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -348,7 +348,7 @@ __attribute__((always_inline)) INLINE void cache_read_particles_subset_pair(
     const struct sort_entry *restrict sort_i, int *first_pi, int *last_pi,
     const double *loc, const int flipped) {
 
-#if defined(GADGET2_SPH)
+#if defined(HYDRO_VEC_DENSITY_LOOP)
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -495,7 +495,7 @@ __attribute__((always_inline)) INLINE int cache_read_force_particles(
     const struct cell *restrict const ci,
     struct cache *restrict const ci_cache) {
 
-#if defined(GADGET2_SPH)
+#if defined(HYDRO_VEC_FORCE_LOOP)
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -689,7 +689,7 @@ __attribute__((always_inline)) INLINE void cache_read_two_partial_cells_sorted(
     vx[i] = parts_i[idx].v[0];
     vy[i] = parts_i[idx].v[1];
     vz[i] = parts_i[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef HYDRO_VEC_DENSITY_LOOP
     m[i] = parts_i[idx].mass;
 #endif
   }
@@ -791,7 +791,7 @@ __attribute__((always_inline)) INLINE void cache_read_two_partial_cells_sorted(
     vxj[i] = parts_j[idx].v[0];
     vyj[i] = parts_j[idx].v[1];
     vzj[i] = parts_j[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef HYDRO_VEC_DENSITY_LOOP
     mj[i] = parts_j[idx].mass;
 #endif
   }
@@ -955,7 +955,7 @@ cache_read_two_partial_cells_sorted_force(
     vx[i] = parts_i[idx].v[0];
     vy[i] = parts_i[idx].v[1];
     vz[i] = parts_i[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef HYDRO_VEC_FORCE_LOOP
     m[i] = parts_i[idx].mass;
     rho[i] = parts_i[idx].rho;
     grad_h[i] = parts_i[idx].force.f;
@@ -1039,7 +1039,7 @@ cache_read_two_partial_cells_sorted_force(
     vxj[i] = parts_j[idx].v[0];
     vyj[i] = parts_j[idx].v[1];
     vzj[i] = parts_j[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef HYDRO_VEC_FORCE_LOOP
     mj[i] = parts_j[idx].mass;
     rhoj[i] = parts_j[idx].rho;
     grad_hj[i] = parts_j[idx].force.f;
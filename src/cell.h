@@ -53,6 +53,7 @@
 struct engine;
 struct scheduler;
 struct replication_list;
+struct gravity_interaction_list;
 
 /* Max tag size set to 2^29 to take into account some MPI implementations
  * that use 2^31 as the upper bound on MPI tags and the fact that
@@ -511,6 +512,7 @@ void cell_split(struct cell *c, ptrdiff_t parts_offset, ptrdiff_t sparts_offset,
                 struct cell_buff *sinkbuff);
 void cell_sanitize(struct cell *c, int treated);
 int cell_locktree(struct cell *c);
+int cell_hydro_is_locked(const struct cell *c);
 void cell_unlocktree(struct cell *c);
 int cell_glocktree(struct cell *c);
 void cell_gunlocktree(struct cell *c);
@@ -539,8 +541,8 @@ int cell_pack_end_step(const struct cell *c, struct pcell_step *pcell);
 int cell_unpack_end_step(struct cell *c, const struct pcell_step *pcell);
 void cell_pack_timebin(const struct cell *const c, timebin_t *const t);
 void cell_unpack_timebin(struct cell *const c, timebin_t *const t);
-int cell_pack_multipoles(struct cell *c, struct gravity_tensors *m);
-int cell_unpack_multipoles(struct cell *c, struct gravity_tensors *m);
+int cell_pack_multipoles(struct cell *c, struct gravity_tensors_pack *m);
+int cell_unpack_multipoles(struct cell *c, struct gravity_tensors_pack *m);
 int cell_pack_sf_counts(struct cell *c, struct pcell_sf *pcell);
 int cell_unpack_sf_counts(struct cell *c, struct pcell_sf *pcell);
 int cell_get_tree_size(struct cell *c);
@@ -601,6 +603,8 @@ void cell_activate_subcell_hydro_tasks(struct cell *ci, struct cell *cj,
                                        const int with_timestep_limiter);
 int cell_activate_subcell_grav_tasks(struct cell *ci, struct cell *cj,
                                      struct scheduler *s);
+void cell_activate_grav_interaction_list(
+    const struct gravity_interaction_list *list, struct scheduler *s);
 void cell_activate_subcell_stars_tasks(struct cell *ci, struct cell *cj,
                                        struct scheduler *s,
                                        const int with_star_formation,
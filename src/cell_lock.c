@@ -28,6 +28,26 @@
 /* Local headers. */
 #include "timers.h"
 
+/**
+ * @brief Check, without any atomic operation, whether a cell's array of
+ * #part is in use.
+ *
+ * This is the case if the cell is held, i.e. one of its progeny is locked,
+ * or if the cell or any of its parents is locked. The answer may be out of
+ * date by the time it is returned, so this is only a hint that a call to
+ * cell_locktree() would fail.
+ *
+ * @param c The #cell.
+ * @return 1 if the cell cannot currently be locked, 0 otherwise.
+ */
+int cell_hydro_is_locked(const struct cell *c) {
+
+  if (c->hydro.hold) return 1;
+  for (const struct cell *finger = c; finger != NULL; finger = finger->parent)
+    if (lock_is_locked(&finger->hydro.lock)) return 1;
+  return 0;
+}
+
 /**
  * @brief Lock a cell for access to its array of #part and hold its parents.
  *
@@ -25,6 +25,9 @@
 /* This object's header. */
 #include "cell.h"
 
+/* Local headers. */
+#include "multipole.h"
+
 /**
  * @brief Pack the data of the given cell and all it's sub-cells.
  *
@@ -470,11 +473,11 @@ void cell_unpack_timebin(struct cell *const c, timebin_t *const t) {
  * @return The number of packed cells.
  */
 int cell_pack_multipoles(struct cell *restrict c,
-                         struct gravity_tensors *restrict pcells) {
+                         struct gravity_tensors_pack *restrict pcells) {
 #ifdef WITH_MPI
 
   /* Pack this cell's data. */
-  pcells[0] = *c->grav.multipole;
+  gravity_pack(c->grav.multipole, &pcells[0]);
 
   /* Fill in the progeny, depth-first recursion. */
   int count = 1;
@@ -501,11 +504,11 @@ int cell_pack_multipoles(struct cell *restrict c,
  * @return The number of cells created.
  */
 int cell_unpack_multipoles(struct cell *restrict c,
-                           struct gravity_tensors *restrict pcells) {
+                           struct gravity_tensors_pack *restrict pcells) {
 #ifdef WITH_MPI
 
   /* Unpack this cell's data. */
-  *c->grav.multipole = pcells[0];
+  gravity_unpack(c->grav.multipole, &pcells[0]);
 
   /* Fill in the progeny, depth-first recursion. */
   int count = 1;
@@ -29,6 +29,7 @@
 #include "active.h"
 #include "engine.h"
 #include "feedback.h"
+#include "gravity_interaction_list.h"
 #include "space_getsid.h"
 
 extern int engine_star_resort_task_depth;
@@ -1499,6 +1500,98 @@ int cell_activate_subcell_grav_tasks(struct cell *restrict ci,
   return -1;
 }
 
+/**
+ * @brief Activate the gravity drift tasks required by the tree walk recorded
+ * in a #gravity_interaction_list.
+ *
+ * This follows the same decisions as the runner replaying the list. The M-M
+ * and out-of-range entries, as well as the entries whose particles have
+ * moved too much, are handed to cell_activate_subcell_grav_tasks() as the
+ * runner will check them again with the current multipoles.
+ *
+ * @param list The #gravity_interaction_list of the task.
+ * @param s The task #scheduler.
+ */
+void cell_activate_grav_interaction_list(
+    const struct gravity_interaction_list *list, struct scheduler *s) {
+
+  /* Some constants */
+  const struct engine *e = s->space->e;
+  const int nodeID = e->nodeID;
+
+  int i = 0;
+  while (i < list->count) {
+
+    const struct gravity_interaction *in = &list->entries[i];
+    struct cell *ci = in->ci;
+    struct cell *cj = in->cj;
+
+    /* Self interaction? */
+    if (cj == NULL) {
+
+      /* Do anything? If not, skip the whole sub-walk */
+      if (ci->grav.count == 0 || !cell_is_active_gravity(ci, e)) {
+        i = in->next;
+        continue;
+      }
+
+      /* We have reached the bottom of the tree: activate gpart drift */
+      if (in->type == gravity_interaction_self_pp)
+        cell_activate_drift_gpart(ci, s);
+
+      ++i;
+      continue;
+    }
+
+    /* Anything to do here? If not, skip the whole sub-walk */
+    const int do_ci = cell_is_active_gravity(ci, e) && ci->nodeID == nodeID;
+    const int do_cj = cell_is_active_gravity(cj, e) && cj->nodeID == nodeID;
+    if ((!do_ci && !do_cj) || ci->grav.count == 0 || cj->grav.count == 0) {
+      i = in->next;
+      continue;
+    }
+
+    /* Atomically drift the multipole in ci */
+    lock_lock(&ci->grav.mlock);
+    if (ci->grav.ti_old_multipole < e->ti_current) cell_drift_multipole(ci, e);
+    if (lock_unlock(&ci->grav.mlock) != 0) error("Impossible to unlock m-pole");
+
+    /* Atomically drift the multipole in cj */
+    lock_lock(&cj->grav.mlock);
+    if (cj->grav.ti_old_multipole < e->ti_current) cell_drift_multipole(cj, e);
+    if (lock_unlock(&cj->grav.mlock) != 0) error("Impossible to unlock m-pole");
+
+    /* Same check on the particle displacements as in the runner */
+    if (in->type != gravity_interaction_pair_mm &&
+        in->type != gravity_interaction_pair_out_of_range &&
+        !gravity_interaction_list_entry_is_valid(in)) {
+      cell_activate_subcell_grav_tasks(ci, cj, s);
+      i = in->next;
+      continue;
+    }
+
+    switch (in->type) {
+      case gravity_interaction_pair_split:
+        /* Nothing to do, the progenies follow */
+        break;
+      case gravity_interaction_pair_pp:
+      case gravity_interaction_pair_pp_no_cache:
+        /* Activate the drifts if the cells are local. */
+        if (ci->nodeID == nodeID) cell_activate_drift_gpart(ci, s);
+        if (cj->nodeID == nodeID) cell_activate_drift_gpart(cj, s);
+        break;
+      case gravity_interaction_pair_mm:
+      case gravity_interaction_pair_out_of_range:
+        cell_activate_subcell_grav_tasks(ci, cj, s);
+        break;
+      default:
+        error("Invalid gravity interaction type (%d).", in->type);
+    }
+
+    ++i;
+  }
+}
+
 /**
  * @brief Traverse a sub-cell task and activate the gravity drift tasks that
  * are required by an external gravity task.
@@ -2031,9 +2124,15 @@ int cell_unskip_gravity_tasks(struct cell *c, struct scheduler *s) {
           t->subtype == task_subtype_external_grav) {
         cell_activate_subcell_external_grav_tasks(ci, s);
       } else if (t->type == task_type_self && t->subtype == task_subtype_grav) {
-        cell_activate_subcell_grav_tasks(ci, NULL, s);
+        if (t->grav_list != NULL)
+          cell_activate_grav_interaction_list(t->grav_list, s);
+        else
+          cell_activate_subcell_grav_tasks(ci, NULL, s);
       } else if (t->type == task_type_pair) {
-        cell_activate_subcell_grav_tasks(ci, cj, s);
+        if (t->grav_list != NULL)
+          cell_activate_grav_interaction_list(t->grav_list, s);
+        else
+          cell_activate_subcell_grav_tasks(ci, cj, s);
       } else if (t->type == task_type_grav_mm) {
 #ifdef SWIFT_DEBUG_CHECKS
         error("Incorrectly linked M-M task!");
@@ -81,7 +81,7 @@
 #include "memuse.h"
 #include "minmax.h"
 #include "mpiuse.h"
-#include "multipole_struct.h"
+#include "multipole.h"
 #include "neutrino.h"
 #include "neutrino_properties.h"
 #include "output_list.h"
@@ -103,6 +103,7 @@
 #include "statistics.h"
 #include "timers.h"
 #include "tools.h"
+#include "trace.h"
 #include "units.h"
 #include "velociraptor_interface.h"
 
@@ -530,6 +531,16 @@ void engine_exchange_top_multipoles(struct engine *e) {
   }
 #endif
 
+  /* Only ship the multipoles, not the field tensors */
+  struct gravity_tensors_pack *buffer = NULL;
+  if (swift_memalign("top_gravity_tensors", (void **)&buffer,
+                     SWIFT_CACHE_ALIGNMENT,
+                     e->s->nr_cells * sizeof(struct gravity_tensors_pack)) != 0)
+    error("Unable to allocate memory for multipole transactions");
+
+  for (int i = 0; i < e->s->nr_cells; ++i)
+    gravity_pack(&e->s->multipoles_top[i], &buffer[i]);
+
   /* Each node (space) has constructed its own top-level multipoles.
    * We now need to make sure every other node has a copy of everything.
    *
@@ -538,12 +549,17 @@ void engine_exchange_top_multipoles(struct engine *e) {
    * each multipole is only present once, the bit-by-bit XOR will
    * create the desired result.
    */
-  int err = MPI_Allreduce(MPI_IN_PLACE, e->s->multipoles_top, e->s->nr_cells,
+  int err = MPI_Allreduce(MPI_IN_PLACE, buffer, e->s->nr_cells,
                           multipole_mpi_type, multipole_mpi_reduce_op,
                           MPI_COMM_WORLD);
   if (err != MPI_SUCCESS)
     mpi_error(err, "Failed to all-reduce the top-level multipoles.");
 
+  for (int i = 0; i < e->s->nr_cells; ++i)
+    gravity_unpack(&e->s->multipoles_top[i], &buffer[i]);
+
+  swift_free("top_gravity_tensors", buffer);
+
 #ifdef SWIFT_DEBUG_CHECKS
   long long counter = 0;
 
@@ -609,16 +625,18 @@ void engine_exchange_proxy_multipoles(struct engine *e) {
   }
 
   /* Allocate the buffers for the packed data */
-  struct gravity_tensors *buffer_send = NULL;
+  struct gravity_tensors_pack *buffer_send = NULL;
   if (swift_memalign("send_gravity_tensors", (void **)&buffer_send,
                      SWIFT_CACHE_ALIGNMENT,
-                     count_send_cells * sizeof(struct gravity_tensors)) != 0)
+                     count_send_cells * sizeof(struct gravity_tensors_pack)) !=
+      0)
     error("Unable to allocate memory for multipole transactions");
 
-  struct gravity_tensors *buffer_recv = NULL;
+  struct gravity_tensors_pack *buffer_recv = NULL;
   if (swift_memalign("recv_gravity_tensors", (void **)&buffer_recv,
                      SWIFT_CACHE_ALIGNMENT,
-                     count_recv_cells * sizeof(struct gravity_tensors)) != 0)
+                     count_recv_cells * sizeof(struct gravity_tensors_pack)) !=
+      0)
     error("Unable to allocate memory for multipole transactions");
 
   /* Also allocate the MPI requests */
@@ -1217,7 +1235,10 @@ void engine_rebuild(struct engine *e, const int repartitioned,
 #endif
 
   /* Re-build the space. */
+  ticks tic_phase = getticks();
   space_rebuild(e->s, repartitioned, e->verbose);
+  if (trace_active)
+    trace_record_phase("space_rebuild", tic_phase, getticks());
 
   /* Report the number of cells and memory */
   if (e->verbose)
@@ -1318,7 +1339,10 @@ void engine_rebuild(struct engine *e, const int repartitioned,
 
   space_free_foreign_parts(e->s, /*clear_cell_pointers=*/1);
 
+  tic_phase = getticks();
   engine_exchange_cells(e);
+  if (trace_active)
+    trace_record_phase("engine_exchange_cells", tic_phase, getticks());
 #endif
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -1337,7 +1361,10 @@ void engine_rebuild(struct engine *e, const int repartitioned,
 #endif
 
   /* Re-build the tasks. */
+  tic_phase = getticks();
   engine_maketasks(e);
+  if (trace_active)
+    trace_record_phase("engine_maketasks", tic_phase, getticks());
 
   /* Reallocate freed memory */
 #ifdef WITH_MPI
@@ -1370,7 +1397,10 @@ void engine_rebuild(struct engine *e, const int repartitioned,
 #ifdef SWIFT_DEBUG_CHECKS
   activate_by_unskip = 1;
 #endif
+  tic_phase = getticks();
   engine_unskip(e);
+  if (trace_active)
+    trace_record_phase("engine_unskip", tic_phase, getticks());
   if (e->forcerebuild) error("engine_unskip faled after a rebuild!");
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -1423,6 +1453,8 @@ void engine_rebuild(struct engine *e, const int repartitioned,
   /* Flag that a rebuild has taken place */
   e->step_props |= engine_step_prop_rebuild;
 
+  if (trace_active) trace_record_phase("engine_rebuild", tic, getticks());
+
   if (e->verbose)
     message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
             clocks_getunit());
@@ -1751,10 +1783,7 @@ void engine_launch(struct engine *e, const char *call) {
   scheduler_start(&e->sched);
 
   /* Remove the safeguard. */
-  pthread_mutex_lock(&e->sched.sleep_mutex);
-  atomic_dec(&e->sched.waiting);
-  pthread_cond_broadcast(&e->sched.sleep_cond);
-  pthread_mutex_unlock(&e->sched.sleep_mutex);
+  if (atomic_dec(&e->sched.waiting) == 1) scheduler_wake_all(&e->sched);
 
   /* Sit back and wait for the runners to come home. */
   swift_barrier_wait(&e->wait_barrier);
@@ -1762,6 +1791,8 @@ void engine_launch(struct engine *e, const char *call) {
   /* Store the wallclock time */
   e->sched.total_ticks += getticks() - tic;
 
+  if (trace_active) trace_record_phase("engine_launch", tic, getticks());
+
   /* accumulate active counts for all runners */
   ticks active_time = 0;
   for (int i = 0; i < e->nr_threads; ++i) {
@@ -1770,10 +1801,15 @@ void engine_launch(struct engine *e, const char *call) {
   e->sched.deadtime.active_ticks += active_time;
   e->sched.deadtime.waiting_ticks += getticks() - tic;
 
+  /* Learn from the run time of the tasks. */
+  scheduler_update_cost_model(&e->sched, tic);
+
 #ifdef SWIFT_DEBUG_CHECKS
   e->sched.last_successful_task_fetch = 0LL;
 #endif
 
+  if (e->verbose) scheduler_report_queue_counters(&e->sched, call);
+
   if (e->verbose)
     message("(%s) took %.3f %s.", call, clocks_from_ticks(getticks() - tic),
             clocks_getunit());
@@ -24,6 +24,7 @@
 
 /* System includes. */
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -257,6 +258,42 @@ void engine_config(int restart, int fof, struct engine *e,
     message("Number of task queues set to %d", nr_queues);
   e->s->nr_queues = nr_queues;
 
+  /* Get the back-end of the task queues */
+  char queue_type[PARSER_MAX_LINE_SIZE];
+  parser_get_opt_param_string(params, "Scheduler:queue_type", queue_type,
+                              "heap");
+  if (strcmp(queue_type, "heap") == 0)
+    e->sched.queue_type = queue_type_heap;
+  else if (strcmp(queue_type, "deque") == 0)
+    e->sched.queue_type = queue_type_deque;
+  else
+    error("Invalid value for Scheduler:queue_type: '%s' (heap or deque).",
+          queue_type);
+  if (e->sched.queue_type != queue_type_heap)
+    message("Using the %s task queues", queue_type);
+  if (e->sched.queue_type == queue_type_deque && nr_queues != nr_task_threads)
+    error(
+        "The deque task queues need exactly one queue per runner "
+        "(Scheduler:nr_queues=%d, %d threads).",
+        nr_queues, nr_task_threads);
+
+  /* Do we want to weight the tasks using their measured costs? */
+  e->sched.use_measured_costs =
+      parser_get_opt_param_int(params, "Scheduler:measured_costs", 0);
+
+  /* Do we want a dedicated thread to progress the communications? */
+  e->sched.use_mpi_progress =
+      parser_get_opt_param_int(params, "Scheduler:mpi_progress_thread", 0);
+#ifndef WITH_MPI
+  if (e->sched.use_mpi_progress)
+    message("WARNING: Ignoring Scheduler:mpi_progress_thread without MPI.");
+  e->sched.use_mpi_progress = 0;
+#endif
+
+  /* Do we want to remove the implicit tasks from the dependency chains? */
+  e->sched.fuse_implicit_tasks =
+      parser_get_opt_param_int(params, "Scheduler:fuse_implicit_tasks", 1);
+
   /* Get the frequency of the dependency graph dumping */
   e->sched.frequency_dependency = parser_get_opt_param_int(
       params, "Scheduler:dependency_graph_frequency", 0);
@@ -1020,6 +1057,9 @@ void engine_config(int restart, int fof, struct engine *e,
     e->runners[k].cj_gravity_cache.count = 0;
     gravity_cache_init(&e->runners[k].ci_gravity_cache, space_splitsize);
     gravity_cache_init(&e->runners[k].cj_gravity_cache, space_splitsize);
+    e->runners[k].reuse_gravity_caches =
+        (e->policy & engine_policy_self_gravity) &&
+        e->gravity_properties->reuse_caches;
 #ifdef WITH_VECTORIZATION
     e->runners[k].ci_cache.count = 0;
     e->runners[k].cj_cache.count = 0;
@@ -1037,6 +1077,20 @@ void engine_config(int restart, int fof, struct engine *e,
     }
   }
 
+  /* Tell the scheduler where the queues are, so that they steal from the
+   * nearby ones first. */
+  int *queue_cpuid = (int *)malloc(nr_queues * sizeof(int));
+  if (queue_cpuid == NULL) error("Failed to allocate queue CPU list.");
+  for (int k = 0; k < nr_queues; k++) queue_cpuid[k] = -1;
+  if (with_aff &&
+      (e->policy & engine_policy_setaffinity) == engine_policy_setaffinity) {
+    for (int k = 0; k < e->nr_threads; k++)
+      if (queue_cpuid[e->runners[k].qid] < 0)
+        queue_cpuid[e->runners[k].qid] = e->runners[k].cpuid;
+  }
+  scheduler_init_steal_order(&e->sched, queue_cpuid, verbose);
+  free(queue_cpuid);
+
 #ifdef WITH_CSDS
   if ((e->policy & engine_policy_csds) && !restart) {
     /* Write the particle csds header */
@@ -50,6 +50,7 @@
 #include "cycle.h"
 #include "debug.h"
 #include "error.h"
+#include "gravity_interaction_list.h"
 #include "feedback.h"
 #include "neutrino_properties.h"
 #include "proxy.h"
@@ -4592,6 +4593,33 @@ void engine_make_fof_tasks(struct engine *e) {
             clocks_getunit());
 }
 
+/**
+ * @brief Constructs the cached tree walks of the gravity tasks.
+ *
+ * @param map_data The tasks.
+ * @param num_elements The number of tasks in this chunk.
+ * @param extra_data The #engine.
+ */
+static void engine_make_grav_interaction_lists_mapper(void *map_data,
+                                                      int num_elements,
+                                                      void *extra_data) {
+
+  const struct engine *e = (const struct engine *)extra_data;
+  struct task *tasks = (struct task *)map_data;
+
+  for (int ind = 0; ind < num_elements; ind++) {
+
+    struct task *t = &tasks[ind];
+
+    if (t->type == task_type_self && t->subtype == task_subtype_grav)
+      t->grav_list = gravity_interaction_list_make_self(t->ci, e);
+    else if (t->type == task_type_pair && t->subtype == task_subtype_grav)
+      t->grav_list = gravity_interaction_list_make_pair(t->ci, t->cj, e);
+    else if (t->type == task_type_grav_long_range)
+      t->grav_list = gravity_interaction_list_make_long_range(t->ci, e);
+  }
+}
+
 /**
  * @brief Fill the #space's task list.
  *
@@ -4734,6 +4762,28 @@ void engine_maketasks(struct engine *e) {
     message("Linking gravity tasks took %.3f %s.",
             clocks_from_ticks(getticks() - tic2), clocks_getunit());
 
+  /* Record the tree walks of the gravity tasks to re-use them until the
+   * next rebuild */
+  if ((e->policy & engine_policy_self_gravity) &&
+      e->gravity_properties->use_interaction_lists) {
+
+    tic2 = getticks();
+
+    threadpool_map(&e->threadpool, engine_make_grav_interaction_lists_mapper,
+                   sched->tasks, sched->nr_tasks, sizeof(struct task),
+                   threadpool_auto_chunk_size, e);
+
+    if (e->verbose) {
+      size_t mem = 0;
+      for (int k = 0; k < sched->nr_tasks; k++)
+        mem += gravity_interaction_list_memory(sched->tasks[k].grav_list);
+      message("Making gravity interaction lists took %.3f %s (memory use: "
+              "%zd MB).",
+              clocks_from_ticks(getticks() - tic2), clocks_getunit(),
+              mem / (1024 * 1024));
+    }
+  }
+
   tic2 = getticks();
 
 #ifdef WITH_MPI
@@ -4852,6 +4902,10 @@ void engine_maketasks(struct engine *e) {
     message("Setting unlocks took %.3f %s.",
             clocks_from_ticks(getticks() - tic2), clocks_getunit());
 
+  /* Shortcut the implicit tasks. */
+  if (sched->fuse_implicit_tasks)
+    scheduler_fuse_implicit_tasks(sched, e->verbose);
+
   tic2 = getticks();
 
   /* Rank the tasks. */
@@ -334,7 +334,10 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
       else if (t_type == task_type_self && t_subtype == task_subtype_grav) {
         if (ci_active_gravity) {
           scheduler_activate(s, t);
-          cell_activate_subcell_grav_tasks(t->ci, NULL, s);
+          if (t->grav_list != NULL)
+            cell_activate_grav_interaction_list(t->grav_list, s);
+          else
+            cell_activate_subcell_grav_tasks(t->ci, NULL, s);
         }
       }
 
@@ -692,7 +695,10 @@ void engine_marktasks_mapper(void *map_data, int num_elements,
 
         if (t_type == task_type_pair && t_subtype == task_subtype_grav) {
           /* Activate the gravity drift */
-          cell_activate_subcell_grav_tasks(t->ci, t->cj, s);
+          if (t->grav_list != NULL)
+            cell_activate_grav_interaction_list(t->grav_list, s);
+          else
+            cell_activate_subcell_grav_tasks(t->ci, t->cj, s);
         }
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -1702,7 +1708,7 @@ int engine_marktasks(struct engine *e) {
   /* Run through the tasks and mark as skip or not. */
   size_t extra_data[3] = {(size_t)e, (size_t)rebuild_space, (size_t)&e->sched};
   threadpool_map(&e->threadpool, engine_marktasks_mapper, s->tasks, s->nr_tasks,
-                 sizeof(struct task), threadpool_auto_chunk_size, extra_data);
+                 sizeof(struct task), threadpool_steal_chunk_size, extra_data);
   rebuild_space = extra_data[1];
 
   if (e->verbose)
@@ -243,6 +243,16 @@ INLINE static void eos_init(struct eos_parameters *e,
   e->inverse_core_density =
       1. / parser_get_param_float(params, "EoS:barotropic_core_density");
 }
+
+/**
+ * @brief Free the memory allocated for the equation of state
+ *
+ * Nothing to do here since this EoS has no tables.
+ *
+ * @param e The #eos_parameters.
+ */
+INLINE static void eos_clean(struct eos_parameters *e) {}
+
 /**
  * @brief Print the equation of state
  *
@@ -201,6 +201,15 @@ __attribute__((always_inline)) INLINE static void eos_init(
       parser_get_param_float(params, "EoS:isothermal_internal_energy");
 }
 
+/**
+ * @brief Free the memory allocated for the equation of state
+ *
+ * Nothing to do here since this EoS has no tables.
+ *
+ * @param e The #eos_parameters.
+ */
+INLINE static void eos_clean(struct eos_parameters *e) {}
+
 /**
  * @brief Print the equation of state
  *
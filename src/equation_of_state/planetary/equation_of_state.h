@@ -1449,6 +1449,103 @@ gas_soundspeed_from_internal_energy(float density, float u,
   }
 }
 
+/**
+ * @brief Returns the pressure and the sound speed given density and internal
+ * energy
+ *
+ * Equivalent to #gas_pressure_from_internal_energy and
+ * #gas_soundspeed_from_internal_energy, but the tabulated EoS look up the
+ * table only once for both.
+ *
+ * @param density The density \f$\rho\f$
+ * @param u The internal energy \f$u\f$
+ * @param P (return) The pressure \f$P\f$
+ * @param c (return) The sound speed \f$c\f$
+ */
+__attribute__((always_inline)) INLINE static void
+gas_pressure_and_soundspeed_from_internal_energy(
+    float density, float u, enum eos_planetary_material_id mat_id, float *P,
+    float *c) {
+
+  const enum eos_planetary_type_id type =
+      (enum eos_planetary_type_id)(mat_id / eos_planetary_type_factor);
+
+  /* Select the material base type */
+  switch (type) {
+
+    /* SESAME EoS */
+    case eos_planetary_type_SESAME:;
+
+      /* Select the material of this type */
+      switch (mat_id) {
+        case eos_planetary_id_SESAME_iron:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.SESAME_iron, P, c);
+          return;
+
+        case eos_planetary_id_SESAME_basalt:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.SESAME_basalt, P, c);
+          return;
+
+        case eos_planetary_id_SESAME_water:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.SESAME_water, P, c);
+          return;
+
+        case eos_planetary_id_SS08_water:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.SS08_water, P, c);
+          return;
+
+        default:
+          break;
+      };
+      break;
+
+    /* ANEOS -- using SESAME-style tables */
+    case eos_planetary_type_ANEOS:;
+
+      /* Select the material of this type */
+      switch (mat_id) {
+        case eos_planetary_id_ANEOS_forsterite:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.ANEOS_forsterite, P, c);
+          return;
+
+        case eos_planetary_id_ANEOS_iron:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.ANEOS_iron, P, c);
+          return;
+
+        case eos_planetary_id_ANEOS_Fe85Si15:
+          SESAME_pressure_and_soundspeed_from_internal_energy(
+              density, u, &eos.ANEOS_Fe85Si15, P, c);
+          return;
+
+        default:
+          break;
+      };
+      break;
+
+    /*! Generic user-provided custom tables */
+    case eos_planetary_type_custom: {
+      const int i_custom =
+          mat_id - eos_planetary_type_custom * eos_planetary_type_factor;
+      SESAME_pressure_and_soundspeed_from_internal_energy(
+          density, u, &eos.custom[i_custom], P, c);
+      return;
+    }
+
+    default:
+      break;
+  }
+
+  /* The other EoS (and the error cases) compute the two separately */
+  *P = gas_pressure_from_internal_energy(density, u, mat_id);
+  *c = gas_soundspeed_from_internal_energy(density, u, mat_id);
+}
+
 /**
  * @brief Returns the sound speed given density and pressure
  *
@@ -1655,6 +1752,10 @@ __attribute__((always_inline)) INLINE static void eos_init(
     convert_units_HM80(&e->HM80_rock, us);
   }
 
+  // SESAME-style tables are resampled on a uniform grid for fast lookups
+  const int SESAME_grid_refinement = parser_get_opt_param_int(
+      params, "EoS:planetary_SESAME_grid_refinement", 0);
+
   // SESAME
   if (parser_get_opt_param_int(params, "EoS:planetary_use_SESAME_iron", 0)) {
     char SESAME_iron_table_file[PARSER_MAX_LINE_SIZE];
@@ -1664,6 +1765,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->SESAME_iron, SESAME_iron_table_file);
     prepare_table_SESAME(&e->SESAME_iron);
     convert_units_SESAME(&e->SESAME_iron, us);
+    resample_table_SESAME(&e->SESAME_iron, SESAME_grid_refinement);
   }
   if (parser_get_opt_param_int(params, "EoS:planetary_use_SESAME_basalt", 0)) {
     char SESAME_basalt_table_file[PARSER_MAX_LINE_SIZE];
@@ -1673,6 +1775,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->SESAME_basalt, SESAME_basalt_table_file);
     prepare_table_SESAME(&e->SESAME_basalt);
     convert_units_SESAME(&e->SESAME_basalt, us);
+    resample_table_SESAME(&e->SESAME_basalt, SESAME_grid_refinement);
   }
   if (parser_get_opt_param_int(params, "EoS:planetary_use_SESAME_water", 0)) {
     char SESAME_water_table_file[PARSER_MAX_LINE_SIZE];
@@ -1682,6 +1785,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->SESAME_water, SESAME_water_table_file);
     prepare_table_SESAME(&e->SESAME_water);
     convert_units_SESAME(&e->SESAME_water, us);
+    resample_table_SESAME(&e->SESAME_water, SESAME_grid_refinement);
   }
   if (parser_get_opt_param_int(params, "EoS:planetary_use_SS08_water", 0)) {
     char SS08_water_table_file[PARSER_MAX_LINE_SIZE];
@@ -1691,6 +1795,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->SS08_water, SS08_water_table_file);
     prepare_table_SESAME(&e->SS08_water);
     convert_units_SESAME(&e->SS08_water, us);
+    resample_table_SESAME(&e->SS08_water, SESAME_grid_refinement);
   }
 
   // ANEOS -- using SESAME-style tables
@@ -1704,6 +1809,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->ANEOS_forsterite, ANEOS_forsterite_table_file);
     prepare_table_SESAME(&e->ANEOS_forsterite);
     convert_units_SESAME(&e->ANEOS_forsterite, us);
+    resample_table_SESAME(&e->ANEOS_forsterite, SESAME_grid_refinement);
   }
   if (parser_get_opt_param_int(params, "EoS:planetary_use_ANEOS_iron", 0)) {
     char ANEOS_iron_table_file[PARSER_MAX_LINE_SIZE];
@@ -1713,6 +1819,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->ANEOS_iron, ANEOS_iron_table_file);
     prepare_table_SESAME(&e->ANEOS_iron);
     convert_units_SESAME(&e->ANEOS_iron, us);
+    resample_table_SESAME(&e->ANEOS_iron, SESAME_grid_refinement);
   }
   if (parser_get_opt_param_int(params, "EoS:planetary_use_ANEOS_Fe85Si15", 0)) {
     char ANEOS_Fe85Si15_table_file[PARSER_MAX_LINE_SIZE];
@@ -1722,6 +1829,7 @@ __attribute__((always_inline)) INLINE static void eos_init(
     load_table_SESAME(&e->ANEOS_Fe85Si15, ANEOS_Fe85Si15_table_file);
     prepare_table_SESAME(&e->ANEOS_Fe85Si15);
     convert_units_SESAME(&e->ANEOS_Fe85Si15, us);
+    resample_table_SESAME(&e->ANEOS_Fe85Si15, SESAME_grid_refinement);
   }
 
   // Custom generic tables -- using SESAME-style tables
@@ -1739,10 +1847,35 @@ __attribute__((always_inline)) INLINE static void eos_init(
       load_table_SESAME(&e->custom[i_custom], custom_table_file);
       prepare_table_SESAME(&e->custom[i_custom]);
       convert_units_SESAME(&e->custom[i_custom], us);
+      resample_table_SESAME(&e->custom[i_custom], SESAME_grid_refinement);
     }
   }
 }
 
+/**
+ * @brief Free the tables of the equation of state materials
+ *
+ * @param e The #eos_parameters
+ */
+INLINE static void eos_clean(struct eos_parameters *e) {
+
+  // Hubbard & MacFarlane (1980)
+  free_table_HM80(&e->HM80_HHe);
+  free_table_HM80(&e->HM80_ice);
+  free_table_HM80(&e->HM80_rock);
+
+  // SESAME, ANEOS, and custom -- using SESAME-style tables
+  free_table_SESAME(&e->SESAME_iron);
+  free_table_SESAME(&e->SESAME_basalt);
+  free_table_SESAME(&e->SESAME_water);
+  free_table_SESAME(&e->SS08_water);
+  free_table_SESAME(&e->ANEOS_forsterite);
+  free_table_SESAME(&e->ANEOS_iron);
+  free_table_SESAME(&e->ANEOS_Fe85Si15);
+  for (int i_custom = 0; i_custom <= 9; i_custom++)
+    free_table_SESAME(&e->custom[i_custom]);
+}
+
 /**
  * @brief Print the equation of state
  *
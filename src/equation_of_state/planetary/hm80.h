@@ -144,6 +144,13 @@ INLINE static void prepare_table_HM80(struct HM80_params *mat) {
   }
 }
 
+// Free the table of a material
+INLINE static void free_table_HM80(struct HM80_params *mat) {
+
+  free(mat->table_log_P_rho_u);
+  mat->table_log_P_rho_u = NULL;
+}
+
 // Convert to internal units
 INLINE static void convert_units_HM80(struct HM80_params *mat,
                                       const struct unit_system *us) {
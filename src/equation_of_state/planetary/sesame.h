@@ -33,6 +33,7 @@
 
 /* Local headers. */
 #include "adiabatic_index.h"
+#include "align.h"
 #include "common_io.h"
 #include "equation_of_state.h"
 #include "inline.h"
@@ -50,6 +51,18 @@ struct SESAME_params {
   int version_date, num_rho, num_T;
   float u_tiny, P_tiny, c_tiny, s_tiny;
   enum eos_planetary_material_id mat_id;
+
+  // Tables of P(rho, u) and c(rho, u) resampled on a uniform grid in log(rho)
+  // and log(u): the coefficients of the bilinear interpolation of log(P)
+  // then of log(c) for each cell, or NULL to interpolate the original tables.
+  // The cells with a zero pressure corner are flagged in grid_P_direct, and
+  // their pressures are interpolated from the original tables
+  float *grid_coeffs;
+  char *grid_P_direct;
+  int grid_num_rho, grid_num_u;
+  float grid_log_rho_min, grid_log_u_min;
+  float grid_inv_log_rho_step, grid_inv_log_u_step;
+  float grid_P_min;
 };
 
 // Parameter values for each material
@@ -476,8 +489,8 @@ INLINE static float SESAME_entropy_from_internal_energy(
   return 0.f;
 }
 
-// gas_pressure_from_internal_energy
-INLINE static float SESAME_pressure_from_internal_energy(
+// gas_pressure_from_internal_energy, interpolating the original tables
+INLINE static float SESAME_pressure_from_internal_energy_direct(
     float density, float u, const struct SESAME_params *mat) {
 
   float P, P_1, P_2, P_3, P_4;
@@ -601,8 +614,8 @@ INLINE static float SESAME_internal_energy_from_pressure(
   return 0.f;
 }
 
-// gas_soundspeed_from_internal_energy
-INLINE static float SESAME_soundspeed_from_internal_energy(
+// gas_soundspeed_from_internal_energy, interpolating the original tables
+INLINE static float SESAME_soundspeed_from_internal_energy_direct(
     float density, float u, const struct SESAME_params *mat) {
 
   float c, c_1, c_2, c_3, c_4;
@@ -728,4 +741,218 @@ INLINE static float SESAME_soundspeed_from_pressure(
   return 0.f;
 }
 
+// Resample the tables of P(rho, u) and c(rho, u) on a uniform grid in log(rho)
+// and log(u), with refinement times as many points as the original tables
+//
+// The lookups in the original tables require binary searches, and in each
+// density slice since the energies depend on the density. On the uniform grid
+// the cell is found directly, and the interpolation coefficients of each cell
+// are stored together. Must be called after the conversion to internal units.
+INLINE static void resample_table_SESAME(struct SESAME_params *mat,
+                                         const int refinement) {
+
+  mat->grid_coeffs = NULL;
+  mat->grid_P_direct = NULL;
+  if (refinement <= 0) return;
+
+  // Range of the grid, matching that of the original tables
+  float log_u_min = FLT_MAX, log_u_max = -FLT_MAX;
+  for (int i = 0; i < mat->num_rho * mat->num_T; i++) {
+    log_u_min = fminf(log_u_min, mat->table_log_u_rho_T[i]);
+    log_u_max = fmaxf(log_u_max, mat->table_log_u_rho_T[i]);
+  }
+  const int num_rho = refinement * (mat->num_rho - 1) + 1;
+  const int num_u = refinement * (mat->num_T - 1) + 1;
+  const float log_rho_min = mat->table_log_rho[0];
+  const float log_rho_max = mat->table_log_rho[mat->num_rho - 1];
+  const float log_rho_step = (log_rho_max - log_rho_min) / (num_rho - 1);
+  const float log_u_step = (log_u_max - log_u_min) / (num_u - 1);
+  if (!(log_rho_step > 0.f) || !(log_u_step > 0.f))
+    error("Cannot resample the SESAME EoS table of material %d", mat->mat_id);
+
+  mat->grid_num_rho = num_rho;
+  mat->grid_num_u = num_u;
+  mat->grid_log_rho_min = log_rho_min;
+  mat->grid_log_u_min = log_u_min;
+  mat->grid_inv_log_rho_step = 1.f / log_rho_step;
+  mat->grid_inv_log_u_step = 1.f / log_u_step;
+
+  // Pressures below this value are returned as zero. log(P) cannot be
+  // interpolated across the points where the original interpolation gives
+  // zero, so the cells next to them are flagged to use the original tables
+  mat->grid_P_min = (mat->P_tiny > 0.f) ? mat->P_tiny : FLT_MIN;
+  const float log_P_zero = logf(mat->grid_P_min) - 1.f;
+  const float c_min = (mat->c_tiny > 0.f) ? mat->c_tiny : FLT_MIN;
+
+  // Values at the grid points from the original tables
+  float *log_P = (float *)malloc(num_rho * num_u * sizeof(float));
+  float *log_c = (float *)malloc(num_rho * num_u * sizeof(float));
+  if (log_P == NULL || log_c == NULL)
+    error("Failed to allocate the resampled SESAME EoS table");
+  for (int i_rho = 0; i_rho < num_rho; i_rho++) {
+    // Keep the edge densities just inside the table, where the direct
+    // interpolation does not need to extrapolate
+    const float log_rho =
+        fminf(fmaxf(log_rho_min + i_rho * log_rho_step,
+                    log_rho_min + 1e-3f * log_rho_step),
+              log_rho_max - 1e-3f * log_rho_step);
+    const float density = expf(log_rho);
+    for (int i_u = 0; i_u < num_u; i_u++) {
+      const float u = expf(log_u_min + i_u * log_u_step);
+      const float P =
+          SESAME_pressure_from_internal_energy_direct(density, u, mat);
+      const float c =
+          SESAME_soundspeed_from_internal_energy_direct(density, u, mat);
+      log_P[i_rho * num_u + i_u] = (P > 0.f) ? logf(P) : log_P_zero;
+      log_c[i_rho * num_u + i_u] = logf(fmaxf(c, c_min));
+    }
+  }
+
+  // Bilinear coefficients f = f_0 + f_rho x + f_u y + f_rho_u x y of log(P)
+  // then log(c) for each cell, with x, y the position in the cell
+  const int num_cells = (num_rho - 1) * (num_u - 1);
+  if (posix_memalign((void **)&mat->grid_coeffs, SWIFT_CACHE_ALIGNMENT,
+                     8 * num_cells * sizeof(float)) != 0)
+    error("Failed to allocate the resampled SESAME EoS table");
+  mat->grid_P_direct = (char *)malloc(num_cells * sizeof(char));
+  if (mat->grid_P_direct == NULL)
+    error("Failed to allocate the resampled SESAME EoS table");
+  for (int i_rho = 0; i_rho < num_rho - 1; i_rho++) {
+    for (int i_u = 0; i_u < num_u - 1; i_u++) {
+      const int cell = i_rho * (num_u - 1) + i_u;
+      float *coeffs = mat->grid_coeffs + 8 * cell;
+      mat->grid_P_direct[cell] =
+          (log_P[i_rho * num_u + i_u] == log_P_zero) ||
+          (log_P[i_rho * num_u + i_u + 1] == log_P_zero) ||
+          (log_P[(i_rho + 1) * num_u + i_u] == log_P_zero) ||
+          (log_P[(i_rho + 1) * num_u + i_u + 1] == log_P_zero);
+      const float *tables[2] = {log_P, log_c};
+      for (int k = 0; k < 2; k++) {
+        const float f_00 = tables[k][i_rho * num_u + i_u];
+        const float f_01 = tables[k][i_rho * num_u + i_u + 1];
+        const float f_10 = tables[k][(i_rho + 1) * num_u + i_u];
+        const float f_11 = tables[k][(i_rho + 1) * num_u + i_u + 1];
+        coeffs[4 * k + 0] = f_00;
+        coeffs[4 * k + 1] = f_10 - f_00;
+        coeffs[4 * k + 2] = f_01 - f_00;
+        coeffs[4 * k + 3] = f_11 - f_10 - f_01 + f_00;
+      }
+    }
+  }
+
+  free(log_P);
+  free(log_c);
+}
+
+// Free the tables of a material
+INLINE static void free_table_SESAME(struct SESAME_params *mat) {
+
+  free(mat->table_log_rho);
+  free(mat->table_log_u_rho_T);
+  free(mat->table_P_rho_T);
+  free(mat->table_c_rho_T);
+  free(mat->table_log_s_rho_T);
+  free(mat->grid_coeffs);
+  free(mat->grid_P_direct);
+  mat->table_log_rho = NULL;
+  mat->table_log_u_rho_T = NULL;
+  mat->table_P_rho_T = NULL;
+  mat->table_c_rho_T = NULL;
+  mat->table_log_s_rho_T = NULL;
+  mat->grid_coeffs = NULL;
+  mat->grid_P_direct = NULL;
+}
+
+// Find the index of the cell of the resampled grid containing (log(rho),
+// log(u)) and the position in it. Outside of the grid, the edge cells are
+// extrapolated in density, while the edge values are used in internal energy.
+__attribute__((always_inline)) INLINE static int SESAME_grid_cell(
+    const struct SESAME_params *mat, const float log_rho, const float log_u,
+    float *x, float *y) {
+
+  const float pos_rho =
+      (log_rho - mat->grid_log_rho_min) * mat->grid_inv_log_rho_step;
+  const float pos_u = (log_u - mat->grid_log_u_min) * mat->grid_inv_log_u_step;
+  const int i_rho =
+      (int)fminf(fmaxf(pos_rho, 0.f), (float)(mat->grid_num_rho - 2));
+  const int i_u = (int)fminf(fmaxf(pos_u, 0.f), (float)(mat->grid_num_u - 2));
+
+  *x = pos_rho - i_rho;
+  *y = fminf(fmaxf(pos_u - i_u, 0.f), 1.f);
+  return i_rho * (mat->grid_num_u - 1) + i_u;
+}
+
+// gas_pressure_from_internal_energy
+__attribute__((always_inline)) INLINE static float
+SESAME_pressure_from_internal_energy(float density, float u,
+                                     const struct SESAME_params *mat) {
+
+  if (u <= 0.f) {
+    return 0.f;
+  }
+  if (mat->grid_coeffs == NULL) {
+    return SESAME_pressure_from_internal_energy_direct(density, u, mat);
+  }
+
+  float x, y;
+  const int cell = SESAME_grid_cell(mat, logf(density), logf(u), &x, &y);
+  if (mat->grid_P_direct[cell]) {
+    return SESAME_pressure_from_internal_energy_direct(density, u, mat);
+  }
+  const float *coeffs = mat->grid_coeffs + 8 * cell;
+  const float P =
+      expf(coeffs[0] + coeffs[1] * x + (coeffs[2] + coeffs[3] * x) * y);
+
+  return (P > mat->grid_P_min) ? P : 0.f;
+}
+
+// gas_soundspeed_from_internal_energy
+__attribute__((always_inline)) INLINE static float
+SESAME_soundspeed_from_internal_energy(float density, float u,
+                                       const struct SESAME_params *mat) {
+
+  if (u <= 0.f) {
+    return 0.f;
+  }
+  if (mat->grid_coeffs == NULL) {
+    return SESAME_soundspeed_from_internal_energy_direct(density, u, mat);
+  }
+
+  float x, y;
+  const int cell = SESAME_grid_cell(mat, logf(density), logf(u), &x, &y);
+  const float *coeffs = mat->grid_coeffs + 8 * cell;
+
+  return expf(coeffs[4] + coeffs[5] * x + (coeffs[6] + coeffs[7] * x) * y);
+}
+
+// Pressure and sound speed together, sharing the lookup of the grid cell
+__attribute__((always_inline)) INLINE static void
+SESAME_pressure_and_soundspeed_from_internal_energy(
+    float density, float u, const struct SESAME_params *mat, float *P,
+    float *c) {
+
+  if (u <= 0.f) {
+    *P = 0.f;
+    *c = 0.f;
+    return;
+  }
+  if (mat->grid_coeffs == NULL) {
+    *P = SESAME_pressure_from_internal_energy_direct(density, u, mat);
+    *c = SESAME_soundspeed_from_internal_energy_direct(density, u, mat);
+    return;
+  }
+
+  float x, y;
+  const int cell = SESAME_grid_cell(mat, logf(density), logf(u), &x, &y);
+  const float *coeffs = mat->grid_coeffs + 8 * cell;
+  if (mat->grid_P_direct[cell]) {
+    *P = SESAME_pressure_from_internal_energy_direct(density, u, mat);
+  } else {
+    const float P_grid =
+        expf(coeffs[0] + coeffs[1] * x + (coeffs[2] + coeffs[3] * x) * y);
+    *P = (P_grid > mat->grid_P_min) ? P_grid : 0.f;
+  }
+  *c = expf(coeffs[4] + coeffs[5] * x + (coeffs[6] + coeffs[7] * x) * y);
+}
+
 #endif /* SWIFT_SESAME_EQUATION_OF_STATE_H */
@@ -2638,7 +2638,7 @@ void fof_calc_group_mass(struct fof_props *props, const struct space *s,
 
   /* Increment the group mass for groups above min_group_size. */
   threadpool_map(&s->e->threadpool, fof_calc_group_mass_mapper, gparts,
-                 nr_gparts, sizeof(struct gpart), threadpool_auto_chunk_size,
+                 nr_gparts, sizeof(struct gpart), threadpool_steal_chunk_size,
                  (struct space *)s);
 
   /* Direct pointers to the arrays */
@@ -65,6 +65,25 @@ void cell_write_ghost_stats(FILE *f, const struct cell *c,
   }
 }
 
+/**
+ * @brief Add the number of gas particles processed during each iteration of
+ * the ghost in the given cell and its progeny to the given totals.
+ *
+ * @param c Cell to add.
+ * @param counts Totals per iteration (#SWIFT_GHOST_STATS + 1 values).
+ */
+void cell_sum_ghost_stats_hydro(const struct cell *c, long long *counts) {
+  if (c == NULL) return;
+
+  for (int b = 0; b < SWIFT_GHOST_STATS + 1; ++b)
+    counts[b] += c->ghost_statistics.hydro[b].count;
+
+  /* Add children */
+  for (int i = 0; i < 8; i++) {
+    cell_sum_ghost_stats_hydro(c->progeny[i], counts);
+  }
+}
+
 /**
  * @brief Reset the ghost histograms for all top level cells in the space.
  *
@@ -85,6 +104,11 @@ void space_reset_ghost_histograms(struct space *s) {
  * where the first counter is an argument to this function (intended to be the
  * step counter), and the second counter is the rank that does the write.
  *
+ * The header ends with the number of gas particles processed during each
+ * iteration summed over all the cells of the rank, i.e. the distribution of
+ * the number of iterations the smoothing lengths needed to converge during
+ * the step.
+ *
  * @param s Space.
  * @param j First counter in the output file name.
  */
@@ -98,6 +122,18 @@ void space_write_ghost_stats(const struct space *s, int j) {
   /* Write header */
   ghost_stats_write_header(f);
 
+  /* Write the totals over all the cells of this rank */
+  long long counts[SWIFT_GHOST_STATS + 1] = {0};
+  for (int i = 0; i < s->nr_cells; i++) {
+    struct cell *c = &s->cells_top[i];
+    if (c->nodeID == engine_rank) cell_sum_ghost_stats_hydro(c, counts);
+  }
+  fprintf(f, "# Total hydro count per block:");
+  for (int b = 0; b < SWIFT_GHOST_STATS + 1; ++b) {
+    fprintf(f, "\t%lld", counts[b]);
+  }
+  fprintf(f, "\n");
+
   /* Write all the top level cells (and their children) */
   for (int i = 0; i < s->nr_cells; i++) {
     struct cell *c = &s->cells_top[i];
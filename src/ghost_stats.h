@@ -419,6 +419,7 @@ struct cell;
 void cell_reset_ghost_histograms(struct cell *c);
 void cell_write_ghost_stats(FILE *f, const struct cell *c,
                             const long long cellID);
+void cell_sum_ghost_stats_hydro(const struct cell *c, long long *counts);
 /*******************
  * space interface *
  *******************/
@@ -72,6 +72,15 @@ struct gravity_cache {
 
   /*! Cache size */
   int count;
+
+  /*! #cell whose #gpart are in the cache (NULL if it cannot be re-used) */
+  const struct cell *cell;
+
+  /*! Number of #gpart of that #cell in the cache */
+  int cell_count;
+
+  /*! Time of the last drift of the #gpart in the cache */
+  integertime_t ti_old_part;
 };
 
 /**
@@ -95,6 +104,48 @@ static INLINE void gravity_cache_clean(struct gravity_cache *c) {
     swift_free("gravity_cache", c->use_mpole);
   }
   c->count = 0;
+  c->cell = NULL;
+}
+
+/**
+ * @brief Forget which #cell the content of a #gravity_cache belongs to.
+ *
+ * When the runner re-uses its caches, a #cell is recognised by its address,
+ * its #gpart count and the time its #gpart were last drifted (ti_old_part).
+ * Any code that changes the #gpart of a #cell (positions, masses, softening,
+ * time-bins, ...) without advancing ti_old_part must therefore call this on
+ * the caches of all the runners that may hold them. This is done at the start
+ * of every engine launch, as rebuilds and time-steps happen in between.
+ *
+ * @param c The #gravity_cache.
+ */
+static INLINE void gravity_cache_invalidate(struct gravity_cache *c) {
+  c->cell = NULL;
+}
+
+/**
+ * @brief Record which #cell the content of a #gravity_cache belongs to.
+ *
+ * @param c The #gravity_cache.
+ * @param cell The #cell whose (unshifted) #gpart were just copied in.
+ */
+static INLINE void gravity_cache_set_cell(struct gravity_cache *c,
+                                          const struct cell *cell) {
+  c->cell = cell;
+  c->cell_count = cell->grav.count;
+  c->ti_old_part = cell->grav.ti_old_part;
+}
+
+/**
+ * @brief Does a #gravity_cache still hold the #gpart of a given #cell?
+ *
+ * @param c The #gravity_cache.
+ * @param cell The #cell.
+ */
+static INLINE int gravity_cache_holds_cell(const struct gravity_cache *c,
+                                           const struct cell *cell) {
+  return c->cell == cell && c->cell_count == cell->grav.count &&
+         c->ti_old_part == cell->grav.ti_old_part;
 }
 
 /**
@@ -145,6 +196,7 @@ static INLINE void gravity_cache_init(struct gravity_cache *c,
   if (e != 0) error("Couldn't allocate gravity cache, size: %d", padded_count);
 
   c->count = padded_count;
+  c->cell = NULL;
 }
 
 /**
@@ -211,6 +263,9 @@ INLINE static void gravity_cache_populate(
     error("Padded gravity cache size invalid. Not a multiple of SIMD length.");
 #endif
 
+  /* The content will not match any cell anymore */
+  gravity_cache_invalidate(c);
+
   /* Do we need to grow the cache? */
   if (c->count < gcount_padded) gravity_cache_init(c, gcount_padded + VEC_SIZE);
 
@@ -320,6 +375,9 @@ INLINE static void gravity_cache_populate_no_mpole(
     error("Padded gravity cache size invalid. Not a multiple of SIMD length.");
 #endif
 
+  /* The content will not match any cell anymore */
+  gravity_cache_invalidate(c);
+
   /* Do we need to grow the cache? */
   if (c->count < gcount_padded) gravity_cache_init(c, gcount_padded + VEC_SIZE);
 
@@ -410,6 +468,9 @@ INLINE static void gravity_cache_populate_all_mpole(
     error("Padded gravity cache size invalid. Not a multiple of SIMD length.");
 #endif
 
+  /* The content will not match any cell anymore */
+  gravity_cache_invalidate(c);
+
   /* Do we need to grow the cache? */
   if (c->count < gcount_padded) gravity_cache_init(c, gcount_padded + VEC_SIZE);
 
@@ -479,6 +540,79 @@ INLINE static void gravity_cache_populate_all_mpole(
   gravity_cache_zero_output(c, gcount_padded);
 }
 
+/**
+ * @brief Re-use the #gpart already in a #gravity_cache for a new interaction.
+ *
+ * Only the M2P flags, which depend on the multipole of the other cell, are
+ * re-computed and the output fields are zeroed. The cache must have been
+ * filled by gravity_cache_populate() without shift.
+ *
+ * @param allow_mpole Are we allowing the use of multipoles?
+ * @param periodic Are we using periodic BCs ?
+ * @param dim The size of the simulation volume along each dimension.
+ * @param c The #gravity_cache to update.
+ * @param gparts The #gpart array in the cache.
+ * @param gcount The number of particles in the cache.
+ * @param gcount_padded The number of particle in the cache padded to the next
+ * multiple of the vector length.
+ * @param CoM The position of the multipole.
+ * @param multipole The mulipole to check for.
+ * @param grav_props The global gravity properties.
+ */
+INLINE static void gravity_cache_update_mpole(
+    const int allow_mpole, const int periodic, const float dim[3],
+    struct gravity_cache *c, const struct gpart *restrict gparts,
+    const int gcount, const int gcount_padded, const float CoM[3],
+    const struct gravity_tensors *multipole,
+    const struct gravity_props *grav_props) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (c->count < gcount_padded) error("Re-using a cache that is too small.");
+#endif
+
+  /* Make the compiler understand we are in happy vectorization land */
+  swift_declare_aligned_ptr(float, x, c->x, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(float, y, c->y, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(float, z, c->z, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(int, use_mpole, c->use_mpole,
+                            SWIFT_CACHE_ALIGNMENT);
+  swift_assume_size(gcount_padded, VEC_SIZE);
+
+  if (allow_mpole) {
+
+#if !defined(SWIFT_DEBUG_CHECKS) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+    for (int i = 0; i < gcount; ++i) {
+
+      /* Distance to the CoM of the other cell. */
+      float dx = x[i] - CoM[0];
+      float dy = y[i] - CoM[1];
+      float dz = z[i] - CoM[2];
+
+      /* Apply periodic BC */
+      if (periodic) {
+        dx = nearestf(dx, dim[0]);
+        dy = nearestf(dy, dim[1]);
+        dz = nearestf(dz, dim[2]);
+      }
+      const float r2 = dx * dx + dy * dy + dz * dz;
+
+      /* Check whether we can use the multipole instead of P-P */
+      use_mpole[i] =
+          gravity_M2P_accept(grav_props, &gparts[i], multipole, r2, periodic);
+    }
+  } else {
+    bzero(use_mpole, gcount * sizeof(int));
+  }
+
+  /* The padded particles never use the multipole */
+  for (int i = gcount; i < gcount_padded; ++i) use_mpole[i] = 0;
+
+  /* Zero the output as well */
+  gravity_cache_zero_output(c, gcount_padded);
+}
+
 /**
  * @brief Write the output cache values back to the active #gpart.
  *
@@ -0,0 +1,441 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Some standard headers. */
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+/* This object's header. */
+#include "gravity_interaction_list.h"
+
+/* Local headers. */
+#include "cell.h"
+#include "engine.h"
+#include "error.h"
+#include "multipole.h"
+#include "multipole_accept.h"
+#include "periodic.h"
+#include "space.h"
+
+/**
+ * @brief Allocate a new empty #gravity_interaction_list.
+ */
+static struct gravity_interaction_list *gravity_interaction_list_new(void) {
+
+  struct gravity_interaction_list *list =
+      (struct gravity_interaction_list *)malloc(
+          sizeof(struct gravity_interaction_list));
+  if (list == NULL) error("Failed to allocate gravity interaction list.");
+
+  list->entries = NULL;
+  list->count = 0;
+  list->size = 0;
+  list->has_out_of_range = 0;
+
+  return list;
+}
+
+/**
+ * @brief Append an entry to a #gravity_interaction_list.
+ *
+ * The entry is created without any sub-walk.
+ *
+ * @param list The #gravity_interaction_list.
+ * @param ci The first #cell.
+ * @param cj The second #cell (NULL for self interactions).
+ * @param type The #gravity_interaction_type of the entry.
+ *
+ * @return The index of the new entry.
+ */
+static int gravity_interaction_list_append(
+    struct gravity_interaction_list *list, struct cell *ci, struct cell *cj,
+    const enum gravity_interaction_type type) {
+
+  /* Grow the list if needed */
+  if (list->count == list->size) {
+    list->size = list->size > 0 ? 2 * list->size : 16;
+    list->entries = (struct gravity_interaction *)realloc(
+        list->entries, list->size * sizeof(struct gravity_interaction));
+    if (list->entries == NULL)
+      error("Failed to grow gravity interaction list.");
+  }
+
+  const int ind = list->count++;
+  list->entries[ind].ci = ci;
+  list->entries[ind].cj = cj;
+  list->entries[ind].next = ind + 1;
+  list->entries[ind].type = type;
+  list->entries[ind].max_drift = 0.f;
+
+  return ind;
+}
+
+/**
+ * @brief Shrink the memory of a #gravity_interaction_list to its content.
+ *
+ * @param list The #gravity_interaction_list.
+ */
+static void gravity_interaction_list_trim(
+    struct gravity_interaction_list *list) {
+
+  if (list->count == list->size) return;
+
+  if (list->count == 0) {
+    free(list->entries);
+    list->entries = NULL;
+  } else {
+    list->entries = (struct gravity_interaction *)realloc(
+        list->entries, list->count * sizeof(struct gravity_interaction));
+    if (list->entries == NULL)
+      error("Failed to shrink gravity interaction list.");
+  }
+  list->size = list->count;
+}
+
+/**
+ * @brief Compute how far the particles of a pair of cells can move before a
+ * P-P or split decision of the tree walk may change.
+ *
+ * The cells can only be taken out of range or be accepted by the MAC if
+ * their distance grows, which it can do by at most the displacement of their
+ * particles. The largest displacement for which the MAC still fails is found
+ * by bisection, rounding down.
+ *
+ * @param props The #gravity_props.
+ * @param multi_i The #gravity_tensors of the first cell.
+ * @param multi_j The #gravity_tensors of the second cell.
+ * @param r The distance between the CoMs at the last rebuild.
+ * @param r_lr_check The minimal distance between the particles of the cells.
+ * @param max_distance The distance beyond which the truncated forces are 0.
+ * @param periodic Are we using periodic BCs?
+ * @param check_mac Did the decision depend on the MAC?
+ */
+static float gravity_interaction_list_max_drift(
+    const struct gravity_props *props,
+    const struct gravity_tensors *multi_i,
+    const struct gravity_tensors *multi_j, const double r,
+    const double r_lr_check, const double max_distance, const int periodic,
+    const int check_mac) {
+
+  /* Displacement taking the cells beyond the truncation radius */
+  const double max_drift_lr = periodic ? max_distance - r_lr_check : FLT_MAX;
+  if (!check_mac) return max_drift_lr;
+
+  /* Never trust the decision for a displacement larger than the distance */
+  const double max_drift = min(r, max_drift_lr);
+  const double r_max = r + max_drift;
+  if (!gravity_M2L_accept_symmetric(props, multi_i, multi_j, r_max * r_max,
+                                    /*use_rebuild_sizes=*/1, periodic))
+    return max_drift;
+
+  double lo = 0., hi = max_drift;
+  for (int k = 0; k < 8; k++) {
+    const double mid = 0.5 * (lo + hi);
+    const double r_mid = r + mid;
+    if (gravity_M2L_accept_symmetric(props, multi_i, multi_j, r_mid * r_mid,
+                                     /*use_rebuild_sizes=*/1, periodic))
+      hi = mid;
+    else
+      lo = mid;
+  }
+
+  return lo;
+}
+
+/**
+ * @brief Record the tree walk of runner_dopair_recursive_grav() for a pair
+ * of cells.
+ *
+ * The decisions are taken with the rebuild positions and sizes of the
+ * multipoles. The M-M and out-of-range entries are checked again when the
+ * list is replayed. The other entries record the displacement of the
+ * particles up to which they remain valid.
+ *
+ * @param list The #gravity_interaction_list to append to.
+ * @param ci The first #cell.
+ * @param cj The second #cell.
+ * @param e The #engine.
+ */
+static void gravity_interaction_list_add_pair(
+    struct gravity_interaction_list *list, struct cell *ci, struct cell *cj,
+    const struct engine *e) {
+
+  /* Some constants */
+  const struct gravity_props *props = e->gravity_properties;
+  const int periodic = e->mesh->periodic;
+  const double dim[3] = {e->mesh->dim[0], e->mesh->dim[1], e->mesh->dim[2]};
+  const double max_distance = e->mesh->r_cut_max;
+
+  /* Recover the multipole information */
+  const struct gravity_tensors *const multi_i = ci->grav.multipole;
+  const struct gravity_tensors *const multi_j = cj->grav.multipole;
+
+  /* Get the distance between the CoMs at the last rebuild */
+  double dx = multi_i->CoM_rebuild[0] - multi_j->CoM_rebuild[0];
+  double dy = multi_i->CoM_rebuild[1] - multi_j->CoM_rebuild[1];
+  double dz = multi_i->CoM_rebuild[2] - multi_j->CoM_rebuild[2];
+
+  /* Apply BC */
+  if (periodic) {
+    dx = nearest(dx, dim[0]);
+    dy = nearest(dy, dim[1]);
+    dz = nearest(dz, dim[2]);
+  }
+  const double r2 = dx * dx + dy * dy + dz * dz;
+  const double r = sqrt(r2);
+
+  /* Minimal distance between any 2 particles in the two cells */
+  const double r_lr_check =
+      r - (multi_i->r_max_rebuild + multi_j->r_max_rebuild);
+
+  /* Same sequence of tests as in the tree walk */
+  if (periodic && r_lr_check > max_distance) {
+
+    gravity_interaction_list_append(list, ci, cj,
+                                    gravity_interaction_pair_out_of_range);
+
+  } else if (ci->grav.count <= 1 || cj->grav.count <= 1) {
+
+    const int ind = gravity_interaction_list_append(
+        list, ci, cj, gravity_interaction_pair_pp_no_cache);
+    list->entries[ind].max_drift = gravity_interaction_list_max_drift(
+        props, multi_i, multi_j, r, r_lr_check, max_distance, periodic,
+        /*check_mac=*/0);
+
+  } else if (gravity_M2L_accept_symmetric(props, multi_i, multi_j, r2,
+                                          /*use_rebuild_sizes=*/1,
+                                          periodic)) {
+
+    gravity_interaction_list_append(list, ci, cj,
+                                    gravity_interaction_pair_mm);
+
+  } else if (!ci->split && !cj->split) {
+
+    const int ind = gravity_interaction_list_append(
+        list, ci, cj, gravity_interaction_pair_pp);
+    list->entries[ind].max_drift = gravity_interaction_list_max_drift(
+        props, multi_i, multi_j, r, r_lr_check, max_distance, periodic,
+        /*check_mac=*/1);
+
+  } else {
+
+    const int ind = gravity_interaction_list_append(
+        list, ci, cj, gravity_interaction_pair_split);
+    list->entries[ind].max_drift = gravity_interaction_list_max_drift(
+        props, multi_i, multi_j, r, r_lr_check, max_distance, periodic,
+        /*check_mac=*/1);
+
+    /* Split the larger of the two cells, if possible */
+    const int split_i =
+        (multi_i->r_max_rebuild > multi_j->r_max_rebuild && ci->split) ||
+        !cj->split;
+
+    if (split_i) {
+      for (int k = 0; k < 8; k++)
+        if (ci->progeny[k] != NULL)
+          gravity_interaction_list_add_pair(list, ci->progeny[k], cj, e);
+    } else {
+      for (int k = 0; k < 8; k++)
+        if (cj->progeny[k] != NULL)
+          gravity_interaction_list_add_pair(list, ci, cj->progeny[k], e);
+    }
+
+    list->entries[ind].next = list->count;
+  }
+}
+
+/**
+ * @brief Record the tree walk of runner_doself_recursive_grav() for a cell.
+ *
+ * @param list The #gravity_interaction_list to append to.
+ * @param c The #cell.
+ * @param e The #engine.
+ */
+static void gravity_interaction_list_add_self(
+    struct gravity_interaction_list *list, struct cell *c,
+    const struct engine *e) {
+
+  if (!c->split) {
+    gravity_interaction_list_append(list, c, NULL,
+                                    gravity_interaction_self_pp);
+    return;
+  }
+
+  const int ind = gravity_interaction_list_append(
+      list, c, NULL, gravity_interaction_self_split);
+
+  /* Interact each progeny with itself and with each of its siblings */
+  for (int j = 0; j < 8; j++) {
+    if (c->progeny[j] != NULL) {
+
+      gravity_interaction_list_add_self(list, c->progeny[j], e);
+
+      for (int k = j + 1; k < 8; k++)
+        if (c->progeny[k] != NULL)
+          gravity_interaction_list_add_pair(list, c->progeny[j],
+                                            c->progeny[k], e);
+    }
+  }
+
+  list->entries[ind].next = list->count;
+}
+
+/**
+ * @brief Construct the #gravity_interaction_list of a self-gravity task.
+ *
+ * @param c The #cell of the task.
+ * @param e The #engine.
+ */
+struct gravity_interaction_list *gravity_interaction_list_make_self(
+    struct cell *c, const struct engine *e) {
+
+  struct gravity_interaction_list *list = gravity_interaction_list_new();
+  gravity_interaction_list_add_self(list, c, e);
+  gravity_interaction_list_trim(list);
+  return list;
+}
+
+/**
+ * @brief Construct the #gravity_interaction_list of a pair-gravity task.
+ *
+ * @param ci The first #cell of the task.
+ * @param cj The second #cell of the task.
+ * @param e The #engine.
+ */
+struct gravity_interaction_list *gravity_interaction_list_make_pair(
+    struct cell *ci, struct cell *cj, const struct engine *e) {
+
+  struct gravity_interaction_list *list = gravity_interaction_list_new();
+  gravity_interaction_list_add_pair(list, ci, cj, e);
+  gravity_interaction_list_trim(list);
+  return list;
+}
+
+/**
+ * @brief Construct the #gravity_interaction_list of a long-range task.
+ *
+ * The long-range interactions are decided with the rebuild data of the
+ * top-level multipoles, so the list contains exactly the top-level cells
+ * runner_do_grav_long_range() would pick. The cells beyond the truncation
+ * radius are only listed when the interaction counters need them.
+ *
+ * @param ci The #cell of the task.
+ * @param e The #engine.
+ */
+struct gravity_interaction_list *gravity_interaction_list_make_long_range(
+    struct cell *ci, const struct engine *e) {
+
+  /* Some constants */
+  const struct space *s = e->s;
+  const int periodic = e->mesh->periodic;
+  const double dim[3] = {e->mesh->dim[0], e->mesh->dim[1], e->mesh->dim[2]};
+  const double max_distance2 = e->mesh->r_cut_max * e->mesh->r_cut_max;
+
+  /* Recover the list of top-level cells. Note that the list of cells with
+   * particles is only updated after the tasks have been constructed. */
+  struct cell *cells = s->cells_top;
+  const int nr_cells = s->nr_cells;
+
+  /* Find this cell's top-level (great-)parent */
+  struct cell *top = ci;
+  while (top->parent != NULL) top = top->parent;
+
+  struct gravity_interaction_list *list = gravity_interaction_list_new();
+
+  for (int n = 0; n < nr_cells; ++n) {
+
+    struct cell *cj = &cells[n];
+
+    /* Avoid self contributions */
+    if (top == cj) continue;
+
+    /* Skip the cells space_list_useful_top_level_cells() will not list */
+    if (cell_is_empty(cj) && !(cj->grav.multipole != NULL &&
+                               cj->grav.multipole->m_pole.M_000 > 0.f))
+      continue;
+
+    /* Beyond the distance where the truncated forces are 0 ? */
+    if (periodic &&
+        cell_min_dist2_same_size(top, cj, periodic, dim) > max_distance2) {
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+      gravity_interaction_list_append(list, ci, cj,
+                                      gravity_interaction_pair_out_of_range);
+#else
+      if (cj->grav.multipole->m_pole.M_000 != 0.f) list->has_out_of_range = 1;
+#endif
+      continue;
+    }
+
+    if (cell_can_use_pair_mm(top, cj, e, s, /*use_rebuild_data=*/1,
+                             /*is_tree_walk=*/0))
+      gravity_interaction_list_append(list, ci, cj,
+                                      gravity_interaction_pair_mm);
+  }
+
+  gravity_interaction_list_trim(list);
+  return list;
+}
+
+/**
+ * @brief Can the decision recorded in a pair entry still be used?
+ *
+ * The multipoles of the two cells must have been drifted to the current
+ * time. The decision holds as long as the particles of the two cells have
+ * not moved further than the entry allows since the last rebuild.
+ *
+ * @param in The #gravity_interaction (pair split, P-P or P-P no-cache).
+ */
+int gravity_interaction_list_entry_is_valid(
+    const struct gravity_interaction *in) {
+
+  const double drift =
+      gravity_multipole_max_displacement(in->ci->grav.multipole) +
+      gravity_multipole_max_displacement(in->cj->grav.multipole);
+
+  return drift <= in->max_drift;
+}
+
+/**
+ * @brief Free a #gravity_interaction_list.
+ *
+ * @param list The #gravity_interaction_list (can be NULL).
+ */
+void gravity_interaction_list_free(struct gravity_interaction_list *list) {
+
+  if (list == NULL) return;
+  free(list->entries);
+  free(list);
+}
+
+/**
+ * @brief Memory used by a #gravity_interaction_list in bytes.
+ *
+ * @param list The #gravity_interaction_list (can be NULL).
+ */
+size_t gravity_interaction_list_memory(
+    const struct gravity_interaction_list *list) {
+
+  if (list == NULL) return 0;
+  return sizeof(struct gravity_interaction_list) +
+         list->size * sizeof(struct gravity_interaction);
+}
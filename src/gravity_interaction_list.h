@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_GRAVITY_INTERACTION_LIST_H
+#define SWIFT_GRAVITY_INTERACTION_LIST_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Includes. */
+#include <stddef.h>
+
+/* Avoid cyclic inclusions */
+struct cell;
+struct engine;
+
+/**
+ * @brief The decisions taken by the gravity tree walk for a pair of cells.
+ */
+enum gravity_interaction_type {
+  gravity_interaction_self_split,    /* Recurse into the progenies of ci */
+  gravity_interaction_self_pp,       /* P-P interactions within a leaf */
+  gravity_interaction_pair_split,    /* Recurse into one of the two cells */
+  gravity_interaction_pair_mm,       /* M-M candidate (checked at replay) */
+  gravity_interaction_pair_pp,       /* P-P interactions between two leaves */
+  gravity_interaction_pair_pp_no_cache, /* P-P between two tiny cells */
+  gravity_interaction_pair_out_of_range, /* Beyond the truncation radius */
+};
+
+/**
+ * @brief One node of the tree walk of a gravity task.
+ */
+struct gravity_interaction {
+
+  /*! The first #cell of the interaction. */
+  struct cell *ci;
+
+  /*! The second #cell of the interaction (NULL for self interactions). */
+  struct cell *cj;
+
+  /*! Index of the first entry that is not in this entry's sub-walk. */
+  int next;
+
+  /*! The #gravity_interaction_type of this node. */
+  int type;
+
+  /*! Total displacement of the particles of ci and cj since the rebuild
+   * beyond which the decision of this node may not hold anymore. */
+  float max_drift;
+};
+
+/**
+ * @brief The flattened tree walk of a gravity task.
+ *
+ * The list is built when the tasks are constructed, using the rebuild
+ * positions and sizes of the multipoles. Each pair entry records how far the
+ * particles can move before its decision has to be taken again. The entries
+ * are stored in the order of a depth-first walk such that the sub-walk of an
+ * entry can be skipped by jumping to its next index.
+ */
+struct gravity_interaction_list {
+
+  /*! The entries of the walk. */
+  struct gravity_interaction *entries;
+
+  /*! Number of entries in use. */
+  int count;
+
+  /*! Number of entries allocated. */
+  int size;
+
+  /*! Did the walk skip any (non-empty) cell beyond the truncation radius? */
+  int has_out_of_range;
+};
+
+struct gravity_interaction_list *gravity_interaction_list_make_self(
+    struct cell *c, const struct engine *e);
+struct gravity_interaction_list *gravity_interaction_list_make_pair(
+    struct cell *ci, struct cell *cj, const struct engine *e);
+struct gravity_interaction_list *gravity_interaction_list_make_long_range(
+    struct cell *ci, const struct engine *e);
+int gravity_interaction_list_entry_is_valid(
+    const struct gravity_interaction *in);
+void gravity_interaction_list_free(struct gravity_interaction_list *list);
+size_t gravity_interaction_list_memory(
+    const struct gravity_interaction_list *list);
+
+#endif /* SWIFT_GRAVITY_INTERACTION_LIST_H */
@@ -160,6 +160,13 @@ void gravity_props_init(struct gravity_props *p, struct swift_params *params,
   p->use_tree_below_softening =
       parser_get_opt_param_int(params, "Gravity:use_tree_below_softening", 0);
 
+  /* Are we caching the tree walks between rebuilds? */
+  p->use_interaction_lists =
+      parser_get_opt_param_int(params, "Gravity:use_interaction_lists", 0);
+
+  /* Are consecutive P-P pairs allowed to re-use the gravity caches? */
+  p->reuse_caches = parser_get_opt_param_int(params, "Gravity:reuse_caches", 1);
+
 #ifdef GADGET2_SOFTENING_CORRECTION
   if (p->use_tree_below_softening)
     error(
@@ -327,6 +334,12 @@ void gravity_props_print(const struct gravity_props *p) {
     message("Self-gravity opening angle:  theta_cr=%.4f", p->theta_crit);
   }
 
+  if (p->use_interaction_lists)
+    message("Self-gravity interaction lists re-used between rebuilds");
+
+  if (p->reuse_caches)
+    message("Self-gravity P-P caches re-used between consecutive pairs");
+
   message("Self-gravity softening functional form: %s",
           kernel_gravity_softening_name);
 
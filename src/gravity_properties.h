@@ -82,6 +82,12 @@ struct gravity_props {
   /*! Are we applying long-range truncation to the forces in the MAC? */
   int consider_truncation_in_MAC;
 
+  /*! Are we re-using the tree walks of the gravity tasks between rebuilds? */
+  int use_interaction_lists;
+
+  /*! Can consecutive P-P pairs sharing a cell re-use the gravity caches? */
+  int reuse_caches;
+
   /* ------------- Properties of the softened gravity ------------------ */
 
   /*! Co-moving softening length for for high-res. DM particles */
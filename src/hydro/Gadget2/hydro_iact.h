@@ -34,6 +34,7 @@
 
 #include "adaptive_softening_iact.h"
 #include "cache.h"
+#include "hydro_iact_density_vec.h"
 #include "hydro_parameters.h"
 #include "minmax.h"
 #include "signal_velocity.h"
@@ -222,227 +223,23 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_density(
 #ifdef WITH_VECTORIZATION
 
 /**
- * @brief Density interaction computed using 1 vector
- * (non-symmetric vectorized version).
- */
-__attribute__((always_inline)) INLINE static void
-runner_iact_nonsym_1_vec_density(vector *r2, vector *dx, vector *dy, vector *dz,
-                                 vector hi_inv, vector vix, vector viy,
-                                 vector viz, float *Vjx, float *Vjy, float *Vjz,
-                                 float *Mj, vector *rhoSum, vector *rho_dhSum,
-                                 vector *wcountSum, vector *wcount_dhSum,
-                                 vector *div_vSum, vector *curlvxSum,
-                                 vector *curlvySum, vector *curlvzSum,
-                                 mask_t mask) {
-
-  vector r, ri, ui, wi, wi_dx;
-  vector dvx, dvy, dvz;
-  vector dvdr;
-  vector curlvrx, curlvry, curlvrz;
-
-  /* Fill the vectors. */
-  const vector mj = vector_load(Mj);
-  const vector vjx = vector_load(Vjx);
-  const vector vjy = vector_load(Vjy);
-  const vector vjz = vector_load(Vjz);
-
-  /* Get the radius and inverse radius. */
-  ri = vec_reciprocal_sqrt(*r2);
-  r.v = vec_mul(r2->v, ri.v);
-
-  ui.v = vec_mul(r.v, hi_inv.v);
-
-  /* Calculate the kernel for two particles. */
-  kernel_deval_1_vec(&ui, &wi, &wi_dx);
-
-  /* Compute dv. */
-  dvx.v = vec_sub(vix.v, vjx.v);
-  dvy.v = vec_sub(viy.v, vjy.v);
-  dvz.v = vec_sub(viz.v, vjz.v);
-
-  /* Compute dv dot r */
-  dvdr.v = vec_fma(dvx.v, dx->v, vec_fma(dvy.v, dy->v, vec_mul(dvz.v, dz->v)));
-  dvdr.v = vec_mul(dvdr.v, ri.v);
-
-  /* Compute dv cross r */
-  curlvrx.v =
-      vec_fma(dvy.v, dz->v, vec_mul(vec_set1(-1.0f), vec_mul(dvz.v, dy->v)));
-  curlvry.v =
-      vec_fma(dvz.v, dx->v, vec_mul(vec_set1(-1.0f), vec_mul(dvx.v, dz->v)));
-  curlvrz.v =
-      vec_fma(dvx.v, dy->v, vec_mul(vec_set1(-1.0f), vec_mul(dvy.v, dx->v)));
-  curlvrx.v = vec_mul(curlvrx.v, ri.v);
-  curlvry.v = vec_mul(curlvry.v, ri.v);
-  curlvrz.v = vec_mul(curlvrz.v, ri.v);
-
-  vector wcount_dh_update;
-  wcount_dh_update.v =
-      vec_fma(vec_set1(hydro_dimension), wi.v, vec_mul(ui.v, wi_dx.v));
-
-  /* Mask updates to intermediate vector sums for particle pi. */
-  rhoSum->v = vec_mask_add(rhoSum->v, vec_mul(mj.v, wi.v), mask);
-  rho_dhSum->v =
-      vec_mask_sub(rho_dhSum->v, vec_mul(mj.v, wcount_dh_update.v), mask);
-  wcountSum->v = vec_mask_add(wcountSum->v, wi.v, mask);
-  wcount_dhSum->v = vec_mask_sub(wcount_dhSum->v, wcount_dh_update.v, mask);
-  div_vSum->v =
-      vec_mask_sub(div_vSum->v, vec_mul(mj.v, vec_mul(dvdr.v, wi_dx.v)), mask);
-  curlvxSum->v = vec_mask_add(curlvxSum->v,
-                              vec_mul(mj.v, vec_mul(curlvrx.v, wi_dx.v)), mask);
-  curlvySum->v = vec_mask_add(curlvySum->v,
-                              vec_mul(mj.v, vec_mul(curlvry.v, wi_dx.v)), mask);
-  curlvzSum->v = vec_mask_add(curlvzSum->v,
-                              vec_mul(mj.v, vec_mul(curlvrz.v, wi_dx.v)), mask);
-}
-
-/**
- * @brief Density interaction computed using 2 interleaved vectors
- * (non-symmetric vectorized version).
+ * @brief Add the sums of the vectorized density interactions to a particle.
  */
 __attribute__((always_inline)) INLINE static void
-runner_iact_nonsym_2_vec_density(float *R2, float *Dx, float *Dy, float *Dz,
-                                 vector hi_inv, vector vix, vector viy,
-                                 vector viz, float *Vjx, float *Vjy, float *Vjz,
-                                 float *Mj, vector *rhoSum, vector *rho_dhSum,
-                                 vector *wcountSum, vector *wcount_dhSum,
-                                 vector *div_vSum, vector *curlvxSum,
-                                 vector *curlvySum, vector *curlvzSum,
-                                 mask_t mask, mask_t mask2, int mask_cond) {
-
-  vector r, ri, ui, wi, wi_dx;
-  vector dvx, dvy, dvz;
-  vector dvdr;
-  vector curlvrx, curlvry, curlvrz;
-  vector r_2, ri2, ui2, wi2, wi_dx2;
-  vector dvx2, dvy2, dvz2;
-  vector dvdr2;
-  vector curlvrx2, curlvry2, curlvrz2;
-
-  /* Fill the vectors. */
-  const vector mj = vector_load(Mj);
-  const vector mj2 = vector_load(&Mj[VEC_SIZE]);
-  const vector vjx = vector_load(Vjx);
-  const vector vjx2 = vector_load(&Vjx[VEC_SIZE]);
-  const vector vjy = vector_load(Vjy);
-  const vector vjy2 = vector_load(&Vjy[VEC_SIZE]);
-  const vector vjz = vector_load(Vjz);
-  const vector vjz2 = vector_load(&Vjz[VEC_SIZE]);
-  const vector dx = vector_load(Dx);
-  const vector dx2 = vector_load(&Dx[VEC_SIZE]);
-  const vector dy = vector_load(Dy);
-  const vector dy2 = vector_load(&Dy[VEC_SIZE]);
-  const vector dz = vector_load(Dz);
-  const vector dz2 = vector_load(&Dz[VEC_SIZE]);
-
-  /* Get the radius and inverse radius. */
-  const vector r2 = vector_load(R2);
-  const vector r2_2 = vector_load(&R2[VEC_SIZE]);
-  ri = vec_reciprocal_sqrt(r2);
-  ri2 = vec_reciprocal_sqrt(r2_2);
-  r.v = vec_mul(r2.v, ri.v);
-  r_2.v = vec_mul(r2_2.v, ri2.v);
-
-  ui.v = vec_mul(r.v, hi_inv.v);
-  ui2.v = vec_mul(r_2.v, hi_inv.v);
-
-  /* Calculate the kernel for two particles. */
-  kernel_deval_2_vec(&ui, &wi, &wi_dx, &ui2, &wi2, &wi_dx2);
-
-  /* Compute dv. */
-  dvx.v = vec_sub(vix.v, vjx.v);
-  dvx2.v = vec_sub(vix.v, vjx2.v);
-  dvy.v = vec_sub(viy.v, vjy.v);
-  dvy2.v = vec_sub(viy.v, vjy2.v);
-  dvz.v = vec_sub(viz.v, vjz.v);
-  dvz2.v = vec_sub(viz.v, vjz2.v);
-
-  /* Compute dv dot r */
-  dvdr.v = vec_fma(dvx.v, dx.v, vec_fma(dvy.v, dy.v, vec_mul(dvz.v, dz.v)));
-  dvdr2.v =
-      vec_fma(dvx2.v, dx2.v, vec_fma(dvy2.v, dy2.v, vec_mul(dvz2.v, dz2.v)));
-  dvdr.v = vec_mul(dvdr.v, ri.v);
-  dvdr2.v = vec_mul(dvdr2.v, ri2.v);
-
-  /* Compute dv cross r */
-  curlvrx.v =
-      vec_fma(dvy.v, dz.v, vec_mul(vec_set1(-1.0f), vec_mul(dvz.v, dy.v)));
-  curlvrx2.v =
-      vec_fma(dvy2.v, dz2.v, vec_mul(vec_set1(-1.0f), vec_mul(dvz2.v, dy2.v)));
-  curlvry.v =
-      vec_fma(dvz.v, dx.v, vec_mul(vec_set1(-1.0f), vec_mul(dvx.v, dz.v)));
-  curlvry2.v =
-      vec_fma(dvz2.v, dx2.v, vec_mul(vec_set1(-1.0f), vec_mul(dvx2.v, dz2.v)));
-  curlvrz.v =
-      vec_fma(dvx.v, dy.v, vec_mul(vec_set1(-1.0f), vec_mul(dvy.v, dx.v)));
-  curlvrz2.v =
-      vec_fma(dvx2.v, dy2.v, vec_mul(vec_set1(-1.0f), vec_mul(dvy2.v, dx2.v)));
-  curlvrx.v = vec_mul(curlvrx.v, ri.v);
-  curlvrx2.v = vec_mul(curlvrx2.v, ri2.v);
-  curlvry.v = vec_mul(curlvry.v, ri.v);
-  curlvry2.v = vec_mul(curlvry2.v, ri2.v);
-  curlvrz.v = vec_mul(curlvrz.v, ri.v);
-  curlvrz2.v = vec_mul(curlvrz2.v, ri2.v);
-
-  vector wcount_dh_update, wcount_dh_update2;
-  wcount_dh_update.v =
-      vec_fma(vec_set1(hydro_dimension), wi.v, vec_mul(ui.v, wi_dx.v));
-  wcount_dh_update2.v =
-      vec_fma(vec_set1(hydro_dimension), wi2.v, vec_mul(ui2.v, wi_dx2.v));
-
-  /* Mask updates to intermediate vector sums for particle pi. */
-  /* Mask only when needed. */
-  if (mask_cond) {
-    rhoSum->v = vec_mask_add(rhoSum->v, vec_mul(mj.v, wi.v), mask);
-    rhoSum->v = vec_mask_add(rhoSum->v, vec_mul(mj2.v, wi2.v), mask2);
-    rho_dhSum->v =
-        vec_mask_sub(rho_dhSum->v, vec_mul(mj.v, wcount_dh_update.v), mask);
-    rho_dhSum->v =
-        vec_mask_sub(rho_dhSum->v, vec_mul(mj2.v, wcount_dh_update2.v), mask2);
-    wcountSum->v = vec_mask_add(wcountSum->v, wi.v, mask);
-    wcountSum->v = vec_mask_add(wcountSum->v, wi2.v, mask2);
-    wcount_dhSum->v = vec_mask_sub(wcount_dhSum->v, wcount_dh_update.v, mask);
-    wcount_dhSum->v = vec_mask_sub(wcount_dhSum->v, wcount_dh_update2.v, mask2);
-    div_vSum->v = vec_mask_sub(div_vSum->v,
-                               vec_mul(mj.v, vec_mul(dvdr.v, wi_dx.v)), mask);
-    div_vSum->v = vec_mask_sub(
-        div_vSum->v, vec_mul(mj2.v, vec_mul(dvdr2.v, wi_dx2.v)), mask2);
-    curlvxSum->v = vec_mask_add(
-        curlvxSum->v, vec_mul(mj.v, vec_mul(curlvrx.v, wi_dx.v)), mask);
-    curlvxSum->v = vec_mask_add(
-        curlvxSum->v, vec_mul(mj2.v, vec_mul(curlvrx2.v, wi_dx2.v)), mask2);
-    curlvySum->v = vec_mask_add(
-        curlvySum->v, vec_mul(mj.v, vec_mul(curlvry.v, wi_dx.v)), mask);
-    curlvySum->v = vec_mask_add(
-        curlvySum->v, vec_mul(mj2.v, vec_mul(curlvry2.v, wi_dx2.v)), mask2);
-    curlvzSum->v = vec_mask_add(
-        curlvzSum->v, vec_mul(mj.v, vec_mul(curlvrz.v, wi_dx.v)), mask);
-    curlvzSum->v = vec_mask_add(
-        curlvzSum->v, vec_mul(mj2.v, vec_mul(curlvrz2.v, wi_dx2.v)), mask2);
-  } else {
-    rhoSum->v = vec_add(rhoSum->v, vec_mul(mj.v, wi.v));
-    rhoSum->v = vec_add(rhoSum->v, vec_mul(mj2.v, wi2.v));
-    rho_dhSum->v = vec_sub(rho_dhSum->v, vec_mul(mj.v, wcount_dh_update.v));
-    rho_dhSum->v = vec_sub(rho_dhSum->v, vec_mul(mj2.v, wcount_dh_update2.v));
-    wcountSum->v = vec_add(wcountSum->v, wi.v);
-    wcountSum->v = vec_add(wcountSum->v, wi2.v);
-    wcount_dhSum->v = vec_sub(wcount_dhSum->v, wcount_dh_update.v);
-    wcount_dhSum->v = vec_sub(wcount_dhSum->v, wcount_dh_update2.v);
-    div_vSum->v = vec_sub(div_vSum->v, vec_mul(mj.v, vec_mul(dvdr.v, wi_dx.v)));
-    div_vSum->v =
-        vec_sub(div_vSum->v, vec_mul(mj2.v, vec_mul(dvdr2.v, wi_dx2.v)));
-    curlvxSum->v =
-        vec_add(curlvxSum->v, vec_mul(mj.v, vec_mul(curlvrx.v, wi_dx.v)));
-    curlvxSum->v =
-        vec_add(curlvxSum->v, vec_mul(mj2.v, vec_mul(curlvrx2.v, wi_dx2.v)));
-    curlvySum->v =
-        vec_add(curlvySum->v, vec_mul(mj.v, vec_mul(curlvry.v, wi_dx.v)));
-    curlvySum->v =
-        vec_add(curlvySum->v, vec_mul(mj2.v, vec_mul(curlvry2.v, wi_dx2.v)));
-    curlvzSum->v =
-        vec_add(curlvzSum->v, vec_mul(mj.v, vec_mul(curlvrz.v, wi_dx.v)));
-    curlvzSum->v =
-        vec_add(curlvzSum->v, vec_mul(mj2.v, vec_mul(curlvrz2.v, wi_dx2.v)));
-  }
+runner_iact_nonsym_vec_density_reduce(struct part *restrict pi, vector rhoSum,
+                                      vector rho_dhSum, vector wcountSum,
+                                      vector wcount_dhSum, vector div_vSum,
+                                      vector curlvxSum, vector curlvySum,
+                                      vector curlvzSum) {
+
+  VEC_HADD(rhoSum, pi->rho);
+  VEC_HADD(rho_dhSum, pi->density.rho_dh);
+  VEC_HADD(wcountSum, pi->density.wcount);
+  VEC_HADD(wcount_dhSum, pi->density.wcount_dh);
+  VEC_HADD(div_vSum, pi->density.div_v);
+  VEC_HADD(curlvxSum, pi->density.rot_v[0]);
+  VEC_HADD(curlvySum, pi->density.rot_v[1]);
+  VEC_HADD(curlvzSum, pi->density.rot_v[2]);
 }
 #endif
 
@@ -579,7 +376,7 @@ __attribute__((always_inline)) INLINE static void runner_iact_force(
 
   /* Adaptive softening acceleration term */
   const float adapt_soft_acc_term =
-      adaptive_softening_get_acc_term(pi, pj, wi_dr, wj_dr, f_ij, f_ji, r_inv);
+      adaptive_softening_get_acc_term(pi, pj, wi_dr, wj_dr, f_i, f_j, r_inv);
 
   /* Eventually got the acceleration */
   const float acc = visc_term + sph_term + adapt_soft_acc_term;
@@ -708,7 +505,7 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_force(
 
   /* Adaptive softening acceleration term */
   const float adapt_soft_acc_term =
-      adaptive_softening_get_acc_term(pi, pj, wi_dr, wj_dr, f_ij, f_ji, r_inv);
+      adaptive_softening_get_acc_term(pi, pj, wi_dr, wj_dr, f_i, f_j, r_inv);
 
   /* Eventually got the acceleration */
   const float acc = visc_term + sph_term + adapt_soft_acc_term;
@@ -83,6 +83,29 @@ __attribute__((always_inline)) INLINE static void hydro_compute_flux(
   fluxes[4] *= Anorm;
 }
 
+#ifdef RIEMANN_SOLVER_BATCH
+/**
+ * @brief Compute the fluxes for a batch of Riemann problems, given the surface
+ * areas of their interfaces.
+ *
+ * @param b The #riemann_batch (the fluxes are stored in it).
+ * @param Anorm Surface areas of the interfaces.
+ * @param count Number of problems in the batch.
+ */
+__attribute__((always_inline)) INLINE static void hydro_compute_flux_batch(
+    struct riemann_batch* restrict b, const float* Anorm, const int count) {
+
+  riemann_solve_batch_for_middle_state_flux(b, count);
+
+  for (int i = 0; i < count; i++) {
+    b->flux[1][i] *= Anorm[i];
+    b->flux[2][i] *= Anorm[i];
+    b->flux[3][i] *= Anorm[i];
+    b->flux[4][i] *= Anorm[i];
+  }
+}
+#endif /* RIEMANN_SOLVER_BATCH */
+
 /**
  * @brief Update the fluxes for the particle with the given contributions,
  * assuming the particle is to the left of the interparticle interface.
@@ -29,6 +29,12 @@
 
 #define GIZMO_VOLUME_CORRECTION
 
+/* The force loops queue the interfaces in a #hydro_flux_batch, if the
+ * Riemann solver can solve them in vectors */
+#if defined(RIEMANN_SOLVER_BATCH) && defined(WITH_VECTORIZATION)
+#define HYDRO_FLUX_BATCH
+#endif
+
 /**
  * @brief Calculate the volume interaction between particle i and particle j
  *
@@ -189,19 +195,13 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_gradient(
 }
 
 /**
- * @brief Common part of the flux calculation between particle i and j
- *
- * Since the only difference between the symmetric and non-symmetric version
- * of the flux calculation  is in the update of the conserved variables at the
- * very end (which is not done for particle j if mode is 0), both
- * runner_iact_force and runner_iact_nonsym_force call this method, with an
- * appropriate mode.
+ * @brief Set up the Riemann problem at the interface between particle i and
+ * particle j
  *
  * This method calculates the surface area of the interface between particle i
  * and particle j, as well as the interface position and velocity. These are
- * then used to reconstruct and predict the primitive variables, which are then
- * fed to a Riemann solver that calculates a flux. This flux is used to update
- * the conserved variables of particle i or both particles.
+ * then used to reconstruct and predict the primitive variables, which are
+ * then boosted to the frame of the interface to be fed to a Riemann solver.
  *
  * This method also calculates the maximal velocity used to calculate the time
  * step.
@@ -213,13 +213,21 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_gradient(
  * @param hj Comoving smoothing-length of particle j.
  * @param pi Particle i.
  * @param pj Particle j.
+ * @param mode 0 for non-symmetric interaction, 1 for symmetric interaction.
  * @param a Current scale factor.
  * @param H Current Hubble parameter.
+ * @param Wi (return) Left state of the Riemann problem.
+ * @param Wj (return) Right state of the Riemann problem.
+ * @param n_unit (return) Unit vector normal to the interface.
+ * @param vij (return) Velocity of the interface.
+ * @param Anorm_out (return) Surface area of the interface.
+ * @return 0 if the interface has no area (no flux), 1 otherwise.
  */
-__attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
+__attribute__((always_inline)) INLINE static int runner_iact_fluxes_interface(
     const float r2, const float dx[3], const float hi, const float hj,
     struct part *restrict pi, struct part *restrict pj, int mode, const float a,
-    const float H) {
+    const float H, float Wi[5], float Wj[5], float n_unit[3], float vij[3],
+    float *Anorm_out) {
 
   /* Get r and 1/r. */
   const float r = sqrtf(r2);
@@ -239,7 +247,6 @@ __attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
   }
   const float Vi = pi->geometry.volume;
   const float Vj = pj->geometry.volume;
-  float Wi[5], Wj[5];
   hydro_part_get_primitive_variables(pi, Wi);
   hydro_part_get_primitive_variables(pj, Wj);
 
@@ -342,7 +349,7 @@ __attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
   /* if the interface has no area, nothing happens and we return */
   /* continuing results in dividing by zero and NaN's... */
   if (Anorm2 == 0.0f) {
-    return;
+    return 0;
   }
 
   /* Compute the area */
@@ -366,8 +373,9 @@ __attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
 #endif
 
   /* compute the normal vector of the interface */
-  const float n_unit[3] = {A[0] * Anorm_inv, A[1] * Anorm_inv,
-                           A[2] * Anorm_inv};
+  n_unit[0] = A[0] * Anorm_inv;
+  n_unit[1] = A[1] * Anorm_inv;
+  n_unit[2] = A[2] * Anorm_inv;
 
   /* Compute interface position (relative to pi, since we don't need the actual
    * position) eqn. (8) */
@@ -376,9 +384,9 @@ __attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
 
   /* Compute interface velocity */
   /* eqn. (9) */
-  const float vij[3] = {vi[0] + (vi[0] - vj[0]) * xfac,
-                        vi[1] + (vi[1] - vj[1]) * xfac,
-                        vi[2] + (vi[2] - vj[2]) * xfac};
+  vij[0] = vi[0] + (vi[0] - vj[0]) * xfac;
+  vij[1] = vi[1] + (vi[1] - vj[1]) * xfac;
+  vij[2] = vi[2] + (vi[2] - vj[2]) * xfac;
 
   /* complete calculation of position of interface */
   /* NOTE: dx is not necessarily just pi->x - pj->x but can also contain
@@ -404,8 +412,27 @@ __attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
   /* we don't need to rotate, we can use the unit vector in the Riemann problem
    * itself (see GIZMO) */
 
-  float totflux[5];
-  hydro_compute_flux(Wi, Wj, n_unit, vij, Anorm, totflux);
+  *Anorm_out = Anorm;
+  return 1;
+}
+
+/**
+ * @brief Exchange the flux across the interface between particle i and
+ * particle j
+ *
+ * The flux is used to update the conserved variables of particle i or both
+ * particles.
+ *
+ * @param dx Comoving distance vector between the particles (dx = pi->x -
+ * pj->x).
+ * @param pi Particle i.
+ * @param pj Particle j.
+ * @param mode 0 for non-symmetric interaction, 1 for symmetric interaction.
+ * @param totflux Flux across the interface (times its surface area).
+ */
+__attribute__((always_inline)) INLINE static void runner_iact_fluxes_exchange(
+    const float dx[3], struct part *restrict pi, struct part *restrict pj,
+    int mode, const float totflux[5]) {
 
   /* get the time step for the flux exchange. This is always the smallest time
      step among the two particles */
@@ -430,6 +457,158 @@ __attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
   runner_iact_chemistry_fluxes(pi, pj, totflux[0], mindt, mode);
 }
 
+/**
+ * @brief Common part of the flux calculation between particle i and j
+ *
+ * Since the only difference between the symmetric and non-symmetric version
+ * of the flux calculation  is in the update of the conserved variables at the
+ * very end (which is not done for particle j if mode is 0), both
+ * runner_iact_force and runner_iact_nonsym_force call this method, with an
+ * appropriate mode.
+ *
+ * The Riemann problem at the interface is set up by
+ * runner_iact_fluxes_interface() and the resulting flux is exchanged by
+ * runner_iact_fluxes_exchange().
+ *
+ * @param r2 Comoving squared distance between particle i and particle j.
+ * @param dx Comoving distance vector between the particles (dx = pi->x -
+ * pj->x).
+ * @param hi Comoving smoothing-length of particle i.
+ * @param hj Comoving smoothing-length of particle j.
+ * @param pi Particle i.
+ * @param pj Particle j.
+ * @param mode 0 for non-symmetric interaction, 1 for symmetric interaction.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ */
+__attribute__((always_inline)) INLINE static void runner_iact_fluxes_common(
+    const float r2, const float dx[3], const float hi, const float hj,
+    struct part *restrict pi, struct part *restrict pj, int mode, const float a,
+    const float H) {
+
+  float Wi[5], Wj[5], n_unit[3], vij[3], Anorm;
+  if (!runner_iact_fluxes_interface(r2, dx, hi, hj, pi, pj, mode, a, H, Wi, Wj,
+                                    n_unit, vij, &Anorm))
+    return;
+
+  float totflux[5];
+  hydro_compute_flux(Wi, Wj, n_unit, vij, Anorm, totflux);
+
+  runner_iact_fluxes_exchange(dx, pi, pj, mode, totflux);
+}
+
+#ifdef HYDRO_FLUX_BATCH
+
+/**
+ * @brief Interfaces queued by the force loops before their fluxes are
+ * computed.
+ *
+ * The Riemann problems of the interfaces found by the loops are collected in
+ * a #riemann_batch and solved together once it is full (or once the loop is
+ * over), which lets the solver work on a full vector of interfaces at a time.
+ * This is safe as setting up an interface only reads particle fields that
+ * the exchange of the fluxes does not write.
+ */
+struct hydro_flux_batch {
+
+  /*! The Riemann problems of the interfaces. */
+  struct riemann_batch riemann;
+
+  /*! Surface areas of the interfaces. */
+  float Anorm[RIEMANN_BATCH_SIZE];
+
+  /*! Distance vectors between the particles. */
+  float dx[RIEMANN_BATCH_SIZE][3];
+
+  /*! Particles on the left of the interfaces. */
+  struct part *pi[RIEMANN_BATCH_SIZE];
+
+  /*! Particles on the right of the interfaces. */
+  struct part *pj[RIEMANN_BATCH_SIZE];
+
+  /*! Modes (symmetric or not) of the interactions. */
+  int mode[RIEMANN_BATCH_SIZE];
+
+  /*! Number of interfaces in the batch. */
+  int count;
+};
+
+/**
+ * @brief Prepare an empty #hydro_flux_batch.
+ *
+ * @param b The #hydro_flux_batch.
+ */
+__attribute__((always_inline)) INLINE static void hydro_flux_batch_init(
+    struct hydro_flux_batch *restrict b) {
+
+  b->count = 0;
+}
+
+/**
+ * @brief Compute and exchange the fluxes of all the interfaces of a
+ * #hydro_flux_batch, leaving it empty.
+ *
+ * @param b The #hydro_flux_batch.
+ */
+__attribute__((always_inline)) INLINE static void hydro_flux_batch_flush(
+    struct hydro_flux_batch *restrict b) {
+
+  if (b->count == 0) return;
+
+  hydro_compute_flux_batch(&b->riemann, b->Anorm, b->count);
+
+  for (int i = 0; i < b->count; i++) {
+    float totflux[5];
+    riemann_batch_get_flux(&b->riemann, i, totflux);
+    runner_iact_fluxes_exchange(b->dx[i], b->pi[i], b->pj[i], b->mode[i],
+                                totflux);
+  }
+
+  b->count = 0;
+}
+
+/**
+ * @brief Queue the interface between particle i and particle j in a
+ * #hydro_flux_batch, computing the fluxes of the batch if it is full.
+ *
+ * @param b The #hydro_flux_batch.
+ * @param r2 Comoving squared distance between particle i and particle j.
+ * @param dx Comoving distance vector between the particles (dx = pi->x -
+ * pj->x).
+ * @param hi Comoving smoothing-length of particle i.
+ * @param hj Comoving smoothing-length of particle j.
+ * @param pi Particle i.
+ * @param pj Particle j.
+ * @param mode 0 for non-symmetric interaction, 1 for symmetric interaction.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ */
+__attribute__((always_inline)) INLINE static void runner_iact_fluxes_batch(
+    struct hydro_flux_batch *restrict b, const float r2, const float dx[3],
+    const float hi, const float hj, struct part *restrict pi,
+    struct part *restrict pj, int mode, const float a, const float H) {
+
+  float Wi[5], Wj[5], n_unit[3], vij[3], Anorm;
+  if (!runner_iact_fluxes_interface(r2, dx, hi, hj, pi, pj, mode, a, H, Wi, Wj,
+                                    n_unit, vij, &Anorm))
+    return;
+
+  const int i = b->count;
+  riemann_batch_set_problem(&b->riemann, i, Wi, Wj, n_unit, vij);
+  b->Anorm[i] = Anorm;
+  b->dx[i][0] = dx[0];
+  b->dx[i][1] = dx[1];
+  b->dx[i][2] = dx[2];
+  b->pi[i] = pi;
+  b->pj[i] = pj;
+  b->mode[i] = mode;
+  b->count++;
+
+  if (b->count == RIEMANN_BATCH_SIZE) hydro_flux_batch_flush(b);
+}
+
+#endif /* HYDRO_FLUX_BATCH */
+
 /**
  * @brief Flux calculation between particle i and particle j
  *
@@ -477,4 +656,61 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_force(
   runner_iact_fluxes_common(r2, dx, hi, hj, pi, pj, 0, a, H);
 }
 
+#ifdef HYDRO_FLUX_BATCH
+
+/**
+ * @brief Flux calculation between particle i and particle j, queued in a
+ * #hydro_flux_batch
+ *
+ * This method calls runner_iact_fluxes_batch with mode 1.
+ *
+ * @param b The #hydro_flux_batch.
+ * @param r2 Comoving squared distance between particle i and particle j.
+ * @param dx Comoving distance vector between the particles (dx = pi->x -
+ * pj->x).
+ * @param hi Comoving smoothing-length of particle i.
+ * @param hj Comoving smoothing-length of particle j.
+ * @param pi Particle i.
+ * @param pj Particle j.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ */
+__attribute__((always_inline)) INLINE static void runner_iact_force_batch(
+    struct hydro_flux_batch *restrict b, const float r2, const float dx[3],
+    const float hi, const float hj, struct part *restrict pi,
+    struct part *restrict pj, const float a, const float H) {
+
+  runner_iact_fluxes_batch(b, r2, dx, hi, hj, pi, pj, 1, a, H);
+}
+
+/**
+ * @brief Flux calculation between particle i and particle j, queued in a
+ * #hydro_flux_batch: non-symmetric version
+ *
+ * This method calls runner_iact_fluxes_batch with mode 0.
+ *
+ * @param b The #hydro_flux_batch.
+ * @param r2 Comoving squared distance between particle i and particle j.
+ * @param dx Comoving distance vector between the particles (dx = pi->x -
+ * pj->x).
+ * @param hi Comoving smoothing-length of particle i.
+ * @param hj Comoving smoothing-length of particle j.
+ * @param pi Particle i.
+ * @param pj Particle j.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_force_batch(struct hydro_flux_batch *restrict b,
+                               const float r2, const float dx[3],
+                               const float hi, const float hj,
+                               struct part *restrict pi,
+                               struct part *restrict pj, const float a,
+                               const float H) {
+
+  runner_iact_fluxes_batch(b, r2, dx, hi, hj, pi, pj, 0, a, H);
+}
+
+#endif /* HYDRO_FLUX_BATCH */
+
 #endif /* SWIFT_GIZMO_HYDRO_IACT_H */
@@ -714,6 +714,18 @@ __attribute__((always_inline)) INLINE static void hydro_prepare_gradient(
   p->force.pressure = pressure_including_floor;
   p->force.soundspeed = soundspeed;
   p->force.balsara = balsara;
+
+  /* Compare the converged smoothing length to the one predicted by the drift
+   * and fold the error, as a rate, into the correction of the next
+   * predictions. */
+  if (hydro_props->use_h_prediction_correction) {
+    if (p->h_prediction.dt_drift > 0.f) {
+      const float error = logf(p->h / p->h_prediction.h_drifted);
+      p->h_prediction.dlogh_dt +=
+          hydro_props_h_prediction_gain * error / p->h_prediction.dt_drift;
+    }
+    p->h_prediction.dt_drift = 0.f;
+  }
 }
 
 /**
@@ -1022,12 +1034,25 @@ __attribute__((always_inline)) INLINE static void hydro_predict_extra(
   const float h_inv = 1.f / p->h;
 
   /* Predict smoothing length */
-  const float w1 = p->force.h_dt * h_inv * dt_drift;
+  float w1 = p->force.h_dt * h_inv * dt_drift;
+
+  /* Add the correction inferred from the errors of the previous predictions,
+   * limited to the maximal change of h allowed over one step */
+  if (hydro_props->use_h_prediction_correction) {
+    const float max_w = hydro_props->log_max_h_change;
+    const float w_corr = p->h_prediction.dlogh_dt * dt_drift;
+    w1 += fminf(fmaxf(w_corr, -max_w), max_w);
+    p->h_prediction.dt_drift += dt_drift;
+  }
+
   if (fabsf(w1) < 0.2f)
     p->h *= approx_expf(w1); /* 4th order expansion of exp(w) */
   else
     p->h *= expf(w1);
 
+  if (hydro_props->use_h_prediction_correction)
+    p->h_prediction.h_drifted = p->h;
+
   /* Predict density and weighted pressure */
   const float w2 = -hydro_dimension * w1;
   if (fabsf(w2) < 0.2f) {
@@ -1204,6 +1229,10 @@ __attribute__((always_inline)) INLINE static void hydro_first_init_part(
   xp->v_full[2] = p->v[2];
   xp->u_full = p->u;
 
+  p->h_prediction.h_drifted = p->h;
+  p->h_prediction.dt_drift = 0.f;
+  p->h_prediction.dlogh_dt = 0.f;
+
   hydro_reset_acceleration(p);
   hydro_init_part(p, NULL);
 }
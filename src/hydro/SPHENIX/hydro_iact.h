@@ -28,6 +28,8 @@
 
 #include "adaptive_softening_iact.h"
 #include "adiabatic_index.h"
+#include "cache.h"
+#include "hydro_iact_density_vec.h"
 #include "hydro_parameters.h"
 #include "minmax.h"
 #include "signal_velocity.h"
@@ -179,6 +181,29 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_density(
 #endif
 }
 
+#ifdef WITH_VECTORIZATION
+
+/**
+ * @brief Add the sums of the vectorized density interactions to a particle.
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_vec_density_reduce(struct part *restrict pi, vector rhoSum,
+                                      vector rho_dhSum, vector wcountSum,
+                                      vector wcount_dhSum, vector div_vSum,
+                                      vector curlvxSum, vector curlvySum,
+                                      vector curlvzSum) {
+
+  VEC_HADD(rhoSum, pi->rho);
+  VEC_HADD(rho_dhSum, pi->density.rho_dh);
+  VEC_HADD(wcountSum, pi->density.wcount);
+  VEC_HADD(wcount_dhSum, pi->density.wcount_dh);
+  VEC_HADD(div_vSum, pi->viscosity.div_v);
+  VEC_HADD(curlvxSum, pi->density.rot_v[0]);
+  VEC_HADD(curlvySum, pi->density.rot_v[1]);
+  VEC_HADD(curlvzSum, pi->density.rot_v[2]);
+}
+#endif
+
 /**
  * @brief Calculate the gradient interaction between particle i and particle j
  *
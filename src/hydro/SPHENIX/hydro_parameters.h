@@ -100,6 +100,13 @@
 /*! Minimal value for the diffusion alpha in variable schemes. */
 #define hydro_props_default_diffusion_alpha_min 0.0f
 
+/* Smoothing length prediction -- FIXED -- MUST BE DEFINED AT COMPILE-TIME */
+
+/*! Fraction of the error made on the last predicted smoothing length that
+ * is added to the correction of the predicted rate of change of h. Lower
+ * values make the correction react more slowly to changes of the flow. */
+#define hydro_props_h_prediction_gain 1.0f
+
 /* Structs that store the relevant variables */
 
 /*! Artificial viscosity parameters */
@@ -216,6 +216,20 @@ struct part {
     } force;
   };
 
+  /* Store the smoothing length prediction information in a separate struct. */
+  struct {
+
+    /*! Smoothing length at the end of the last drift */
+    float h_drifted;
+
+    /*! Drift time-step accumulated since h was last converged */
+    float dt_drift;
+
+    /*! Correction to the predicted logarithmic rate of change of h */
+    float dlogh_dt;
+
+  } h_prediction;
+
   /*! Additional data used for adaptive softening */
   struct adaptive_softening_part_data adaptive_softening_data;
 
@@ -39,6 +39,7 @@
 #include "units.h"
 
 #define hydro_props_default_max_iterations 30
+#define hydro_props_default_ghost_list_h_factor 0.f
 #define hydro_props_default_volume_change 1.4f
 #define hydro_props_default_h_max FLT_MAX
 #define hydro_props_default_h_min_ratio 0.f
@@ -101,6 +102,24 @@ void hydro_props_init(struct hydro_props *p,
   if (p->max_smoothing_iterations <= 10)
     error("The number of smoothing length iterations should be > 10");
 
+  /* Candidate neighbour lists for the ghost iterations */
+  p->ghost_list_h_factor =
+      parser_get_opt_param_float(params, "SPH:ghost_list_h_factor",
+                                 hydro_props_default_ghost_list_h_factor);
+
+  if (p->ghost_list_h_factor != 0.f && p->ghost_list_h_factor < 1.f)
+    error("The ghost neighbour list factor should be 0 or >= 1");
+
+  /* Correction of the smoothing length prediction */
+  p->use_h_prediction_correction =
+      parser_get_opt_param_int(params, "SPH:use_h_prediction_correction", 0);
+
+  if (p->use_h_prediction_correction) {
+#if !defined(SPHENIX_SPH)
+    error("The smoothing length prediction correction needs SPHENIX!");
+#endif
+  }
+
   /* ------ Neighbour number definition ------------ */
 
   /* Non-conventional neighbour number definition */
@@ -252,6 +271,13 @@ void hydro_props_print(const struct hydro_props *p) {
     message("Maximal iterations in ghost task set to %d (default is %d)",
             p->max_smoothing_iterations, hydro_props_default_max_iterations);
 
+  if (p->ghost_list_h_factor != hydro_props_default_ghost_list_h_factor)
+    message("Ghost iterations use neighbour lists of radius %.3f h",
+            p->ghost_list_h_factor);
+
+  if (p->use_h_prediction_correction)
+    message("Smoothing length predictions corrected with the ghost errors");
+
   if (p->initial_temperature != hydro_props_default_init_temp)
     message("Initial gas temperature set to %f", p->initial_temperature);
 
@@ -360,6 +386,8 @@ void hydro_props_init_no_hydro(struct hydro_props *p) {
   p->h_min = 0.f;
   p->h_min_ratio = hydro_props_default_h_min_ratio;
   p->max_smoothing_iterations = hydro_props_default_max_iterations;
+  p->ghost_list_h_factor = hydro_props_default_ghost_list_h_factor;
+  p->use_h_prediction_correction = 0;
   p->CFL_condition = 0.1;
   p->log_max_h_change = logf(powf(1.4, hydro_dimension_inv));
 
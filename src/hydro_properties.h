@@ -73,6 +73,14 @@ struct hydro_props {
   /*! Maximal number of iterations to converge h */
   int max_smoothing_iterations;
 
+  /*! Ratio of the radius of the candidate neighbour lists kept by the ghost
+   * to the smoothing length (0 to not use such lists) */
+  float ghost_list_h_factor;
+
+  /*! Are we correcting the predicted smoothing lengths with the errors the
+   * ghost measured on the previous predictions? */
+  int use_h_prediction_correction;
+
   /* ------ Neighbour number definition ------------ */
 
   /*! Are we using the mass-weighted definition of neighbour number? */
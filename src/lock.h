@@ -35,6 +35,7 @@
 #define lock_unlock(l) (pthread_spin_unlock(l) != 0)
 #define lock_unlock_blind(l) pthread_spin_unlock(l)
 #define lock_static_initializer ((pthread_spinlock_t)0)
+#define lock_is_locked(l) 0
 
 #elif defined(PTHREAD_LOCK)
 #include <pthread.h>
@@ -46,6 +47,7 @@
 #define lock_unlock(l) (pthread_mutex_unlock(l) != 0)
 #define lock_unlock_blind(l) pthread_mutex_unlock(l)
 #define lock_static_initializer PTHREAD_MUTEX_INITIALIZER
+#define lock_is_locked(l) 0
 
 #else
 #define swift_lock_type volatile int
@@ -60,6 +62,7 @@ INLINE static int lock_lock(volatile int *l) {
 #define lock_unlock(l) (atomic_cas(l, 1, 0) != 1)
 #define lock_unlock_blind(l) atomic_cas(l, 1, 0)
 #define lock_static_initializer 0
+#define lock_is_locked(l) (*(l) != 0)
 #endif
 
 #endif /* SWIFT_LOCK_H */
@@ -36,28 +36,29 @@ MPI_Datatype multipole_mpi_type;
 MPI_Op multipole_mpi_reduce_op;
 
 /**
- * @brief Apply a bit-by-bit XOR operattion on #gravity_tensors (i.e. does
- * a^=b).
+ * @brief Apply a bit-by-bit XOR operattion on #gravity_tensors_pack (i.e.
+ * does a^=b).
  *
- * @param a The #gravity_tensors to add to.
- * @param b The #gravity_tensors to add.
+ * @param a The #gravity_tensors_pack to add to.
+ * @param b The #gravity_tensors_pack to add.
  */
-void gravity_binary_xor(struct gravity_tensors *a,
-                        const struct gravity_tensors *b) {
+void gravity_binary_xor(struct gravity_tensors_pack *a,
+                        const struct gravity_tensors_pack *b) {
 
   char *aa = (char *)a;
   const char *bb = (const char *)b;
 
-  for (size_t i = 0; i < sizeof(struct gravity_tensors); ++i) {
+  for (size_t i = 0; i < sizeof(struct gravity_tensors_pack); ++i) {
     aa[i] ^= bb[i];
   }
 }
 
 /**
- * @brief MPI reduction function for the #gravity_tensors.
+ * @brief MPI reduction function for the #gravity_tensors_pack.
  *
- * @param invec Array of #gravity_tensors to read.
- * @param inoutvec Array of #gravity_tensors to read and do the reduction into.
+ * @param invec Array of #gravity_tensors_pack to read.
+ * @param inoutvec Array of #gravity_tensors_pack to read and do the reduction
+ * into.
  * @param len The length of the array.
  * @param datatype The MPI type this function acts upon (unused).
  */
@@ -65,8 +66,8 @@ void gravity_tensors_mpi_reduce(void *invec, void *inoutvec, int *len,
                                 MPI_Datatype *datatype) {
 
   for (int i = 0; i < *len; ++i) {
-    gravity_binary_xor(&((struct gravity_tensors *)inoutvec)[i],
-                       &((const struct gravity_tensors *)invec)[i]);
+    gravity_binary_xor(&((struct gravity_tensors_pack *)inoutvec)[i],
+                       &((const struct gravity_tensors_pack *)invec)[i]);
   }
 }
 
@@ -76,7 +77,7 @@ void multipole_create_mpi_types(void) {
   /* We just consider each structure to be a byte field disregarding their */
   /* detailed content */
   if (MPI_Type_contiguous(
-          sizeof(struct gravity_tensors) / sizeof(unsigned char), MPI_BYTE,
+          sizeof(struct gravity_tensors_pack) / sizeof(unsigned char), MPI_BYTE,
           &multipole_mpi_type) != MPI_SUCCESS ||
       MPI_Type_commit(&multipole_mpi_type) != MPI_SUCCESS) {
     error("Failed to create MPI type for multipole.");
@@ -55,6 +55,49 @@ __attribute__((nonnull)) INLINE static void gravity_reset(
   m->m_pole.min_old_a_grav_norm = FLT_MAX;
 }
 
+/**
+ * @brief Copy the exchanged part of a #gravity_tensors into a
+ * #gravity_tensors_pack.
+ *
+ * @param m The #gravity_tensors to pack.
+ * @param pack (output) The packed multipole.
+ */
+__attribute__((nonnull)) INLINE static void gravity_pack(
+    const struct gravity_tensors *m, struct gravity_tensors_pack *pack) {
+
+  pack->m_pole = m->m_pole;
+  pack->CoM[0] = m->CoM[0];
+  pack->CoM[1] = m->CoM[1];
+  pack->CoM[2] = m->CoM[2];
+  pack->CoM_rebuild[0] = m->CoM_rebuild[0];
+  pack->CoM_rebuild[1] = m->CoM_rebuild[1];
+  pack->CoM_rebuild[2] = m->CoM_rebuild[2];
+  pack->r_max = m->r_max;
+  pack->r_max_rebuild = m->r_max_rebuild;
+}
+
+/**
+ * @brief Copy a #gravity_tensors_pack into a #gravity_tensors.
+ *
+ * The field tensor of the #gravity_tensors is left untouched.
+ *
+ * @param m The #gravity_tensors to update.
+ * @param pack The packed multipole.
+ */
+__attribute__((nonnull)) INLINE static void gravity_unpack(
+    struct gravity_tensors *m, const struct gravity_tensors_pack *pack) {
+
+  m->m_pole = pack->m_pole;
+  m->CoM[0] = pack->CoM[0];
+  m->CoM[1] = pack->CoM[1];
+  m->CoM[2] = pack->CoM[2];
+  m->CoM_rebuild[0] = pack->CoM_rebuild[0];
+  m->CoM_rebuild[1] = pack->CoM_rebuild[1];
+  m->CoM_rebuild[2] = pack->CoM_rebuild[2];
+  m->r_max = pack->r_max;
+  m->r_max_rebuild = pack->r_max_rebuild;
+}
+
 /**
  * @brief Drifts a #multipole forward in time.
  *
@@ -109,6 +152,25 @@ __attribute__((nonnull)) INLINE static void gravity_drift(
   m->r_max += x_diff;
 }
 
+/**
+ * @brief Maximal distance any #gpart of a #multipole may have moved since
+ * the last rebuild.
+ *
+ * This is the drift of the CoM plus the growth of r_max applied by
+ * gravity_drift().
+ *
+ * @param m The #multipole.
+ */
+__attribute__((nonnull, pure)) INLINE static double
+gravity_multipole_max_displacement(const struct gravity_tensors *m) {
+
+  const double dx = m->CoM[0] - m->CoM_rebuild[0];
+  const double dy = m->CoM[1] - m->CoM_rebuild[1];
+  const double dz = m->CoM[2] - m->CoM_rebuild[2];
+
+  return (m->r_max - m->r_max_rebuild) + sqrt(dx * dx + dy * dy + dz * dz);
+}
+
 /**
  * @brief Zeroes all the fields of a field tensor
  *
@@ -0,0 +1,740 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_MULTIPOLE_BATCH_H
+#define SWIFT_MULTIPOLE_BATCH_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Local headers. */
+#include "accumulate.h"
+#include "align.h"
+#include "error.h"
+#include "gravity_derivatives.h"
+#include "inline.h"
+#include "multipole_struct.h"
+#include "periodic.h"
+#include "vector.h"
+
+/*! Number of M2L interactions computed together (a multiple of VEC_SIZE) */
+#define GRAVITY_M2L_BATCH_SIZE 32
+
+/**
+ * @brief A set of M2L interactions stored as a structure of arrays.
+ *
+ * Each entry is the contribution of one #multipole to one field tensor. The
+ * field tensors themselves are not stored: the caller keeps track of them and
+ * collects the results with gravity_M2L_batch_apply() once the batch has been
+ * computed. The code for the terms is generated by
+ * theory/Multipoles/generate_multipoles/multipoles.py.
+ */
+struct gravity_M2L_batch {
+
+  /*! Number of interactions in the batch. */
+  int count;
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+  /*! Number of #gpart in the multipoles (for the interaction counters). */
+  long long num_gpart[GRAVITY_M2L_BATCH_SIZE];
+#endif
+
+  /*! Distance vectors between the field tensors and the multipoles. */
+  float dx[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float dy[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float dz[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! Softening lengths of the multipoles. */
+  float eps[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! 0th order terms of the multipoles. */
+  float M_000[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! 0th order terms of the field tensors. */
+  float F_000[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+
+  /*! 1st order terms of the field tensors. */
+  float F_001[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_010[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_100[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+
+  /*! 2nd order terms of the multipoles. */
+  float M_002[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_011[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_020[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_101[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_110[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_200[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! 2nd order terms of the field tensors. */
+  float F_002[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_011[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_020[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_101[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_110[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_200[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+
+  /*! 3rd order terms of the multipoles. */
+  float M_003[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_012[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_021[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_030[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_102[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_111[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_120[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_201[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_210[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_300[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! 3rd order terms of the field tensors. */
+  float F_003[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_012[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_021[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_030[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_102[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_111[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_120[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_201[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_210[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_300[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+
+  /*! 4th order terms of the multipoles. */
+  float M_004[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_013[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_022[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_031[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_040[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_103[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_112[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_121[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_130[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_202[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_211[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_220[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_301[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_310[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_400[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! 4th order terms of the field tensors. */
+  float F_004[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_013[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_022[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_031[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_040[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_103[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_112[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_121[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_130[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_202[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_211[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_220[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_301[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_310[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_400[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+
+  /*! 5th order terms of the multipoles. */
+  float M_005[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_014[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_023[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_032[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_041[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_050[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_104[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_113[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_122[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_131[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_140[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_203[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_212[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_221[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_230[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_302[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_311[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_320[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_401[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_410[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float M_500[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! 5th order terms of the field tensors. */
+  float F_005[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_014[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_023[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_032[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_041[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_050[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_104[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_113[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_122[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_131[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_140[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_203[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_212[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_221[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_230[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_302[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_311[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_320[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_401[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_410[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+  float F_500[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+#endif
+};
+
+/**
+ * @brief Empty a #gravity_M2L_batch.
+ *
+ * @param b The #gravity_M2L_batch.
+ */
+__attribute__((nonnull)) INLINE static void gravity_M2L_batch_init(
+    struct gravity_M2L_batch *b) {
+
+  b->count = 0;
+}
+
+/**
+ * @brief Add the interaction of a field tensor with a multipole to a
+ * #gravity_M2L_batch.
+ *
+ * The batch must not be full.
+ *
+ * @param b The #gravity_M2L_batch.
+ * @param m_a The multipole creating the field.
+ * @param pos_b The position of the field tensor.
+ * @param pos_a The position of the multipole.
+ * @param periodic Is the calculation periodic ?
+ * @param dim The size of the simulation box.
+ * @return The index of the interaction in the batch.
+ */
+__attribute__((nonnull)) INLINE static int gravity_M2L_batch_add(
+    struct gravity_M2L_batch *restrict b, const struct multipole *restrict m_a,
+    const double pos_b[3], const double pos_a[3], const int periodic,
+    const double dim[3]) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (b->count >= GRAVITY_M2L_BATCH_SIZE)
+    error("Adding an interaction to a full M2L batch.");
+#endif
+
+  const int n = b->count++;
+
+  /* Compute distance vector */
+  float dx = (float)(pos_b[0] - pos_a[0]);
+  float dy = (float)(pos_b[1] - pos_a[1]);
+  float dz = (float)(pos_b[2] - pos_a[2]);
+
+  /* Apply BC */
+  if (periodic) {
+    dx = nearest(dx, dim[0]);
+    dy = nearest(dy, dim[1]);
+    dz = nearest(dz, dim[2]);
+  }
+
+  b->dx[n] = dx;
+  b->dy[n] = dy;
+  b->dz[n] = dz;
+  b->eps[n] = m_a->max_softening;
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+  b->num_gpart[n] = m_a->num_gpart;
+#endif
+
+  /* Copy the multipole (the dipole vanishes when using the CoM) */
+  b->M_000[n] = m_a->M_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  b->M_002[n] = m_a->M_002;
+  b->M_011[n] = m_a->M_011;
+  b->M_020[n] = m_a->M_020;
+  b->M_101[n] = m_a->M_101;
+  b->M_110[n] = m_a->M_110;
+  b->M_200[n] = m_a->M_200;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  b->M_003[n] = m_a->M_003;
+  b->M_012[n] = m_a->M_012;
+  b->M_021[n] = m_a->M_021;
+  b->M_030[n] = m_a->M_030;
+  b->M_102[n] = m_a->M_102;
+  b->M_111[n] = m_a->M_111;
+  b->M_120[n] = m_a->M_120;
+  b->M_201[n] = m_a->M_201;
+  b->M_210[n] = m_a->M_210;
+  b->M_300[n] = m_a->M_300;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  b->M_004[n] = m_a->M_004;
+  b->M_013[n] = m_a->M_013;
+  b->M_022[n] = m_a->M_022;
+  b->M_031[n] = m_a->M_031;
+  b->M_040[n] = m_a->M_040;
+  b->M_103[n] = m_a->M_103;
+  b->M_112[n] = m_a->M_112;
+  b->M_121[n] = m_a->M_121;
+  b->M_130[n] = m_a->M_130;
+  b->M_202[n] = m_a->M_202;
+  b->M_211[n] = m_a->M_211;
+  b->M_220[n] = m_a->M_220;
+  b->M_301[n] = m_a->M_301;
+  b->M_310[n] = m_a->M_310;
+  b->M_400[n] = m_a->M_400;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  b->M_005[n] = m_a->M_005;
+  b->M_014[n] = m_a->M_014;
+  b->M_023[n] = m_a->M_023;
+  b->M_032[n] = m_a->M_032;
+  b->M_041[n] = m_a->M_041;
+  b->M_050[n] = m_a->M_050;
+  b->M_104[n] = m_a->M_104;
+  b->M_113[n] = m_a->M_113;
+  b->M_122[n] = m_a->M_122;
+  b->M_131[n] = m_a->M_131;
+  b->M_140[n] = m_a->M_140;
+  b->M_203[n] = m_a->M_203;
+  b->M_212[n] = m_a->M_212;
+  b->M_221[n] = m_a->M_221;
+  b->M_230[n] = m_a->M_230;
+  b->M_302[n] = m_a->M_302;
+  b->M_311[n] = m_a->M_311;
+  b->M_320[n] = m_a->M_320;
+  b->M_401[n] = m_a->M_401;
+  b->M_410[n] = m_a->M_410;
+  b->M_500[n] = m_a->M_500;
+#endif
+
+  return n;
+}
+
+/**
+ * @brief Compute the field tensors of all the interactions of a
+ * #gravity_M2L_batch.
+ *
+ * This is the same calculation as gravity_M2L_nonsym() but each lane of the
+ * loop handles a different interaction, such that the compiler can evaluate
+ * VEC_SIZE of them at once.
+ *
+ * @param b The #gravity_M2L_batch.
+ * @param periodic Is the calculation periodic ?
+ * @param rs_inv The inverse of the gravity mesh-smoothing scale.
+ */
+__attribute__((nonnull)) INLINE static void gravity_M2L_batch_compute(
+    struct gravity_M2L_batch *restrict b, const int periodic,
+    const float rs_inv) {
+
+  /* Fill the entries up to the next multiple of the vector size with a
+   * massless multipole at unit distance and with unit softening, such that
+   * they can be computed safely (their results are not used) */
+  const int count = b->count;
+  const int count_padded = ((count + VEC_SIZE - 1) / VEC_SIZE) * VEC_SIZE;
+  swift_assume_size(count_padded, VEC_SIZE);
+  if (count < count_padded) {
+    static const struct multipole m_zero = {.max_softening = 1.f};
+    const double pos_b[3] = {1., 0., 0.};
+    const double pos_a[3] = {0., 0., 0.};
+    while (b->count < count_padded)
+      gravity_M2L_batch_add(b, &m_zero, pos_b, pos_a, /*periodic=*/0, pos_b);
+    b->count = count;
+  }
+
+  for (int n = 0; n < count_padded; n++) {
+
+    const float dx = b->dx[n];
+    const float dy = b->dy[n];
+    const float dz = b->dz[n];
+
+    /* Compute distance */
+    const float r2 = dx * dx + dy * dy + dz * dz;
+    const float r_inv = 1.f / sqrtf(r2);
+
+    /* Compute all derivatives */
+    struct potential_derivatives_M2L pot;
+    potential_derivatives_compute_M2L(dx, dy, dz, r2, r_inv, b->eps[n],
+                                      periodic, rs_inv, &pot);
+
+    /* Do the M2L tensor multiplication */
+    const float M_000 = b->M_000[n];
+
+    /* 0th order terms (start of rank 0) */
+    b->F_000[n] = M_000 * pot.D_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+
+    /* 1st order terms (start of rank 1) */
+    b->F_001[n] = M_000 * pot.D_001;
+    b->F_010[n] = M_000 * pot.D_010;
+    b->F_100[n] = M_000 * pot.D_100;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+
+    const float M_002 = b->M_002[n];
+    const float M_011 = b->M_011[n];
+    const float M_020 = b->M_020[n];
+    const float M_101 = b->M_101[n];
+    const float M_110 = b->M_110[n];
+    const float M_200 = b->M_200[n];
+
+    /* 2nd order terms (contribution to rank 0) */
+    b->F_000[n] += M_002 * pot.D_002 + M_011 * pot.D_011 + M_020 * pot.D_020 +
+                   M_101 * pot.D_101 + M_110 * pot.D_110 + M_200 * pot.D_200;
+
+    /* 2nd order terms (start of rank 2) */
+    b->F_002[n] = M_000 * pot.D_002;
+    b->F_011[n] = M_000 * pot.D_011;
+    b->F_020[n] = M_000 * pot.D_020;
+    b->F_101[n] = M_000 * pot.D_101;
+    b->F_110[n] = M_000 * pot.D_110;
+    b->F_200[n] = M_000 * pot.D_200;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+
+    const float M_003 = b->M_003[n];
+    const float M_012 = b->M_012[n];
+    const float M_021 = b->M_021[n];
+    const float M_030 = b->M_030[n];
+    const float M_102 = b->M_102[n];
+    const float M_111 = b->M_111[n];
+    const float M_120 = b->M_120[n];
+    const float M_201 = b->M_201[n];
+    const float M_210 = b->M_210[n];
+    const float M_300 = b->M_300[n];
+
+    /* 3rd order terms (contribution to rank 0) */
+    b->F_000[n] += M_003 * pot.D_003 + M_012 * pot.D_012 + M_021 * pot.D_021 +
+                   M_030 * pot.D_030 + M_102 * pot.D_102 + M_111 * pot.D_111 +
+                   M_120 * pot.D_120 + M_201 * pot.D_201 + M_210 * pot.D_210 +
+                   M_300 * pot.D_300;
+
+    /* 3rd order terms (contribution to rank 1) */
+    b->F_001[n] += M_002 * pot.D_003 + M_011 * pot.D_012 + M_020 * pot.D_021 +
+                   M_101 * pot.D_102 + M_110 * pot.D_111 + M_200 * pot.D_201;
+    b->F_010[n] += M_002 * pot.D_012 + M_011 * pot.D_021 + M_020 * pot.D_030 +
+                   M_101 * pot.D_111 + M_110 * pot.D_120 + M_200 * pot.D_210;
+    b->F_100[n] += M_002 * pot.D_102 + M_011 * pot.D_111 + M_020 * pot.D_120 +
+                   M_101 * pot.D_201 + M_110 * pot.D_210 + M_200 * pot.D_300;
+
+    /* 3rd order terms (start of rank 3) */
+    b->F_003[n] = M_000 * pot.D_003;
+    b->F_012[n] = M_000 * pot.D_012;
+    b->F_021[n] = M_000 * pot.D_021;
+    b->F_030[n] = M_000 * pot.D_030;
+    b->F_102[n] = M_000 * pot.D_102;
+    b->F_111[n] = M_000 * pot.D_111;
+    b->F_120[n] = M_000 * pot.D_120;
+    b->F_201[n] = M_000 * pot.D_201;
+    b->F_210[n] = M_000 * pot.D_210;
+    b->F_300[n] = M_000 * pot.D_300;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+
+    const float M_004 = b->M_004[n];
+    const float M_013 = b->M_013[n];
+    const float M_022 = b->M_022[n];
+    const float M_031 = b->M_031[n];
+    const float M_040 = b->M_040[n];
+    const float M_103 = b->M_103[n];
+    const float M_112 = b->M_112[n];
+    const float M_121 = b->M_121[n];
+    const float M_130 = b->M_130[n];
+    const float M_202 = b->M_202[n];
+    const float M_211 = b->M_211[n];
+    const float M_220 = b->M_220[n];
+    const float M_301 = b->M_301[n];
+    const float M_310 = b->M_310[n];
+    const float M_400 = b->M_400[n];
+
+    /* 4th order terms (contribution to rank 0) */
+    b->F_000[n] += M_004 * pot.D_004 + M_013 * pot.D_013 + M_022 * pot.D_022 +
+                   M_031 * pot.D_031 + M_040 * pot.D_040 + M_103 * pot.D_103 +
+                   M_112 * pot.D_112 + M_121 * pot.D_121 + M_130 * pot.D_130 +
+                   M_202 * pot.D_202 + M_211 * pot.D_211 + M_220 * pot.D_220 +
+                   M_301 * pot.D_301 + M_310 * pot.D_310 + M_400 * pot.D_400;
+
+    /* 4th order terms (contribution to rank 1) */
+    b->F_001[n] += M_003 * pot.D_004 + M_012 * pot.D_013 + M_021 * pot.D_022 +
+                   M_030 * pot.D_031 + M_102 * pot.D_103 + M_111 * pot.D_112 +
+                   M_120 * pot.D_121 + M_201 * pot.D_202 + M_210 * pot.D_211 +
+                   M_300 * pot.D_301;
+    b->F_010[n] += M_003 * pot.D_013 + M_012 * pot.D_022 + M_021 * pot.D_031 +
+                   M_030 * pot.D_040 + M_102 * pot.D_112 + M_111 * pot.D_121 +
+                   M_120 * pot.D_130 + M_201 * pot.D_211 + M_210 * pot.D_220 +
+                   M_300 * pot.D_310;
+    b->F_100[n] += M_003 * pot.D_103 + M_012 * pot.D_112 + M_021 * pot.D_121 +
+                   M_030 * pot.D_130 + M_102 * pot.D_202 + M_111 * pot.D_211 +
+                   M_120 * pot.D_220 + M_201 * pot.D_301 + M_210 * pot.D_310 +
+                   M_300 * pot.D_400;
+
+    /* 4th order terms (contribution to rank 2) */
+    b->F_002[n] += M_002 * pot.D_004 + M_011 * pot.D_013 + M_020 * pot.D_022 +
+                   M_101 * pot.D_103 + M_110 * pot.D_112 + M_200 * pot.D_202;
+    b->F_011[n] += M_002 * pot.D_013 + M_011 * pot.D_022 + M_020 * pot.D_031 +
+                   M_101 * pot.D_112 + M_110 * pot.D_121 + M_200 * pot.D_211;
+    b->F_020[n] += M_002 * pot.D_022 + M_011 * pot.D_031 + M_020 * pot.D_040 +
+                   M_101 * pot.D_121 + M_110 * pot.D_130 + M_200 * pot.D_220;
+    b->F_101[n] += M_002 * pot.D_103 + M_011 * pot.D_112 + M_020 * pot.D_121 +
+                   M_101 * pot.D_202 + M_110 * pot.D_211 + M_200 * pot.D_301;
+    b->F_110[n] += M_002 * pot.D_112 + M_011 * pot.D_121 + M_020 * pot.D_130 +
+                   M_101 * pot.D_211 + M_110 * pot.D_220 + M_200 * pot.D_310;
+    b->F_200[n] += M_002 * pot.D_202 + M_011 * pot.D_211 + M_020 * pot.D_220 +
+                   M_101 * pot.D_301 + M_110 * pot.D_310 + M_200 * pot.D_400;
+
+    /* 4th order terms (start of rank 4) */
+    b->F_004[n] = M_000 * pot.D_004;
+    b->F_013[n] = M_000 * pot.D_013;
+    b->F_022[n] = M_000 * pot.D_022;
+    b->F_031[n] = M_000 * pot.D_031;
+    b->F_040[n] = M_000 * pot.D_040;
+    b->F_103[n] = M_000 * pot.D_103;
+    b->F_112[n] = M_000 * pot.D_112;
+    b->F_121[n] = M_000 * pot.D_121;
+    b->F_130[n] = M_000 * pot.D_130;
+    b->F_202[n] = M_000 * pot.D_202;
+    b->F_211[n] = M_000 * pot.D_211;
+    b->F_220[n] = M_000 * pot.D_220;
+    b->F_301[n] = M_000 * pot.D_301;
+    b->F_310[n] = M_000 * pot.D_310;
+    b->F_400[n] = M_000 * pot.D_400;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+
+    const float M_005 = b->M_005[n];
+    const float M_014 = b->M_014[n];
+    const float M_023 = b->M_023[n];
+    const float M_032 = b->M_032[n];
+    const float M_041 = b->M_041[n];
+    const float M_050 = b->M_050[n];
+    const float M_104 = b->M_104[n];
+    const float M_113 = b->M_113[n];
+    const float M_122 = b->M_122[n];
+    const float M_131 = b->M_131[n];
+    const float M_140 = b->M_140[n];
+    const float M_203 = b->M_203[n];
+    const float M_212 = b->M_212[n];
+    const float M_221 = b->M_221[n];
+    const float M_230 = b->M_230[n];
+    const float M_302 = b->M_302[n];
+    const float M_311 = b->M_311[n];
+    const float M_320 = b->M_320[n];
+    const float M_401 = b->M_401[n];
+    const float M_410 = b->M_410[n];
+    const float M_500 = b->M_500[n];
+
+    /* 5th order terms (contribution to rank 0) */
+    b->F_000[n] += M_005 * pot.D_005 + M_014 * pot.D_014 + M_023 * pot.D_023 +
+                   M_032 * pot.D_032 + M_041 * pot.D_041 + M_050 * pot.D_050 +
+                   M_104 * pot.D_104 + M_113 * pot.D_113 + M_122 * pot.D_122 +
+                   M_131 * pot.D_131 + M_140 * pot.D_140 + M_203 * pot.D_203 +
+                   M_212 * pot.D_212 + M_221 * pot.D_221 + M_230 * pot.D_230 +
+                   M_302 * pot.D_302 + M_311 * pot.D_311 + M_320 * pot.D_320 +
+                   M_401 * pot.D_401 + M_410 * pot.D_410 + M_500 * pot.D_500;
+
+    /* 5th order terms (contribution to rank 1) */
+    b->F_001[n] += M_004 * pot.D_005 + M_013 * pot.D_014 + M_022 * pot.D_023 +
+                   M_031 * pot.D_032 + M_040 * pot.D_041 + M_103 * pot.D_104 +
+                   M_112 * pot.D_113 + M_121 * pot.D_122 + M_130 * pot.D_131 +
+                   M_202 * pot.D_203 + M_211 * pot.D_212 + M_220 * pot.D_221 +
+                   M_301 * pot.D_302 + M_310 * pot.D_311 + M_400 * pot.D_401;
+    b->F_010[n] += M_004 * pot.D_014 + M_013 * pot.D_023 + M_022 * pot.D_032 +
+                   M_031 * pot.D_041 + M_040 * pot.D_050 + M_103 * pot.D_113 +
+                   M_112 * pot.D_122 + M_121 * pot.D_131 + M_130 * pot.D_140 +
+                   M_202 * pot.D_212 + M_211 * pot.D_221 + M_220 * pot.D_230 +
+                   M_301 * pot.D_311 + M_310 * pot.D_320 + M_400 * pot.D_410;
+    b->F_100[n] += M_004 * pot.D_104 + M_013 * pot.D_113 + M_022 * pot.D_122 +
+                   M_031 * pot.D_131 + M_040 * pot.D_140 + M_103 * pot.D_203 +
+                   M_112 * pot.D_212 + M_121 * pot.D_221 + M_130 * pot.D_230 +
+                   M_202 * pot.D_302 + M_211 * pot.D_311 + M_220 * pot.D_320 +
+                   M_301 * pot.D_401 + M_310 * pot.D_410 + M_400 * pot.D_500;
+
+    /* 5th order terms (contribution to rank 2) */
+    b->F_002[n] += M_003 * pot.D_005 + M_012 * pot.D_014 + M_021 * pot.D_023 +
+                   M_030 * pot.D_032 + M_102 * pot.D_104 + M_111 * pot.D_113 +
+                   M_120 * pot.D_122 + M_201 * pot.D_203 + M_210 * pot.D_212 +
+                   M_300 * pot.D_302;
+    b->F_011[n] += M_003 * pot.D_014 + M_012 * pot.D_023 + M_021 * pot.D_032 +
+                   M_030 * pot.D_041 + M_102 * pot.D_113 + M_111 * pot.D_122 +
+                   M_120 * pot.D_131 + M_201 * pot.D_212 + M_210 * pot.D_221 +
+                   M_300 * pot.D_311;
+    b->F_020[n] += M_003 * pot.D_023 + M_012 * pot.D_032 + M_021 * pot.D_041 +
+                   M_030 * pot.D_050 + M_102 * pot.D_122 + M_111 * pot.D_131 +
+                   M_120 * pot.D_140 + M_201 * pot.D_221 + M_210 * pot.D_230 +
+                   M_300 * pot.D_320;
+    b->F_101[n] += M_003 * pot.D_104 + M_012 * pot.D_113 + M_021 * pot.D_122 +
+                   M_030 * pot.D_131 + M_102 * pot.D_203 + M_111 * pot.D_212 +
+                   M_120 * pot.D_221 + M_201 * pot.D_302 + M_210 * pot.D_311 +
+                   M_300 * pot.D_401;
+    b->F_110[n] += M_003 * pot.D_113 + M_012 * pot.D_122 + M_021 * pot.D_131 +
+                   M_030 * pot.D_140 + M_102 * pot.D_212 + M_111 * pot.D_221 +
+                   M_120 * pot.D_230 + M_201 * pot.D_311 + M_210 * pot.D_320 +
+                   M_300 * pot.D_410;
+    b->F_200[n] += M_003 * pot.D_203 + M_012 * pot.D_212 + M_021 * pot.D_221 +
+                   M_030 * pot.D_230 + M_102 * pot.D_302 + M_111 * pot.D_311 +
+                   M_120 * pot.D_320 + M_201 * pot.D_401 + M_210 * pot.D_410 +
+                   M_300 * pot.D_500;
+
+    /* 5th order terms (contribution to rank 3) */
+    b->F_003[n] += M_002 * pot.D_005 + M_011 * pot.D_014 + M_020 * pot.D_023 +
+                   M_101 * pot.D_104 + M_110 * pot.D_113 + M_200 * pot.D_203;
+    b->F_012[n] += M_002 * pot.D_014 + M_011 * pot.D_023 + M_020 * pot.D_032 +
+                   M_101 * pot.D_113 + M_110 * pot.D_122 + M_200 * pot.D_212;
+    b->F_021[n] += M_002 * pot.D_023 + M_011 * pot.D_032 + M_020 * pot.D_041 +
+                   M_101 * pot.D_122 + M_110 * pot.D_131 + M_200 * pot.D_221;
+    b->F_030[n] += M_002 * pot.D_032 + M_011 * pot.D_041 + M_020 * pot.D_050 +
+                   M_101 * pot.D_131 + M_110 * pot.D_140 + M_200 * pot.D_230;
+    b->F_102[n] += M_002 * pot.D_104 + M_011 * pot.D_113 + M_020 * pot.D_122 +
+                   M_101 * pot.D_203 + M_110 * pot.D_212 + M_200 * pot.D_302;
+    b->F_111[n] += M_002 * pot.D_113 + M_011 * pot.D_122 + M_020 * pot.D_131 +
+                   M_101 * pot.D_212 + M_110 * pot.D_221 + M_200 * pot.D_311;
+    b->F_120[n] += M_002 * pot.D_122 + M_011 * pot.D_131 + M_020 * pot.D_140 +
+                   M_101 * pot.D_221 + M_110 * pot.D_230 + M_200 * pot.D_320;
+    b->F_201[n] += M_002 * pot.D_203 + M_011 * pot.D_212 + M_020 * pot.D_221 +
+                   M_101 * pot.D_302 + M_110 * pot.D_311 + M_200 * pot.D_401;
+    b->F_210[n] += M_002 * pot.D_212 + M_011 * pot.D_221 + M_020 * pot.D_230 +
+                   M_101 * pot.D_311 + M_110 * pot.D_320 + M_200 * pot.D_410;
+    b->F_300[n] += M_002 * pot.D_302 + M_011 * pot.D_311 + M_020 * pot.D_320 +
+                   M_101 * pot.D_401 + M_110 * pot.D_410 + M_200 * pot.D_500;
+
+    /* 5th order terms (start of rank 5) */
+    b->F_005[n] = M_000 * pot.D_005;
+    b->F_014[n] = M_000 * pot.D_014;
+    b->F_023[n] = M_000 * pot.D_023;
+    b->F_032[n] = M_000 * pot.D_032;
+    b->F_041[n] = M_000 * pot.D_041;
+    b->F_050[n] = M_000 * pot.D_050;
+    b->F_104[n] = M_000 * pot.D_104;
+    b->F_113[n] = M_000 * pot.D_113;
+    b->F_122[n] = M_000 * pot.D_122;
+    b->F_131[n] = M_000 * pot.D_131;
+    b->F_140[n] = M_000 * pot.D_140;
+    b->F_203[n] = M_000 * pot.D_203;
+    b->F_212[n] = M_000 * pot.D_212;
+    b->F_221[n] = M_000 * pot.D_221;
+    b->F_230[n] = M_000 * pot.D_230;
+    b->F_302[n] = M_000 * pot.D_302;
+    b->F_311[n] = M_000 * pot.D_311;
+    b->F_320[n] = M_000 * pot.D_320;
+    b->F_401[n] = M_000 * pot.D_401;
+    b->F_410[n] = M_000 * pot.D_410;
+    b->F_500[n] = M_000 * pot.D_500;
+
+#endif
+  }
+}
+
+/**
+ * @brief Add the result of one interaction of a computed #gravity_M2L_batch
+ * to its field tensor.
+ *
+ * @param l_b The field tensor receiving the interaction.
+ * @param b The #gravity_M2L_batch.
+ * @param n The index of the interaction in the batch.
+ */
+__attribute__((nonnull)) INLINE static void gravity_M2L_batch_apply(
+    struct grav_tensor *restrict l_b,
+    const struct gravity_M2L_batch *restrict b, const int n) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+  /* Count all interactions (see gravity_M2L_apply() for the atomics) */
+  accumulate_add_ll(&l_b->num_interacted, b->num_gpart[n]);
+#endif
+
+#ifdef SWIFT_GRAVITY_FORCE_CHECKS
+  /* Count tree interactions */
+  accumulate_add_ll(&l_b->num_interacted_tree, b->num_gpart[n]);
+#endif
+
+  /* Record that this tensor has received contributions */
+  l_b->interacted = 1;
+
+  l_b->F_000 += b->F_000[n];
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  l_b->F_001 += b->F_001[n];
+  l_b->F_010 += b->F_010[n];
+  l_b->F_100 += b->F_100[n];
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  l_b->F_002 += b->F_002[n];
+  l_b->F_011 += b->F_011[n];
+  l_b->F_020 += b->F_020[n];
+  l_b->F_101 += b->F_101[n];
+  l_b->F_110 += b->F_110[n];
+  l_b->F_200 += b->F_200[n];
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  l_b->F_003 += b->F_003[n];
+  l_b->F_012 += b->F_012[n];
+  l_b->F_021 += b->F_021[n];
+  l_b->F_030 += b->F_030[n];
+  l_b->F_102 += b->F_102[n];
+  l_b->F_111 += b->F_111[n];
+  l_b->F_120 += b->F_120[n];
+  l_b->F_201 += b->F_201[n];
+  l_b->F_210 += b->F_210[n];
+  l_b->F_300 += b->F_300[n];
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  l_b->F_004 += b->F_004[n];
+  l_b->F_013 += b->F_013[n];
+  l_b->F_022 += b->F_022[n];
+  l_b->F_031 += b->F_031[n];
+  l_b->F_040 += b->F_040[n];
+  l_b->F_103 += b->F_103[n];
+  l_b->F_112 += b->F_112[n];
+  l_b->F_121 += b->F_121[n];
+  l_b->F_130 += b->F_130[n];
+  l_b->F_202 += b->F_202[n];
+  l_b->F_211 += b->F_211[n];
+  l_b->F_220 += b->F_220[n];
+  l_b->F_301 += b->F_301[n];
+  l_b->F_310 += b->F_310[n];
+  l_b->F_400 += b->F_400[n];
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  l_b->F_005 += b->F_005[n];
+  l_b->F_014 += b->F_014[n];
+  l_b->F_023 += b->F_023[n];
+  l_b->F_032 += b->F_032[n];
+  l_b->F_041 += b->F_041[n];
+  l_b->F_050 += b->F_050[n];
+  l_b->F_104 += b->F_104[n];
+  l_b->F_113 += b->F_113[n];
+  l_b->F_122 += b->F_122[n];
+  l_b->F_131 += b->F_131[n];
+  l_b->F_140 += b->F_140[n];
+  l_b->F_203 += b->F_203[n];
+  l_b->F_212 += b->F_212[n];
+  l_b->F_221 += b->F_221[n];
+  l_b->F_230 += b->F_230[n];
+  l_b->F_302 += b->F_302[n];
+  l_b->F_311 += b->F_311[n];
+  l_b->F_320 += b->F_320[n];
+  l_b->F_401 += b->F_401[n];
+  l_b->F_410 += b->F_410[n];
+  l_b->F_500 += b->F_500[n];
+#endif
+}
+
+#endif /* SWIFT_MULTIPOLE_BATCH_H */
@@ -219,6 +219,30 @@ struct gravity_tensors {
   };
 } SWIFT_STRUCT_ALIGN;
 
+/**
+ * @brief The part of a #gravity_tensors exchanged between nodes.
+ *
+ * The field tensor only accumulates the interactions of local cells, so it
+ * is not shipped along with the multipole.
+ */
+struct gravity_tensors_pack {
+
+  /*! Multipole mass */
+  struct multipole m_pole;
+
+  /*! Centre of mass of the matter dsitribution */
+  double CoM[3];
+
+  /*! Centre of mass of the matter dsitribution at the last rebuild */
+  double CoM_rebuild[3];
+
+  /*! Upper limit of the CoM<->gpart distance */
+  double r_max;
+
+  /*! Upper limit of the CoM<->gpart distance at the last rebuild */
+  double r_max_rebuild;
+};
+
 /**
  * @brief Values returned by the M2P kernel.
  */
@@ -45,7 +45,11 @@ struct threadpool;
 #define bpart_align 128
 #define sink_align 128
 
-/* Import the right hydro particle definition */
+/* Import the right hydro particle definition. The schemes whose density
+ * (resp. force) loop can be run from the vectorisation caches (see cache.h)
+ * declare HYDRO_VEC_DENSITY_LOOP (resp. HYDRO_VEC_FORCE_LOOP). The vectorised
+ * loops do not collect the adaptive softening terms. There is no vectorised
+ * gradient loop, and the SPHENIX force loop is still scalar. */
 #if defined(NONE_SPH)
 #include "./hydro/None/hydro_part.h"
 #define hydro_need_extra_init_loop 0
@@ -55,6 +59,10 @@ struct threadpool;
 #elif defined(GADGET2_SPH)
 #include "./hydro/Gadget2/hydro_part.h"
 #define hydro_need_extra_init_loop 0
+#ifndef ADAPTIVE_SOFTENING
+#define HYDRO_VEC_DENSITY_LOOP
+#define HYDRO_VEC_FORCE_LOOP
+#endif
 #elif defined(HOPKINS_PE_SPH)
 #include "./hydro/PressureEntropy/hydro_part.h"
 #define hydro_need_extra_init_loop 1
@@ -84,6 +92,9 @@ struct threadpool;
 #include "./hydro/SPHENIX/hydro_part.h"
 #define hydro_need_extra_init_loop 0
 #define EXTRA_HYDRO_LOOP
+#ifndef ADAPTIVE_SOFTENING
+#define HYDRO_VEC_DENSITY_LOOP
+#endif
 #elif defined(GASOLINE_SPH)
 #include "./hydro/Gasoline/hydro_part.h"
 #define hydro_need_extra_init_loop 0
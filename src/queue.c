@@ -21,10 +21,22 @@
 #include <config.h>
 
 /* Some standard headers. */
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Futex system call. */
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
 /* MPI headers. */
 #ifdef WITH_MPI
 #include <mpi.h>
@@ -38,6 +50,151 @@
 #include "error.h"
 #include "memswap.h"
 
+/* Names of the contention counters. */
+const char *queue_counter_names[queue_counter_count] = {
+    "steal attempts", "steals",        "local steals", "remote steals",
+    "steal aborts",   "lock failures", "conflicts",     "queue busy",
+    "sleeps",         "wake-ups",      "spurious wake-ups"};
+
+/**
+ * @brief Get the priority bucket of a task in the deque back-end.
+ *
+ * The buckets are built from the binary exponent of the task weight, so
+ * that tasks of roughly the same weight share a bucket. Higher buckets have
+ * a higher priority.
+ *
+ * @param weight The weight of the task.
+ */
+__attribute__((always_inline)) INLINE static int queue_deque_bucket(
+    const float weight) {
+
+  union {
+    float as_float;
+    unsigned int as_int;
+  } w = {weight};
+
+  const int exponent = (int)((w.as_int >> 23) & 0xff) - 127;
+  if (exponent <= 0) return 0;
+  return min(exponent >> queue_deque_bucket_shift, queue_deque_nr_buckets - 1);
+}
+
+/**
+ * @brief Allocate a buffer for a #queue_deque.
+ *
+ * @param size The number of elements, must be a power of two.
+ */
+static struct queue_deque_buffer *queue_deque_buffer_alloc(
+    const long long size) {
+
+  struct queue_deque_buffer *buff = (struct queue_deque_buffer *)malloc(
+      sizeof(struct queue_deque_buffer) + size * sizeof(int));
+  if (buff == NULL) error("Failed to allocate deque buffer.");
+  buff->mask = size - 1;
+  buff->prev = NULL;
+  return buff;
+}
+
+/**
+ * @brief Double the size of the buffer of a #queue_deque. Owner only.
+ *
+ * @param d The #queue_deque.
+ * @param top The current top of the deque.
+ * @param bottom The current bottom of the deque.
+ */
+static void queue_deque_grow(struct queue_deque *d, const long long top,
+                             const long long bottom) {
+
+  struct queue_deque_buffer *old = d->buffer;
+  struct queue_deque_buffer *buff =
+      queue_deque_buffer_alloc((old->mask + 1) * queue_sizegrow);
+
+  for (long long k = top; k < bottom; k++)
+    buff->tid[k & buff->mask] = old->tid[k & old->mask];
+
+  /* Keep the old buffer, a thief may still be reading from it. */
+  buff->prev = old;
+  __atomic_store_n(&d->buffer, buff, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Push a task offset at the bottom of a #queue_deque. Owner only.
+ *
+ * @param d The #queue_deque.
+ * @param tid The offset of the task.
+ */
+static void queue_deque_push(struct queue_deque *d, const int tid) {
+
+  const long long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+  const long long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+  if (b - t > d->buffer->mask) queue_deque_grow(d, t, b);
+
+  struct queue_deque_buffer *buff = d->buffer;
+  __atomic_store_n(&buff->tid[b & buff->mask], tid, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Pop a task offset from the bottom of a #queue_deque. Owner only.
+ *
+ * @param d The #queue_deque.
+ *
+ * @return The task offset or #queue_deque_empty.
+ */
+static int queue_deque_take(struct queue_deque *d) {
+
+  const long long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+  struct queue_deque_buffer *buff = d->buffer;
+  __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  long long t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+  /* Empty deque? */
+  if (t > b) {
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    return queue_deque_empty;
+  }
+
+  int tid = __atomic_load_n(&buff->tid[b & buff->mask], __ATOMIC_RELAXED);
+
+  /* Last element, race the thieves for it. */
+  if (t == b) {
+    if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, /*weak=*/0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+      tid = queue_deque_empty;
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+  }
+
+  return tid;
+}
+
+/**
+ * @brief Steal a task offset from the top of a #queue_deque.
+ *
+ * @param d The #queue_deque.
+ *
+ * @return The task offset, #queue_deque_empty or #queue_deque_abort if we
+ * lost a race against another thread.
+ */
+static int queue_deque_steal(struct queue_deque *d) {
+
+  long long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  const long long b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+
+  if (t >= b) return queue_deque_empty;
+
+  struct queue_deque_buffer *buff =
+      __atomic_load_n(&d->buffer, __ATOMIC_ACQUIRE);
+  const int tid = __atomic_load_n(&buff->tid[t & buff->mask], __ATOMIC_RELAXED);
+
+  if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, /*weak=*/0,
+                                   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    return queue_deque_abort;
+
+  return tid;
+}
+
 /**
  * @brief Push the task at the given index up the heap until it is either at the
  * top or smaller than its parent.
@@ -105,7 +262,8 @@ int queue_sift_down(struct queue *q, int ind) {
 /**
  * @brief Enqueue all tasks in the incoming DEQ.
  *
- * @param q The #queue, assumed to be locked.
+ * @param q The #queue, assumed to be locked (heap back-end) or called by its
+ * owner (deque back-end).
  */
 void queue_get_incoming(struct queue *q) {
 
@@ -122,6 +280,15 @@ void queue_get_incoming(struct queue *q) {
     const int offset = atomic_swap(&q->tid_incoming[ind], -1);
     atomic_inc(&q->first_incoming);
 
+    /* Deque back-end? Just push it on the bucket matching its weight. */
+    if (q->type == queue_type_deque) {
+      const int bucket = queue_deque_bucket(q->tasks[offset].weight);
+      queue_deque_push(&q->deques[bucket], offset);
+      atomic_inc(&q->count);
+      atomic_dec(&q->count_incoming);
+      continue;
+    }
+
     /* Does the queue need to be grown? */
     if (q->count == q->size) {
       struct queue_entry *temp;
@@ -152,6 +319,54 @@ void queue_get_incoming(struct queue *q) {
   }
 }
 
+/**
+ * @brief Insert a task into a #queue using the deque back-end.
+ *
+ * Only the owner of the queue may drain the incoming DEQ, so we cannot wait
+ * for a free slot while the owner may itself be inserting. Tasks that do not
+ * fit in the DEQ go to the overflow list instead, which the owner drains
+ * under the queue lock.
+ *
+ * @param q The #queue.
+ * @param t The #task.
+ */
+static void queue_deque_insert(struct queue *q, struct task *t) {
+
+  const int tid = t - q->tasks;
+
+  /* Claim a slot in the DEQ, if there is a free one. */
+  unsigned int last = q->last_incoming;
+  while (last - q->first_incoming < queue_incoming_size) {
+    const unsigned int old = atomic_cas(&q->last_incoming, last, last + 1);
+    if (old == last) {
+
+      /* The owner has cleared the slot before moving past it. */
+      const int ind = last % queue_incoming_size;
+      if (atomic_cas(&q->tid_incoming[ind], -1, tid) != -1)
+        error("Slot of the incoming DEQ is still in use.");
+
+      atomic_inc(&q->count_incoming);
+      return;
+    }
+    last = old;
+  }
+
+  /* The DEQ is full, use the overflow list. */
+  if (lock_lock(&q->lock) != 0) error("Locking the qlock failed.\n");
+  if (q->count_overflow == q->size_overflow) {
+    q->size_overflow =
+        q->size_overflow > 0 ? q->size_overflow * queue_sizegrow
+                             : queue_sizeinit;
+    q->tid_overflow =
+        (int *)realloc(q->tid_overflow, q->size_overflow * sizeof(int));
+    if (q->tid_overflow == NULL) error("Failed to grow queue overflow list.");
+  }
+  q->tid_overflow[q->count_overflow] = tid;
+  atomic_inc(&q->count_overflow);
+  atomic_inc(&q->count_incoming);
+  if (lock_unlock(&q->lock) != 0) error("Unlocking the qlock failed.\n");
+}
+
 /**
  * @brief Insert a used tasks into the given queue.
  *
@@ -159,6 +374,12 @@ void queue_get_incoming(struct queue *q) {
  * @param t The #task.
  */
 void queue_insert(struct queue *q, struct task *t) {
+
+  if (q->type == queue_type_deque) {
+    queue_deque_insert(q, t);
+    return;
+  }
+
   /* Get an index in the DEQ. */
   const int ind = atomic_inc(&q->last_incoming) % queue_incoming_size;
 
@@ -188,8 +409,12 @@ void queue_insert(struct queue *q, struct task *t) {
  *
  * @param q The #queue.
  * @param tasks List of tasks to which the queue indices refer to.
+ * @param type The back-end to use, a #queue_types.
  */
-void queue_init(struct queue *q, struct task *tasks) {
+void queue_init(struct queue *q, struct task *tasks, enum queue_types type) {
+
+  /* Set the back-end. */
+  q->type = type;
 
   /* Allocate the task list if needed. */
   q->size = queue_sizeinit;
@@ -216,18 +441,277 @@ void queue_init(struct queue *q, struct task *tasks) {
   q->first_incoming = 0;
   q->last_incoming = 0;
   q->count_incoming = 0;
+
+  /* Init the work-stealing deques. */
+  for (int k = 0; k < queue_deque_nr_buckets; k++) {
+    q->deques[k].top = 0;
+    q->deques[k].bottom = 0;
+    q->deques[k].buffer =
+        (type == queue_type_deque)
+            ? queue_deque_buffer_alloc(queue_deque_sizeinit)
+            : NULL;
+  }
+  q->tid_overflow = NULL;
+  q->size_overflow = 0;
+  q->count_overflow = 0;
+
+  /* Init the parking spot. */
+  q->sleep_seq = 0;
+  q->sleepers = 0;
+  q->wake_pending = 0;
+#ifndef __linux__
+  if (pthread_mutex_init(&q->sleep_mutex, NULL) != 0 ||
+      pthread_cond_init(&q->sleep_cond, NULL) != 0)
+    error("Failed to init queue sleep mutex/condition.");
+#endif
+
+  queue_reset_counters(q);
+}
+
+/**
+ * @brief Reset the contention counters of the given queue.
+ *
+ * @param q The #queue.
+ */
+void queue_reset_counters(struct queue *q) {
+  for (int k = 0; k < queue_counter_count; k++) q->counters[k] = 0;
+}
+
+/**
+ * @brief Register a runner that is about to park on a #queue.
+ *
+ * The runner must re-check for work after this call and then either
+ * #queue_sleep with the returned sequence number or #queue_sleep_cancel.
+ * Any #queue_wake issued after this call prevents the runner from
+ * sleeping.
+ *
+ * @param q The #queue.
+ *
+ * @return The current wake-up sequence number.
+ */
+int queue_sleep_prepare(struct queue *q) {
+  atomic_inc(&q->sleepers);
+  return __atomic_load_n(&q->sleep_seq, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Account for a runner leaving the parking spot of a #queue.
+ *
+ * The runner consumes one of the pending single wake-ups, if any, whether
+ * it was meant for it or not, so that the count never exceeds the number
+ * of runners that could still receive them.
+ *
+ * @param q The #queue.
+ */
+static void queue_sleep_leave(struct queue *q) {
+  atomic_dec(&q->sleepers);
+  int pending = q->wake_pending;
+  while (pending > 0) {
+    const int old = atomic_cas(&q->wake_pending, pending, pending - 1);
+    if (old == pending) break;
+    pending = old;
+  }
+}
+
+/**
+ * @brief Park the calling runner on a #queue until it is woken up.
+ *
+ * The runner also wakes up after #queue_sleep_timeout_ns as a safety net
+ * against tasks blocked by cell locks that nobody got woken up for.
+ *
+ * @param q The #queue.
+ * @param seq The sequence number returned by #queue_sleep_prepare.
+ *
+ * @return 1 if the runner was woken up, 0 if it timed out.
+ */
+int queue_sleep(struct queue *q, int seq) {
+
+  int woken = 1;
+
+#ifdef __linux__
+  struct timespec timeout = {0, queue_sleep_timeout_ns};
+  if (syscall(SYS_futex, &q->sleep_seq, FUTEX_WAIT_PRIVATE, seq, &timeout,
+              NULL, 0) != 0 &&
+      errno == ETIMEDOUT)
+    woken = 0;
+#else
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  long long nsec = now.tv_usec * 1000LL + queue_sleep_timeout_ns;
+  struct timespec deadline = {now.tv_sec + nsec / 1000000000LL,
+                              nsec % 1000000000LL};
+  pthread_mutex_lock(&q->sleep_mutex);
+  while (q->sleep_seq == seq) {
+    if (pthread_cond_timedwait(&q->sleep_cond, &q->sleep_mutex, &deadline) ==
+        ETIMEDOUT) {
+      woken = (q->sleep_seq != seq);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&q->sleep_mutex);
+#endif
+
+  queue_sleep_leave(q);
+  return woken;
+}
+
+/**
+ * @brief Unregister a runner that found work after #queue_sleep_prepare.
+ *
+ * @param q The #queue.
+ */
+void queue_sleep_cancel(struct queue *q) { queue_sleep_leave(q); }
+
+/**
+ * @brief Wake up the runners parked on a #queue.
+ *
+ * A single wake-up is only sent if there are more parked runners than
+ * wake-ups already on their way, so that the runners that are already
+ * waking up do not absorb it.
+ *
+ * @param q The #queue.
+ * @param all Wake up all the parked runners, not just one.
+ *
+ * @return 1 if a wake-up was sent, 0 if there was nobody left to wake up.
+ */
+int queue_wake(struct queue *q, int all) {
+
+  if (!all) {
+    int pending = q->wake_pending;
+    while (1) {
+      if (pending >= q->sleepers) return 0;
+      const int old = atomic_cas(&q->wake_pending, pending, pending + 1);
+      if (old == pending) break;
+      pending = old;
+    }
+  } else if (q->sleepers == 0) {
+    return 0;
+  }
+
+  atomic_inc(&q->sleep_seq);
+  atomic_inc(&q->counters[queue_counter_wakeup]);
+
+#ifdef __linux__
+  syscall(SYS_futex, &q->sleep_seq, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1,
+          NULL, NULL, 0);
+#else
+  pthread_mutex_lock(&q->sleep_mutex);
+  if (all)
+    pthread_cond_broadcast(&q->sleep_cond);
+  else
+    pthread_cond_signal(&q->sleep_cond);
+  pthread_mutex_unlock(&q->sleep_mutex);
+#endif
+
+  return 1;
+}
+
+/**
+ * @brief Try to lock a task, unless it is known to be in conflict with the
+ * running tasks.
+ *
+ * @param t The #task.
+ * @return -1 if the task was locked, otherwise the counter of the reason why
+ * it was not.
+ */
+__attribute__((always_inline)) INLINE static int queue_try_lock(
+    struct task *t) {
+  if (task_conflicts(t)) return queue_counter_conflict;
+  if (task_lock(t)) return -1;
+  return queue_counter_lock_fail;
+}
+
+/**
+ * @brief Move the tasks of the overflow list of a #queue to its deques.
+ * Owner only.
+ *
+ * @param q The #queue.
+ */
+static void queue_deque_get_overflow(struct queue *q) {
+
+  if (lock_lock(&q->lock) != 0) error("Locking the qlock failed.\n");
+  for (int k = 0; k < q->count_overflow; k++) {
+    const int tid = q->tid_overflow[k];
+    queue_deque_push(&q->deques[queue_deque_bucket(q->tasks[tid].weight)],
+                     tid);
+    atomic_inc(&q->count);
+    atomic_dec(&q->count_incoming);
+  }
+  q->count_overflow = 0;
+  if (lock_unlock(&q->lock) != 0) error("Unlocking the qlock failed.\n");
+}
+
+/**
+ * @brief Get a task from the deques of a #queue, as its owner.
+ *
+ * Only the runner owning the queue calls this, so it is the only thread
+ * touching the bottom end of the deques and draining the incoming DEQ, and
+ * no lock is needed. Tasks are popped from the bottom of the highest
+ * non-empty priority bucket. Tasks that cannot be locked are pushed back one
+ * bucket lower, which mimics the de-prioritisation done by the heap
+ * back-end.
+ *
+ * @param q The task #queue.
+ */
+static struct task *queue_deque_gettask(struct queue *q) {
+
+  struct task *res = NULL;
+
+  /* Move any tasks from the incoming DEQ to the deques. */
+  queue_get_incoming(q);
+  if (q->count_overflow > 0) queue_deque_get_overflow(q);
+
+  /* Walk down the buckets until we find a task we can lock. */
+  int failed_tid[queue_search_window], failed_bucket[queue_search_window];
+  int nr_failed = 0, nr_conflicts = 0;
+  for (int b = queue_deque_nr_buckets - 1;
+       b >= 0 && res == NULL && nr_failed < queue_search_window; b--) {
+
+    int tid;
+    while (nr_failed < queue_search_window &&
+           (tid = queue_deque_take(&q->deques[b])) >= 0) {
+
+      const int why = queue_try_lock(&q->tasks[tid]);
+      if (why < 0) {
+        res = &q->tasks[tid];
+        atomic_dec(&q->count);
+        break;
+      }
+
+      if (why == queue_counter_conflict) nr_conflicts++;
+      failed_tid[nr_failed] = tid;
+      failed_bucket[nr_failed] = max(b - 1, 0);
+      nr_failed++;
+    }
+  }
+
+  /* Put back whatever we could not lock, with a lower priority. */
+  for (int k = 0; k < nr_failed; k++)
+    queue_deque_push(&q->deques[failed_bucket[k]], failed_tid[k]);
+  if (nr_failed > nr_conflicts)
+    atomic_add(&q->counters[queue_counter_lock_fail], nr_failed - nr_conflicts);
+  if (nr_conflicts > 0)
+    atomic_add(&q->counters[queue_counter_conflict], nr_conflicts);
+
+  return res;
 }
 
 /**
  * @brief Get a task free of dependencies and conflicts.
  *
+ * With the deque back-end, this must only be called by the runner owning
+ * the queue.
+ *
  * @param q The task #queue.
  * @param prev The previous #task extracted from this #queue.
- * @param blocking Block until access to the queue is granted.
+ * @param blocking Block until access to the queue is granted (heap back-end
+ * only, the owner of a deque never waits).
  */
 struct task *queue_gettask(struct queue *q, const struct task *prev,
                            int blocking) {
 
+  if (q->type == queue_type_deque) return queue_deque_gettask(q);
+
   swift_lock_type *qlock = &q->lock;
   struct task *res = NULL;
 
@@ -235,7 +719,10 @@ struct task *queue_gettask(struct queue *q, const struct task *prev,
   if (blocking) {
     if (lock_lock(qlock) != 0) error("Locking the qlock failed.\n");
   } else {
-    if (lock_trylock(qlock) != 0) return NULL;
+    if (lock_trylock(qlock) != 0) {
+      atomic_inc(&q->counters[queue_counter_busy]);
+      return NULL;
+    }
   }
 
   /* Fill any tasks from the incoming DEQ. */
@@ -257,7 +744,9 @@ struct task *queue_gettask(struct queue *q, const struct task *prev,
   for (ind = 0; ind < old_qcount; ind++) {
 
     /* Try to lock the next task. */
-    if (task_lock(&qtasks[entries[ind].tid])) break;
+    const int why = queue_try_lock(&qtasks[entries[ind].tid]);
+    if (why < 0) break;
+    q->counters[why] += 1;
 
     /* Should we de-prioritize this task? */
 
@@ -308,10 +797,79 @@ struct task *queue_gettask(struct queue *q, const struct task *prev,
   return res;
 }
 
+/**
+ * @brief Steal a task from a #queue we do not own.
+ *
+ * With the heap back-end, this is the same as a non-blocking
+ * queue_gettask(). With the deque back-end, tasks are taken from the top of
+ * the highest non-empty bucket without taking the queue lock. Stolen tasks
+ * that cannot be locked are handed back to the owner via the incoming DEQ.
+ * Tasks that the owner has not moved to its deques yet cannot be stolen.
+ *
+ * @param q The task #queue.
+ * @param prev The previous #task extracted from this #queue.
+ */
+struct task *queue_steal(struct queue *q, const struct task *prev) {
+
+  atomic_inc(&q->counters[queue_counter_steal_attempt]);
+
+  if (q->type == queue_type_heap) {
+    struct task *res = queue_gettask(q, prev, 0);
+    if (res != NULL) atomic_inc(&q->counters[queue_counter_steal]);
+    return res;
+  }
+
+  int tries = 0;
+  for (int b = queue_deque_nr_buckets - 1;
+       b >= 0 && tries < queue_search_window; b--) {
+
+    while (tries < queue_search_window) {
+
+      const int tid = queue_deque_steal(&q->deques[b]);
+      if (tid == queue_deque_empty) break;
+
+      tries++;
+      if (tid == queue_deque_abort) {
+        atomic_inc(&q->counters[queue_counter_steal_abort]);
+        continue;
+      }
+
+      struct task *t = &q->tasks[tid];
+      atomic_dec(&q->count);
+      const int why = queue_try_lock(t);
+      if (why < 0) {
+        atomic_inc(&q->counters[queue_counter_steal]);
+        return t;
+      }
+
+      /* Give it back to the owner. */
+      atomic_inc(&q->counters[why]);
+      queue_insert(q, t);
+    }
+  }
+
+  return NULL;
+}
+
 void queue_clean(struct queue *q) {
 
   free(q->entries);
   free(q->tid_incoming);
+  free(q->tid_overflow);
+
+  for (int k = 0; k < queue_deque_nr_buckets; k++) {
+    struct queue_deque_buffer *buff = q->deques[k].buffer;
+    while (buff != NULL) {
+      struct queue_deque_buffer *prev = buff->prev;
+      free(buff);
+      buff = prev;
+    }
+  }
+
+#ifndef __linux__
+  pthread_mutex_destroy(&q->sleep_mutex);
+  pthread_cond_destroy(&q->sleep_cond);
+#endif
 }
 
 /**
@@ -329,15 +887,34 @@ void queue_dump(int nodeID, int index, FILE *file, struct queue *q) {
   /* Grab the queue lock. */
   if (lock_lock(qlock) != 0) error("Locking the qlock failed.\n");
 
-  /* Fill any tasks from the incoming DEQ. */
-  queue_get_incoming(q);
+  if (q->type == queue_type_deque) {
 
-  /* Loop over the queue entries. */
-  for (int k = 0; k < q->count; k++) {
-    struct task *t = &q->tasks[q->entries[k].tid];
+    /* Only the owner may move the incoming tasks to the deques, so we only
+     * list what is already in them. The owner and thieves may still be
+     * active, so this is only a snapshot. */
+    int k = 0;
+    for (int b = queue_deque_nr_buckets - 1; b >= 0; b--) {
+      const struct queue_deque *d = &q->deques[b];
+      for (long long i = d->top; i < d->bottom; i++) {
+        struct task *t = &q->tasks[d->buffer->tid[i & d->buffer->mask]];
+
+        fprintf(file, "%d %d %d %s %s %.2f\n", nodeID, index, k++,
+                taskID_names[t->type], subtaskID_names[t->subtype], t->weight);
+      }
+    }
+
+  } else {
 
-    fprintf(file, "%d %d %d %s %s %.2f\n", nodeID, index, k,
-            taskID_names[t->type], subtaskID_names[t->subtype], t->weight);
+    /* Fill any tasks from the incoming DEQ. */
+    queue_get_incoming(q);
+
+    /* Loop over the queue entries. */
+    for (int k = 0; k < q->count; k++) {
+      struct task *t = &q->tasks[q->entries[k].tid];
+
+      fprintf(file, "%d %d %d %s %s %.2f\n", nodeID, index, k,
+              taskID_names[t->type], subtaskID_names[t->subtype], t->weight);
+    }
   }
 
   /* Release the task lock. */
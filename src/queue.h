@@ -32,18 +32,44 @@
 #define queue_incoming_size 10240
 #define queue_struct_align 64
 
+/* Constants for the work-stealing deque back-end. */
+#define queue_deque_nr_buckets 8
+#define queue_deque_bucket_shift 2
+#define queue_deque_sizeinit 256
+#define queue_deque_empty -1
+#define queue_deque_abort -2
+
+/* Safety time-out of the runners parked on a queue, in ns. */
+#define queue_sleep_timeout_ns 1000000
+
 /* Constants dealing with task de-priorization. */
 #define queue_lock_fail_reweight_factor 0.5
 /* #define queue_lock_fail_reweight_mask \
   ((1ULL << task_type_send) | (1ULL << task_type_recv)) */
 #define queue_lock_fail_reweight_mask ((1ULL << task_type_count) - 1)
 
-/* Counters. */
+/* The different queue back-ends. */
+enum queue_types {
+  queue_type_heap = 0,
+  queue_type_deque,
+};
+
+/* Contention counters. */
 enum {
-  queue_counter_swap = 0,
+  queue_counter_steal_attempt = 0,
+  queue_counter_steal,
+  queue_counter_steal_local,
+  queue_counter_steal_remote,
+  queue_counter_steal_abort,
+  queue_counter_lock_fail,
+  queue_counter_conflict,
+  queue_counter_busy,
+  queue_counter_sleep,
+  queue_counter_wakeup,
+  queue_counter_wakeup_spurious,
   queue_counter_count,
 };
-extern int queue_counter[queue_counter_count];
+extern const char *queue_counter_names[queue_counter_count];
 
 /** Struct containing a task offset and a weight, used to build the binary heap
  * of tasks in the queue. */
@@ -56,12 +82,44 @@ struct queue_entry {
   float weight;
 };
 
+/** Circular buffer of task offsets used by a #queue_deque. */
+struct queue_deque_buffer {
+
+  /* Size of the buffer minus one, the size is a power of two. */
+  long long mask;
+
+  /* The buffer this one replaced when the deque was grown. Kept alive as
+   * thieves may still be reading from it. */
+  struct queue_deque_buffer *prev;
+
+  /* The task offsets. */
+  int tid[];
+};
+
+/** A Chase-Lev work-stealing deque. Only the owner of the #queue pushes and
+ * pops at the bottom, any thread can steal from the top. */
+struct queue_deque {
+
+  /* Index of the oldest element, advanced by thieves. */
+  volatile long long top __attribute__((aligned(queue_struct_align)));
+
+  /* Index one past the newest element, only changed by the owner. */
+  volatile long long bottom __attribute__((aligned(queue_struct_align)));
+
+  /* The current buffer. */
+  struct queue_deque_buffer *volatile buffer;
+};
+
 /** The queue struct. */
 struct queue {
 
-  /* The lock to access this queue. */
+  /* The lock to access this queue. With the deque back-end, this only
+   * protects the overflow list, the owner and the thieves never need it. */
   swift_lock_type lock;
 
+  /* The back-end used by this queue. */
+  enum queue_types type;
+
   /* Size, count and next element. */
   int size, count;
 
@@ -75,15 +133,58 @@ struct queue {
   int *tid_incoming;
   volatile unsigned int first_incoming, last_incoming, count_incoming;
 
+  /* The work-stealing deques, one per priority bucket (deque back-end). */
+  struct queue_deque deques[queue_deque_nr_buckets];
+
+  /* Tasks inserted while the incoming DEQ was full (deque back-end). */
+  int *tid_overflow;
+  int size_overflow;
+  volatile int count_overflow;
+
+  /* Parking spot of the runners sleeping on this queue. The sequence
+   * number is bumped on every wake-up and doubles as the futex word. */
+  volatile int sleep_seq;
+  volatile int sleepers;
+
+  /* Number of single wake-ups sent that no parked runner has consumed yet. */
+  volatile int wake_pending;
+#ifndef __linux__
+  pthread_mutex_t sleep_mutex;
+  pthread_cond_t sleep_cond;
+#endif
+
+  /* Contention counters. */
+  volatile long long counters[queue_counter_count];
+
 } __attribute__((aligned(queue_struct_align)));
 
 /* Function prototypes. */
 struct task *queue_gettask(struct queue *q, const struct task *prev,
                            int blocking);
-void queue_init(struct queue *q, struct task *tasks);
+struct task *queue_steal(struct queue *q, const struct task *prev);
+void queue_init(struct queue *q, struct task *tasks, enum queue_types type);
 void queue_insert(struct queue *q, struct task *t);
 void queue_clean(struct queue *q);
+void queue_reset_counters(struct queue *q);
+int queue_sleep_prepare(struct queue *q);
+int queue_sleep(struct queue *q, int seq);
+void queue_sleep_cancel(struct queue *q);
+int queue_wake(struct queue *q, int all);
 
 void queue_dump(int nodeID, int index, FILE *file, struct queue *q);
 
+/**
+ * @brief Does a #queue hold tasks that another runner could steal?
+ *
+ * With the deque back-end, only the owner drains the incoming DEQ, so
+ * thieves can only get the tasks already in the deques.
+ *
+ * @param q The #queue.
+ */
+__attribute__((always_inline)) INLINE static int queue_can_steal(
+    const struct queue *q) {
+  if (q->type == queue_type_deque) return q->count > 0;
+  return q->count > 0 || q->count_incoming > 0;
+}
+
 #endif /* SWIFT_QUEUE_H */
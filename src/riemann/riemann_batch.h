@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_RIEMANN_BATCH_H
+#define SWIFT_RIEMANN_BATCH_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Local headers. */
+#include "align.h"
+#include "inline.h"
+#include "vector.h"
+
+/*! Number of Riemann problems solved together (one vector's worth) */
+#define RIEMANN_BATCH_SIZE VEC_SIZE
+
+/**
+ * @brief A set of Riemann problems stored as a structure of arrays.
+ *
+ * Element k of the left state of the problem i is WL[k][i], and likewise for
+ * the other quantities, such that the solvers can load one quantity for all
+ * the problems of the batch into a single vector.
+ */
+struct riemann_batch {
+
+  /*! Left states (density, velocity, pressure). */
+  float WL[5][RIEMANN_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! Right states (density, velocity, pressure). */
+  float WR[5][RIEMANN_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! Unit vectors normal to the interfaces. */
+  float n[3][RIEMANN_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! Velocities of the interfaces. */
+  float vij[3][RIEMANN_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+
+  /*! Fluxes across the interfaces (output). */
+  float flux[5][RIEMANN_BATCH_SIZE] SWIFT_CACHE_ALIGN;
+};
+
+/**
+ * @brief Store a Riemann problem in a batch.
+ *
+ * @param b The #riemann_batch.
+ * @param i Index of the problem in the batch.
+ * @param WL The left state vector.
+ * @param WR The right state vector.
+ * @param n The unit vector normal to the interface.
+ * @param vij The velocity of the interface.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_set_problem(
+    struct riemann_batch *restrict b, const int i, const float *WL,
+    const float *WR, const float *n, const float *vij) {
+
+  for (int k = 0; k < 5; k++) {
+    b->WL[k][i] = WL[k];
+    b->WR[k][i] = WR[k];
+  }
+  for (int k = 0; k < 3; k++) {
+    b->n[k][i] = n[k];
+    b->vij[k][i] = vij[k];
+  }
+}
+
+/**
+ * @brief Read a Riemann problem back from a batch.
+ *
+ * @param b The #riemann_batch.
+ * @param i Index of the problem in the batch.
+ * @param WL (return) The left state vector.
+ * @param WR (return) The right state vector.
+ * @param n (return) The unit vector normal to the interface.
+ * @param vij (return) The velocity of the interface.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_get_problem(
+    const struct riemann_batch *restrict b, const int i, float *WL, float *WR,
+    float *n, float *vij) {
+
+  for (int k = 0; k < 5; k++) {
+    WL[k] = b->WL[k][i];
+    WR[k] = b->WR[k][i];
+  }
+  for (int k = 0; k < 3; k++) {
+    n[k] = b->n[k][i];
+    vij[k] = b->vij[k][i];
+  }
+}
+
+/**
+ * @brief Fill the unused end of a batch with a trivial problem (uniform gas
+ * at rest), such that the vector solvers can process the whole batch.
+ *
+ * @param b The #riemann_batch.
+ * @param count Number of problems in use in the batch.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_pad(
+    struct riemann_batch *restrict b, const int count) {
+
+  const float W[5] = {1.f, 0.f, 0.f, 0.f, 1.f};
+  const float n[3] = {1.f, 0.f, 0.f};
+  const float vij[3] = {0.f, 0.f, 0.f};
+
+  for (int i = count; i < RIEMANN_BATCH_SIZE; i++)
+    riemann_batch_set_problem(b, i, W, W, n, vij);
+}
+
+/**
+ * @brief Store the flux across one of the interfaces of a batch.
+ *
+ * @param b The #riemann_batch.
+ * @param i Index of the problem in the batch.
+ * @param totflux The flux.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_set_flux(
+    struct riemann_batch *restrict b, const int i, const float *totflux) {
+
+  for (int k = 0; k < 5; k++) b->flux[k][i] = totflux[k];
+}
+
+/**
+ * @brief Read the flux across one of the interfaces of a batch.
+ *
+ * @param b The #riemann_batch.
+ * @param i Index of the problem in the batch.
+ * @param totflux (return) The flux.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_get_flux(
+    const struct riemann_batch *restrict b, const int i, float *totflux) {
+
+  for (int k = 0; k < 5; k++) totflux[k] = b->flux[k][i];
+}
+
+#endif /* SWIFT_RIEMANN_BATCH_H */
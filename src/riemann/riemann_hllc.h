@@ -30,9 +30,13 @@
 #include "adiabatic_index.h"
 #include "error.h"
 #include "minmax.h"
+#include "riemann_batch.h"
 #include "riemann_checks.h"
 #include "riemann_vacuum.h"
 
+/*! This solver can solve a #riemann_batch of problems in vectors */
+#define RIEMANN_SOLVER_BATCH
+
 __attribute__((always_inline)) INLINE static void riemann_solve_for_flux(
     const float *WL, const float *WR, const float *n, const float *vij,
     float *totflux) {
@@ -244,4 +248,354 @@ riemann_solve_for_middle_state_flux(const float *WL, const float *WR,
 #endif
 }
 
+#ifdef WITH_VECTORIZATION
+
+/**
+ * @brief Load the left and right states of a batch into vectors and flag the
+ * problems that the vector HLLC solver cannot handle (vacuum and vacuum
+ * generation).
+ *
+ * The states of the flagged problems are replaced by a uniform gas such that
+ * the vector solver does not produce infinities for them; their fluxes are
+ * to be computed by the scalar solver.
+ *
+ * @param b The #riemann_batch.
+ * @param rhoL, vL, PL (return) Left density, velocity and pressure.
+ * @param rhoR, vR, PR (return) Right density, velocity and pressure.
+ * @param n (return) Unit vectors normal to the interfaces.
+ * @param uL, uR (return) Left and right velocities along the normal.
+ * @param aL, aR (return) Left and right sound speeds.
+ * @return Bit mask of the problems to solve with the scalar solver.
+ */
+__attribute__((always_inline)) INLINE static int riemann_batch_load_hllc(
+    struct riemann_batch *restrict b, vector *rhoL, vector vL[3], vector *PL,
+    vector *rhoR, vector vR[3], vector *PR, vector n[3], vector *uL,
+    vector *uR, vector *aL, vector *aR) {
+
+  const vector v_zero = vector_setzero();
+  const vector v_one = vector_set1(1.f);
+
+  rhoL->v = vec_load(b->WL[0]);
+  rhoR->v = vec_load(b->WR[0]);
+  PL->v = vec_load(b->WL[4]);
+  PR->v = vec_load(b->WR[4]);
+  for (int k = 0; k < 3; k++) {
+    vL[k].v = vec_load(b->WL[k + 1]);
+    vR[k].v = vec_load(b->WR[k + 1]);
+    n[k].v = vec_load(b->n[k]);
+  }
+
+  /* Vacuum on either side */
+  mask_t vacuum_L, vacuum_R;
+  vec_create_mask(vacuum_L, vec_cmp_lte(rhoL->v, v_zero.v));
+  vec_create_mask(vacuum_R, vec_cmp_lte(rhoR->v, v_zero.v));
+  int scalar_mask = vec_is_mask_true(vacuum_L) | vec_is_mask_true(vacuum_R);
+  rhoL->v = vec_blend(vacuum_L, rhoL->v, v_one.v);
+  rhoR->v = vec_blend(vacuum_R, rhoR->v, v_one.v);
+  PL->v = vec_blend(vacuum_L, PL->v, v_one.v);
+  PR->v = vec_blend(vacuum_R, PR->v, v_one.v);
+
+  /* Velocities along the interface normal and sound speeds */
+  uL->v = vec_mul(vL[0].v, n[0].v);
+  uL->v = vec_fma(vL[1].v, n[1].v, uL->v);
+  uL->v = vec_fma(vL[2].v, n[2].v, uL->v);
+  uR->v = vec_mul(vR[0].v, n[0].v);
+  uR->v = vec_fma(vR[1].v, n[1].v, uR->v);
+  uR->v = vec_fma(vR[2].v, n[2].v, uR->v);
+  aL->v = vec_sqrt(vec_div(vec_mul(vec_set1(hydro_gamma), PL->v), rhoL->v));
+  aR->v = vec_sqrt(vec_div(vec_mul(vec_set1(hydro_gamma), PR->v), rhoR->v));
+
+  /* Vacuum generation */
+  mask_t vacuum_gen;
+  vec_create_mask(vacuum_gen,
+                  vec_cmp_lte(vec_mul(vec_set1(hydro_two_over_gamma_minus_one),
+                                      vec_add(aL->v, aR->v)),
+                              vec_sub(uR->v, uL->v)));
+  scalar_mask |= vec_is_mask_true(vacuum_gen);
+
+  return scalar_mask;
+}
+
+/**
+ * @brief Vector version of the pressure and contact wave speed estimates of
+ * the HLLC solver (steps 1 and 2 of the scalar version).
+ *
+ * @param rhoL, PL, uL, aL Left density, pressure, normal velocity and sound
+ * speed.
+ * @param rhoR, PR, uR, aR Right density, pressure, normal velocity and sound
+ * speed.
+ * @param pstar (return) Middle state pressure estimate.
+ * @param SLmuL, SRmuR (return) Left and right wave speeds relative to the
+ * fluid.
+ * @param Sstar (return) Contact wave speed.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_wave_speeds(
+    const vector rhoL, const vector PL, const vector uL, const vector aL,
+    const vector rhoR, const vector PR, const vector uR, const vector aR,
+    vector *pstar, vector *SLmuL, vector *SRmuR, vector *Sstar) {
+
+  const vector v_zero = vector_setzero();
+  const vector v_one = vector_set1(1.f);
+  const vector v_qfac =
+      vector_set1(0.5f * hydro_gamma_plus_one * hydro_one_over_gamma);
+
+  /* STEP 1: pressure estimate */
+  const vector rhobar = {.v = vec_add(rhoL.v, rhoR.v)};
+  const vector abar = {.v = vec_add(aL.v, aR.v)};
+  const vector pPVRS = {
+      .v = vec_mul(vec_set1(0.5f),
+                   vec_sub(vec_add(PL.v, PR.v),
+                           vec_mul(vec_mul(vec_set1(0.25f),
+                                           vec_sub(uR.v, uL.v)),
+                                   vec_mul(rhobar.v, abar.v))))};
+  pstar->v = vec_fmax(v_zero.v, pPVRS.v);
+
+  /* STEP 2: wave speed estimates. The shock factors q are 1 where the
+   * pressure does not increase or vanishes. */
+  mask_t zero_PL, zero_PR;
+  vec_create_mask(zero_PL, vec_cmp_lte(PL.v, v_zero.v));
+  vec_create_mask(zero_PR, vec_cmp_lte(PR.v, v_zero.v));
+  const vector PL_safe = {.v = vec_blend(zero_PL, PL.v, v_one.v)};
+  const vector PR_safe = {.v = vec_blend(zero_PR, PR.v, v_one.v)};
+  vector qL, qR;
+  qL.v = vec_fma(v_qfac.v,
+                 vec_sub(vec_div(pstar->v, PL_safe.v), v_one.v), v_one.v);
+  qR.v = vec_fma(v_qfac.v,
+                 vec_sub(vec_div(pstar->v, PR_safe.v), v_one.v), v_one.v);
+  qL.v = vec_blend(zero_PL, vec_sqrt(vec_fmax(qL.v, v_one.v)), v_one.v);
+  qR.v = vec_blend(zero_PR, vec_sqrt(vec_fmax(qR.v, v_one.v)), v_one.v);
+
+  SLmuL->v = vec_mul(vec_mul(vec_set1(-1.f), aL.v), qL.v);
+  SRmuR->v = vec_mul(aR.v, qR.v);
+  const vector rhoLuL = {.v = vec_mul(rhoL.v, uL.v)};
+  const vector rhoRuR = {.v = vec_mul(rhoR.v, uR.v)};
+  Sstar->v = vec_div(
+      vec_sub(vec_add(vec_sub(PR.v, PL.v), vec_mul(rhoLuL.v, SLmuL->v)),
+              vec_mul(rhoRuR.v, SRmuR->v)),
+      vec_sub(vec_mul(rhoL.v, SLmuL->v), vec_mul(rhoR.v, SRmuR->v)));
+}
+
+/**
+ * @brief Vector version of the one-sided part of the HLLC flux (step 3 of the
+ * scalar version) for one side of the interfaces.
+ *
+ * @param rho, v, P, u Density, velocity, pressure and normal velocity of the
+ * side.
+ * @param SmuS Wave speed of the side relative to the fluid.
+ * @param Sstar Contact wave speed.
+ * @param n Unit vectors normal to the interfaces.
+ * @param star_mask Mask of the problems where the star state contributes.
+ * @param flux (return) The fluxes.
+ */
+__attribute__((always_inline)) INLINE static void riemann_batch_side_flux(
+    const vector rho, const vector v[3], const vector P, const vector u,
+    const vector SmuS, const vector Sstar, const vector n[3],
+    const mask_t star_mask, vector flux[5]) {
+
+  const vector rhou = {.v = vec_mul(rho.v, u.v)};
+  vector v2;
+  v2.v = vec_mul(v[0].v, v[0].v);
+  v2.v = vec_fma(v[1].v, v[1].v, v2.v);
+  v2.v = vec_fma(v[2].v, v[2].v, v2.v);
+  const vector e = {
+      .v = vec_fma(vec_set1(0.5f), v2.v,
+                   vec_mul(vec_div(P.v, rho.v),
+                           vec_set1(hydro_one_over_gamma_minus_one)))};
+  const vector S = {.v = vec_add(SmuS.v, u.v)};
+
+  /* Flux of the side */
+  flux[0].v = rhou.v;
+  for (int k = 0; k < 3; k++)
+    flux[k + 1].v = vec_fma(rhou.v, v[k].v, vec_mul(P.v, n[k].v));
+  flux[4].v = vec_fma(rhou.v, e.v, vec_mul(P.v, u.v));
+
+  /* Contribution of the star state */
+  const vector starfac = {.v = vec_div(SmuS.v, vec_sub(S.v, Sstar.v))};
+  const vector rhoS = {.v = vec_mul(rho.v, S.v)};
+  const vector Sstarmu = {.v = vec_sub(Sstar.v, u.v)};
+  vector rhoSstarfac, rhoSSstarmu;
+  rhoSstarfac.v = vec_mul(rhoS.v, vec_sub(starfac.v, vec_set1(1.f)));
+  rhoSSstarmu.v = vec_mul(vec_mul(rhoS.v, Sstarmu.v), starfac.v);
+  rhoSstarfac.v = vec_and_mask(rhoSstarfac.v, star_mask);
+  rhoSSstarmu.v = vec_and_mask(rhoSSstarmu.v, star_mask);
+
+  flux[0].v = vec_add(flux[0].v, rhoSstarfac.v);
+  for (int k = 0; k < 3; k++)
+    flux[k + 1].v =
+        vec_add(flux[k + 1].v, vec_fma(rhoSstarfac.v, v[k].v,
+                                        vec_mul(rhoSSstarmu.v, n[k].v)));
+  const vector Pterm = {
+      .v = vec_add(Sstar.v, vec_div(P.v, vec_mul(rho.v, SmuS.v)))};
+  flux[4].v = vec_add(flux[4].v, vec_fma(rhoSstarfac.v, e.v,
+                                         vec_and_mask(vec_mul(rhoSSstarmu.v,
+                                                              Pterm.v),
+                                                      star_mask)));
+}
+
+#endif /* WITH_VECTORIZATION */
+
+/**
+ * @brief Solve a batch of Riemann problems for the fluxes across their
+ * interfaces.
+ *
+ * The HLLC fluxes of all the problems are computed together in vectors, with
+ * both sides of the contact wave evaluated and the right one selected per
+ * problem. The problems involving vacuum (which do not follow the HLLC path
+ * in the scalar solver) are then solved again one by one with the scalar
+ * solver.
+ *
+ * @param b The #riemann_batch (the fluxes are stored in it).
+ * @param count Number of problems in the batch.
+ */
+__attribute__((always_inline)) INLINE static void riemann_solve_batch_for_flux(
+    struct riemann_batch *restrict b, const int count) {
+
+#ifdef WITH_VECTORIZATION
+
+  riemann_batch_pad(b, count);
+
+  vector rhoL, vL[3], PL, rhoR, vR[3], PR, n[3], uL, uR, aL, aR;
+  const int scalar_mask = riemann_batch_load_hllc(
+      b, &rhoL, vL, &PL, &rhoR, vR, &PR, n, &uL, &uR, &aL, &aR);
+
+  vector pstar, SLmuL, SRmuR, Sstar;
+  riemann_batch_wave_speeds(rhoL, PL, uL, aL, rhoR, PR, uR, aR, &pstar, &SLmuL,
+                            &SRmuR, &Sstar);
+
+  /* STEP 3: HLLC flux in a frame moving with the interface velocity */
+  const vector v_zero = vector_setzero();
+  const vector SL = {.v = vec_add(SLmuL.v, uL.v)};
+  const vector SR = {.v = vec_add(SRmuR.v, uR.v)};
+  mask_t star_L, star_R, right;
+  vec_create_mask(star_L, vec_cmp_lt(SL.v, v_zero.v));
+  vec_create_mask(star_R, vec_cmp_gt(SR.v, v_zero.v));
+  vec_create_mask(right, vec_cmp_lt(Sstar.v, v_zero.v));
+
+  vector fluxL[5], fluxR[5], flux[5];
+  riemann_batch_side_flux(rhoL, vL, PL, uL, SLmuL, Sstar, n, star_L, fluxL);
+  riemann_batch_side_flux(rhoR, vR, PR, uR, SRmuR, Sstar, n, star_R, fluxR);
+  for (int k = 0; k < 5; k++)
+    flux[k].v = vec_blend(right, fluxL[k].v, fluxR[k].v);
+
+  /* deboost to lab frame: the energy flux first uses the momentum fluxes in
+     the interface frame */
+  vector vij[3];
+  for (int k = 0; k < 3; k++) vij[k].v = vec_load(b->vij[k]);
+  vector v2;
+  v2.v = vec_mul(vij[0].v, vij[0].v);
+  v2.v = vec_fma(vij[1].v, vij[1].v, v2.v);
+  v2.v = vec_fma(vij[2].v, vij[2].v, v2.v);
+  flux[4].v = vec_fma(vec_mul(vec_set1(0.5f), v2.v), flux[0].v, flux[4].v);
+  for (int k = 0; k < 3; k++)
+    flux[4].v = vec_fma(vij[k].v, flux[k + 1].v, flux[4].v);
+  for (int k = 0; k < 3; k++)
+    flux[k + 1].v = vec_fma(vij[k].v, flux[0].v, flux[k + 1].v);
+
+  for (int k = 0; k < 5; k++) vec_store(flux[k].v, b->flux[k]);
+
+  /* Scalar solver for the problems involving vacuum. The loop runs over the
+   * bits of the mask such that the compiler cannot turn it into masked
+   * vector code, whose unused lanes raise floating-point exceptions. */
+  for (int i = 0, mask = scalar_mask; mask != 0; i++, mask >>= 1) {
+    if (!(mask & 1)) continue;
+    float WL[5], WR[5], n_unit[3], vface[3], totflux[5];
+    riemann_batch_get_problem(b, i, WL, WR, n_unit, vface);
+    riemann_solve_for_flux(WL, WR, n_unit, vface, totflux);
+    riemann_batch_set_flux(b, i, totflux);
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  for (int i = 0; i < count; i++) {
+    if (scalar_mask & (1 << i)) continue;
+    float WL[5], WR[5], n_unit[3], vface[3], totflux[5];
+    riemann_batch_get_problem(b, i, WL, WR, n_unit, vface);
+    riemann_check_input(WL, WR, n_unit, vface);
+    riemann_batch_get_flux(b, i, totflux);
+    riemann_check_output(WL, WR, n_unit, vface, totflux);
+  }
+#endif
+
+#else
+
+  for (int i = 0; i < count; i++) {
+    float WL[5], WR[5], n[3], vij[3], totflux[5];
+    riemann_batch_get_problem(b, i, WL, WR, n, vij);
+    riemann_solve_for_flux(WL, WR, n, vij, totflux);
+    riemann_batch_set_flux(b, i, totflux);
+  }
+
+#endif /* WITH_VECTORIZATION */
+}
+
+/**
+ * @brief Solve a batch of Riemann problems for the middle state fluxes
+ * across their interfaces.
+ *
+ * As for riemann_solve_batch_for_flux(), the problems are solved together in
+ * vectors and the ones involving vacuum are solved again with the scalar
+ * solver.
+ *
+ * @param b The #riemann_batch (the fluxes are stored in it).
+ * @param count Number of problems in the batch.
+ */
+__attribute__((always_inline)) INLINE static void
+riemann_solve_batch_for_middle_state_flux(struct riemann_batch *restrict b,
+                                          const int count) {
+
+#ifdef WITH_VECTORIZATION
+
+  riemann_batch_pad(b, count);
+
+  vector rhoL, vL[3], PL, rhoR, vR[3], PR, n[3], uL, uR, aL, aR;
+  const int scalar_mask = riemann_batch_load_hllc(
+      b, &rhoL, vL, &PL, &rhoR, vR, &PR, n, &uL, &uR, &aL, &aR);
+
+  vector pstar, SLmuL, SRmuR, Sstar;
+  riemann_batch_wave_speeds(rhoL, PL, uL, aL, rhoR, PR, uR, aR, &pstar, &SLmuL,
+                            &SRmuR, &Sstar);
+
+  vector vface;
+  vface.v = vec_mul(vec_load(b->vij[0]), n[0].v);
+  vface.v = vec_fma(vec_load(b->vij[1]), n[1].v, vface.v);
+  vface.v = vec_fma(vec_load(b->vij[2]), n[2].v, vface.v);
+
+  vec_store(vec_setzero(), b->flux[0]);
+  for (int k = 0; k < 3; k++)
+    vec_store(vec_mul(pstar.v, n[k].v), b->flux[k + 1]);
+  vec_store(vec_mul(pstar.v, vec_add(Sstar.v, vface.v)), b->flux[4]);
+
+  /* Scalar solver for the problems involving vacuum. The loop runs over the
+   * bits of the mask such that the compiler cannot turn it into masked
+   * vector code, whose unused lanes raise floating-point exceptions. */
+  for (int i = 0, mask = scalar_mask; mask != 0; i++, mask >>= 1) {
+    if (!(mask & 1)) continue;
+    float WL[5], WR[5], n_unit[3], vij[3], totflux[5];
+    riemann_batch_get_problem(b, i, WL, WR, n_unit, vij);
+    riemann_solve_for_middle_state_flux(WL, WR, n_unit, vij, totflux);
+    riemann_batch_set_flux(b, i, totflux);
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  for (int i = 0; i < count; i++) {
+    if (scalar_mask & (1 << i)) continue;
+    float WL[5], WR[5], n_unit[3], vij[3], totflux[5];
+    riemann_batch_get_problem(b, i, WL, WR, n_unit, vij);
+    riemann_check_input(WL, WR, n_unit, vij);
+    riemann_batch_get_flux(b, i, totflux);
+    riemann_check_output(WL, WR, n_unit, vij, totflux);
+  }
+#endif
+
+#else
+
+  for (int i = 0; i < count; i++) {
+    float WL[5], WR[5], n[3], vij[3], totflux[5];
+    riemann_batch_get_problem(b, i, WL, WR, n, vij);
+    riemann_solve_for_middle_state_flux(WL, WR, n, vij, totflux);
+    riemann_batch_set_flux(b, i, totflux);
+  }
+
+#endif /* WITH_VECTORIZATION */
+}
+
 #endif /* SWIFT_RIEMANN_HLLC_H */
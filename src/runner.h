@@ -49,6 +49,24 @@ struct task;
 #define TASK_LOOP_RT_GRADIENT 11
 #define TASK_LOOP_RT_TRANSPORT 12
 
+/**
+ * @brief A candidate neighbour recorded by the ghost task.
+ *
+ * The positions do not change while the ghost iterates over the smoothing
+ * lengths, so the separation is stored along with the neighbour.
+ */
+struct runner_ngb {
+
+  /*! The neighbour. */
+  struct part *pj;
+
+  /*! Separation vector pi - pj (periodically wrapped). */
+  float dx[3];
+
+  /*! Squared separation. */
+  float r2;
+};
+
 /**
  * @brief A struct representing a runner's thread and its data.
  */
@@ -72,6 +90,9 @@ struct runner {
   /*! The particle gravity_cache of cell cj. */
   struct gravity_cache cj_gravity_cache;
 
+  /*! Can consecutive P-P pairs sharing a cell re-use the gravity caches? */
+  int reuse_gravity_caches;
+
   /*! Time this runner was active during the last engine_launch. */
   ticks active_time;
 
@@ -930,7 +930,7 @@ void DOPAIR_SUBSET_BRANCH(struct runner *r, struct cell *restrict ci,
   if (force_naive || !is_sorted) {
     DOPAIR_SUBSET_NAIVE(r, ci, parts_i, ind, count, cj, shift);
   } else {
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
     if (sort_is_face(sid))
       runner_dopair_subset_density_vec(r, ci, parts_i, ind, count, cj, sid,
                                        flipped, shift);
@@ -1055,7 +1055,7 @@ void DOSELF_SUBSET_BRANCH(struct runner *r, struct cell *restrict ci,
                           struct part *restrict parts, int *restrict ind,
                           int count) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
   runner_doself_subset_density_vec(r, ci, parts, ind, count);
 #else
   DOSELF_SUBSET(r, ci, parts, ind, count);
@@ -1407,7 +1407,7 @@ void DOPAIR1_BRANCH(struct runner *r, struct cell *ci, struct cell *cj) {
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOPAIR1_NAIVE(r, ci, cj);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
   if (!sort_is_corner(sid))
     runner_dopair1_density_vec(r, ci, cj, sid, shift);
@@ -1474,6 +1474,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
   const float a = cosmo->a;
   const float H = cosmo->H;
   GET_MU0();
+  IACT_BATCH_INIT();
 
   /* Maximal displacement since last rebuild */
   const double dx_max = (ci->hydro.dx_max_sort + cj->hydro.dx_max_sort);
@@ -1623,7 +1624,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
         /* Hit or miss?
            (note that we will do the other condition in the reverse loop) */
         if (r2 < hig2) {
-          IACT_NONSYM(r2, dx, hj, hi, pj, pi, a, H);
+          IACT_NONSYM_BATCH(r2, dx, hj, hi, pj, pi, a, H);
           IACT_NONSYM_MHD(r2, dx, hj, hi, pj, pi, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
           runner_iact_nonsym_chemistry(r2, dx, hj, hi, pj, pi, a, H);
@@ -1706,7 +1707,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
 
           /* Does pj need to be updated too? */
           if (PART_IS_ACTIVE(pj, e)) {
-            IACT(r2, dx, hi, hj, pi, pj, a, H);
+            IACT_BATCH(r2, dx, hi, hj, pi, pj, a, H);
             IACT_MHD(r2, dx, hi, hj, pi, pj, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
             runner_iact_chemistry(r2, dx, hi, hj, pi, pj, a, H);
@@ -1722,7 +1723,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
                                   t_current, cosmo, with_cosmology);
 #endif
           } else {
-            IACT_NONSYM(r2, dx, hi, hj, pi, pj, a, H);
+            IACT_NONSYM_BATCH(r2, dx, hi, hj, pi, pj, a, H);
             IACT_NONSYM_MHD(r2, dx, hi, hj, pi, pj, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
             runner_iact_nonsym_chemistry(r2, dx, hi, hj, pi, pj, a, H);
@@ -1838,7 +1839,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
         /* Hit or miss?
            (note that we must avoid the r2 < hig2 cases we already processed) */
         if (r2 < hjg2 && r2 >= hig2) {
-          IACT_NONSYM(r2, dx, hi, hj, pi, pj, a, H);
+          IACT_NONSYM_BATCH(r2, dx, hi, hj, pi, pj, a, H);
           IACT_NONSYM_MHD(r2, dx, hi, hj, pi, pj, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
           runner_iact_nonsym_chemistry(r2, dx, hi, hj, pi, pj, a, H);
@@ -1923,7 +1924,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
 
           /* Does pi need to be updated too? */
           if (PART_IS_ACTIVE(pi, e)) {
-            IACT(r2, dx, hj, hi, pj, pi, a, H);
+            IACT_BATCH(r2, dx, hj, hi, pj, pi, a, H);
             IACT_MHD(r2, dx, hj, hi, pj, pi, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
             runner_iact_chemistry(r2, dx, hj, hi, pj, pi, a, H);
@@ -1939,7 +1940,7 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
                                   t_current, cosmo, with_cosmology);
 #endif
           } else {
-            IACT_NONSYM(r2, dx, hj, hi, pj, pi, a, H);
+            IACT_NONSYM_BATCH(r2, dx, hj, hi, pj, pi, a, H);
             IACT_NONSYM_MHD(r2, dx, hj, hi, pj, pi, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
             runner_iact_nonsym_chemistry(r2, dx, hj, hi, pj, pi, a, H);
@@ -1967,6 +1968,9 @@ void DOPAIR2(struct runner *r, struct cell *ci, struct cell *cj, const int sid,
   if (CELL_IS_ACTIVE(cj, e))  // && !cell_is_all_active_hydro(cj, e))
     free(sort_active_j);
 
+  /* Compute the interactions still queued */
+  IACT_BATCH_FLUSH();
+
   TIMER_TOC(TIMER_DOPAIR);
 }
 
@@ -2052,7 +2056,7 @@ void DOPAIR2_BRANCH(struct runner *r, struct cell *ci, struct cell *cj) {
 
 #ifdef SWIFT_USE_NAIVE_INTERACTIONS
   DOPAIR2_NAIVE(r, ci, cj);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE_LOOP) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_FORCE)
   if (!sort_is_corner(sid))
     runner_dopair2_force_vec(r, ci, cj, sid, shift);
@@ -2084,17 +2088,35 @@ void DOSELF1(struct runner *r, struct cell *restrict c) {
   struct part *restrict parts = c->hydro.parts;
   const int count = c->hydro.count;
 
-  /* Set up indt. */
-  int *indt = NULL;
-  int countdt = 0, firstdt = 0;
+  /* Set up the list of the particles that are not inhibited (indn), with
+   * their single-precision positions relative to the cell and smoothing
+   * lengths (xh), and the list of the active ones among them (indt). */
+  int *indt = NULL, *indn = NULL;
+  float *xh = NULL;
+  int countdt = 0, firstdt = 0, countn = 0;
   if (posix_memalign((void **)&indt, VEC_SIZE * sizeof(int),
                      count * sizeof(int)) != 0)
     error("Failed to allocate indt.");
-  for (int k = 0; k < count; k++)
-    if (PART_IS_ACTIVE(&parts[k], e)) {
-      indt[countdt] = k;
+  if (posix_memalign((void **)&indn, VEC_SIZE * sizeof(int),
+                     count * sizeof(int)) != 0)
+    error("Failed to allocate indn.");
+  if (posix_memalign((void **)&xh, VEC_SIZE * sizeof(float),
+                     4 * count * sizeof(float)) != 0)
+    error("Failed to allocate xh.");
+  for (int k = 0; k < count; k++) {
+    const struct part *restrict p = &parts[k];
+    if (part_is_inhibited(p, e)) continue;
+    if (PART_IS_ACTIVE(p, e)) {
+      indt[countdt] = countn;
       countdt += 1;
     }
+    indn[countn] = k;
+    xh[4 * countn + 0] = p->x[0] - c->loc[0];
+    xh[4 * countn + 1] = p->x[1] - c->loc[1];
+    xh[4 * countn + 2] = p->x[2] - c->loc[2];
+    xh[4 * countn + 3] = p->h;
+    countn += 1;
+  }
 
   /* Cosmological terms and physical constants */
   const float a = cosmo->a;
@@ -2102,18 +2124,14 @@ void DOSELF1(struct runner *r, struct cell *restrict c) {
   GET_MU0();
 
   /* Loop over the particles in the cell. */
-  for (int pid = 0; pid < count; pid++) {
+  for (int pid = 0; pid < countn; pid++) {
 
     /* Get a pointer to the ith particle. */
-    struct part *restrict pi = &parts[pid];
-
-    /* Skip inhibited particles. */
-    if (part_is_inhibited(pi, e)) continue;
+    struct part *restrict pi = &parts[indn[pid]];
 
     /* Get the particle position and radius. */
-    double pix[3];
-    for (int k = 0; k < 3; k++) pix[k] = pi->x[k];
-    const float hi = pi->h;
+    const float *pix = &xh[4 * pid];
+    const float hi = pix[3];
     const float hig2 = hi * hi * kernel_gamma2;
 
     /* Is the ith particle inactive? */
@@ -2123,8 +2141,9 @@ void DOSELF1(struct runner *r, struct cell *restrict c) {
       for (int pjd = firstdt; pjd < countdt; pjd++) {
 
         /* Get a pointer to the jth particle. */
-        struct part *restrict pj = &parts[indt[pjd]];
-        const float hj = pj->h;
+        struct part *restrict pj = &parts[indn[indt[pjd]]];
+        const float *pjx = &xh[4 * indt[pjd]];
+        const float hj = pjx[3];
 
 #if defined(SWIFT_DEBUG_CHECKS) && defined(DO_DRIFT_DEBUG_CHECKS)
         /* Check that particles have been drifted to the current time */
@@ -2138,7 +2157,7 @@ void DOSELF1(struct runner *r, struct cell *restrict c) {
         float r2 = 0.0f;
         float dx[3];
         for (int k = 0; k < 3; k++) {
-          dx[k] = pj->x[k] - pix[k];
+          dx[k] = pjx[k] - pix[k];
           r2 += dx[k] * dx[k];
         }
 
@@ -2171,25 +2190,22 @@ void DOSELF1(struct runner *r, struct cell *restrict c) {
       firstdt += 1;
 
       /* Loop over the other particles .*/
-      for (int pjd = pid + 1; pjd < count; pjd++) {
+      for (int pjd = pid + 1; pjd < countn; pjd++) {
 
         /* Get a pointer to the jth particle. */
-        struct part *restrict pj = &parts[pjd];
-
-        /* Skip inhibited particles. */
-        if (part_is_inhibited(pj, e)) continue;
-
-        const float hj = pj->h;
+        struct part *restrict pj = &parts[indn[pjd]];
+        const float *pjx = &xh[4 * pjd];
+        const float hj = pjx[3];
 
         /* Compute the pairwise distance. */
         float r2 = 0.0f;
         float dx[3];
         for (int k = 0; k < 3; k++) {
-          dx[k] = pix[k] - pj->x[k];
+          dx[k] = pix[k] - pjx[k];
           r2 += dx[k] * dx[k];
         }
         const int doj =
-            (PART_IS_ACTIVE(pj, e)) && (r2 < hj * hj * kernel_gamma2);
+            (r2 < hj * hj * kernel_gamma2) && (PART_IS_ACTIVE(pj, e));
 
         const int doi = (r2 < hig2);
 
@@ -2268,6 +2284,8 @@ void DOSELF1(struct runner *r, struct cell *restrict c) {
   } /* loop over all particles. */
 
   free(indt);
+  free(indn);
+  free(xh);
 
   TIMER_TOC(TIMER_DOSELF);
 }
@@ -2299,7 +2317,7 @@ void DOSELF1_BRANCH(struct runner *r, struct cell *c) {
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOSELF1_NAIVE(r, c);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
   runner_doself1_density_vec(r, c);
 #else
@@ -2328,36 +2346,51 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
   struct part *restrict parts = c->hydro.parts;
   const int count = c->hydro.count;
 
-  /* Set up indt. */
-  int *indt = NULL;
-  int countdt = 0, firstdt = 0;
+  /* Set up the list of the particles that are not inhibited (indn), with
+   * their single-precision positions relative to the cell and smoothing
+   * lengths (xh), and the list of the active ones among them (indt). */
+  int *indt = NULL, *indn = NULL;
+  float *xh = NULL;
+  int countdt = 0, firstdt = 0, countn = 0;
   if (posix_memalign((void **)&indt, VEC_SIZE * sizeof(int),
                      count * sizeof(int)) != 0)
     error("Failed to allocate indt.");
-  for (int k = 0; k < count; k++)
-    if (PART_IS_ACTIVE(&parts[k], e)) {
-      indt[countdt] = k;
+  if (posix_memalign((void **)&indn, VEC_SIZE * sizeof(int),
+                     count * sizeof(int)) != 0)
+    error("Failed to allocate indn.");
+  if (posix_memalign((void **)&xh, VEC_SIZE * sizeof(float),
+                     4 * count * sizeof(float)) != 0)
+    error("Failed to allocate xh.");
+  for (int k = 0; k < count; k++) {
+    const struct part *restrict p = &parts[k];
+    if (part_is_inhibited(p, e)) continue;
+    if (PART_IS_ACTIVE(p, e)) {
+      indt[countdt] = countn;
       countdt += 1;
     }
+    indn[countn] = k;
+    xh[4 * countn + 0] = p->x[0] - c->loc[0];
+    xh[4 * countn + 1] = p->x[1] - c->loc[1];
+    xh[4 * countn + 2] = p->x[2] - c->loc[2];
+    xh[4 * countn + 3] = p->h;
+    countn += 1;
+  }
 
   /* Cosmological terms and physical constants */
   const float a = cosmo->a;
   const float H = cosmo->H;
   GET_MU0();
+  IACT_BATCH_INIT();
 
   /* Loop over the particles in the cell. */
-  for (int pid = 0; pid < count; pid++) {
+  for (int pid = 0; pid < countn; pid++) {
 
     /* Get a pointer to the ith particle. */
-    struct part *restrict pi = &parts[pid];
-
-    /* Skip inhibited particles. */
-    if (part_is_inhibited(pi, e)) continue;
+    struct part *restrict pi = &parts[indn[pid]];
 
     /* Get the particle position and radius. */
-    double pix[3];
-    for (int k = 0; k < 3; k++) pix[k] = pi->x[k];
-    const float hi = pi->h;
+    const float *pix = &xh[4 * pid];
+    const float hi = pix[3];
     const float hig2 = hi * hi * kernel_gamma2;
 
     /* Is the ith particle not active? */
@@ -2367,14 +2400,15 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
       for (int pjd = firstdt; pjd < countdt; pjd++) {
 
         /* Get a pointer to the jth particle. */
-        struct part *restrict pj = &parts[indt[pjd]];
-        const float hj = pj->h;
+        struct part *restrict pj = &parts[indn[indt[pjd]]];
+        const float *pjx = &xh[4 * indt[pjd]];
+        const float hj = pjx[3];
 
         /* Compute the pairwise distance. */
         float r2 = 0.0f;
         float dx[3];
         for (int k = 0; k < 3; k++) {
-          dx[k] = pj->x[k] - pix[k];
+          dx[k] = pjx[k] - pix[k];
           r2 += dx[k] * dx[k];
         }
 
@@ -2389,7 +2423,7 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
         /* Hit or miss? */
         if (r2 < hig2 || r2 < hj * hj * kernel_gamma2) {
 
-          IACT_NONSYM(r2, dx, hj, hi, pj, pi, a, H);
+          IACT_NONSYM_BATCH(r2, dx, hj, hi, pj, pi, a, H);
           IACT_NONSYM_MHD(r2, dx, hj, hi, pj, pi, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
           runner_iact_nonsym_chemistry(r2, dx, hj, hi, pj, pi, a, H);
@@ -2415,21 +2449,18 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
       firstdt += 1;
 
       /* Loop over the other particles .*/
-      for (int pjd = pid + 1; pjd < count; pjd++) {
+      for (int pjd = pid + 1; pjd < countn; pjd++) {
 
         /* Get a pointer to the jth particle. */
-        struct part *restrict pj = &parts[pjd];
-
-        /* Skip inhibited particles. */
-        if (part_is_inhibited(pj, e)) continue;
-
-        const float hj = pj->h;
+        struct part *restrict pj = &parts[indn[pjd]];
+        const float *pjx = &xh[4 * pjd];
+        const float hj = pjx[3];
 
         /* Compute the pairwise distance. */
         float r2 = 0.0f;
         float dx[3];
         for (int k = 0; k < 3; k++) {
-          dx[k] = pix[k] - pj->x[k];
+          dx[k] = pix[k] - pjx[k];
           r2 += dx[k] * dx[k];
         }
 
@@ -2446,7 +2477,7 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
 
           /* Does pj need to be updated too? */
           if (PART_IS_ACTIVE(pj, e)) {
-            IACT(r2, dx, hi, hj, pi, pj, a, H);
+            IACT_BATCH(r2, dx, hi, hj, pi, pj, a, H);
             IACT_MHD(r2, dx, hi, hj, pi, pj, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
             runner_iact_chemistry(r2, dx, hi, hj, pi, pj, a, H);
@@ -2462,7 +2493,7 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
                                   t_current, cosmo, with_cosmology);
 #endif
           } else {
-            IACT_NONSYM(r2, dx, hi, hj, pi, pj, a, H);
+            IACT_NONSYM_BATCH(r2, dx, hi, hj, pi, pj, a, H);
             IACT_NONSYM_MHD(r2, dx, hi, hj, pi, pj, mu_0, a, H);
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
             runner_iact_nonsym_chemistry(r2, dx, hi, hj, pi, pj, a, H);
@@ -2485,6 +2516,11 @@ void DOSELF2(struct runner *r, struct cell *restrict c) {
   } /* loop over all particles. */
 
   free(indt);
+  free(indn);
+  free(xh);
+
+  /* Compute the interactions still queued */
+  IACT_BATCH_FLUSH();
 
   TIMER_TOC(TIMER_DOSELF);
 }
@@ -2516,7 +2552,7 @@ void DOSELF2_BRANCH(struct runner *r, struct cell *c) {
 
 #if defined(SWIFT_USE_NAIVE_INTERACTIONS)
   DOSELF2_NAIVE(r, c);
-#elif defined(WITH_VECTORIZATION) && defined(GADGET2_SPH) && \
+#elif defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE_LOOP) && \
     (FUNCTION_TASK_LOOP == TASK_LOOP_FORCE)
   runner_doself2_force_vec(r, c);
 #else
@@ -2817,3 +2853,73 @@ void DOSUB_SUBSET(struct runner *r, struct cell *ci, struct part *parts,
 
   if (gettimer) TIMER_TOC(timer_dosub_subset);
 }
+
+#if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
+/**
+ * @brief Compute the interactions between a set of particles and their
+ * candidate neighbours recorded by the ghost (non-symmetric).
+ *
+ * @param r The #runner.
+ * @param parts The #part to interact.
+ * @param ind The list of indices of particles in @c parts to interact with.
+ * @param count The number of particles in @c ind.
+ * @param ngbs The recorded candidate neighbours.
+ * @param first The index in @c ngbs of the first candidate of each particle.
+ * @param num The number of candidates of each particle.
+ */
+void DOLIST_SUBSET(struct runner *r, struct part *restrict parts,
+                   const int *restrict ind, int count,
+                   const struct runner_ngb *restrict ngbs,
+                   const int *restrict first, const int *restrict num) {
+
+  const struct engine *e = r->e;
+  const struct cosmology *cosmo = e->cosmology;
+
+  TIMER_TIC;
+
+  /* Cosmological terms and physical constants */
+  const float a = cosmo->a;
+  const float H = cosmo->H;
+  GET_MU0();
+
+  for (int pid = 0; pid < count; pid++) {
+
+    /* Get a hold of the ith part. */
+    struct part *restrict pi = &parts[ind[pid]];
+    const float hi = pi->h;
+    const float hig2 = hi * hi * kernel_gamma2;
+
+#ifdef SWIFT_DEBUG_CHECKS
+    if (!part_is_active(pi, e))
+      error("Trying to correct smoothing length of inactive particle !");
+#endif
+
+    /* Loop over the candidates of this particle. */
+    const struct runner_ngb *restrict list = &ngbs[first[pid]];
+    for (int k = 0; k < num[pid]; k++) {
+
+      /* Hit or miss? */
+      if (list[k].r2 >= hig2) continue;
+
+      struct part *restrict pj = list[k].pj;
+
+      /* Skip inhibited particles. */
+      if (part_is_inhibited(pj, e)) continue;
+
+      const float hj = pj->h;
+      const float r2 = list[k].r2;
+      float dx[3] = {list[k].dx[0], list[k].dx[1], list[k].dx[2]};
+
+      IACT_NONSYM(r2, dx, hi, hj, pi, pj, a, H);
+      IACT_NONSYM_MHD(r2, dx, hi, hj, pi, pj, mu_0, a, H);
+      runner_iact_nonsym_chemistry(r2, dx, hi, hj, pi, pj, a, H);
+      runner_iact_nonsym_pressure_floor(r2, dx, hi, hj, pi, pj, a, H);
+      runner_iact_nonsym_star_formation(r2, dx, hi, hj, pi, pj, a, H);
+      runner_iact_nonsym_sink(r2, dx, hi, hj, pi, pj, a, H,
+                              e->sink_properties->cut_off_radius);
+    }
+  }
+
+  TIMER_TOC(timer_dolist_subset);
+}
+#endif /* FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY */
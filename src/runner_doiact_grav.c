@@ -28,7 +28,9 @@
 #include "gravity.h"
 #include "gravity_cache.h"
 #include "gravity_iact.h"
+#include "gravity_interaction_list.h"
 #include "inline.h"
+#include "multipole_batch.h"
 #include "part.h"
 #include "space_getsid.h"
 #include "timers.h"
@@ -197,6 +199,7 @@ static INLINE void runner_dopair_grav_pp_full_no_cache(
   if (cache_i->count < gcount_padded_i)
     gravity_cache_init(cache_i, gcount_padded_i);
   gravity_cache_zero_output(cache_i, gcount_padded_i);
+  gravity_cache_invalidate(cache_i);
 
 #ifdef SWIFT_DEBUG_CHECKS
   if (ci->split) error("Using function above leaf level!");
@@ -396,6 +399,7 @@ static INLINE void runner_dopair_grav_pp_truncated_no_cache(
   if (cache_i->count < gcount_padded_i)
     gravity_cache_init(cache_i, gcount_padded_i);
   gravity_cache_zero_output(cache_i, gcount_padded_i);
+  gravity_cache_invalidate(cache_i);
 
   /* Loop over sink particles */
   for (int i = 0; i < gcount_i; ++i) {
@@ -1240,8 +1244,18 @@ void runner_dopair_grav_pp(struct runner *r, struct cell *ci, struct cell *cj,
 #endif
 
   /* Caches to play with */
-  struct gravity_cache *const ci_cache = &r->ci_gravity_cache;
-  struct gravity_cache *const cj_cache = &r->cj_gravity_cache;
+  struct gravity_cache *ci_cache = &r->ci_gravity_cache;
+  struct gravity_cache *cj_cache = &r->cj_gravity_cache;
+  const int reuse_caches = r->reuse_gravity_caches;
+
+  /* If the previous pair shared a cell with this one, make sure its
+   * cache ends up on the right side so that we can re-use it. */
+  if (reuse_caches && (gravity_cache_holds_cell(ci_cache, cj) ||
+                       gravity_cache_holds_cell(cj_cache, ci))) {
+    struct gravity_cache *const temp = ci_cache;
+    ci_cache = cj_cache;
+    cj_cache = temp;
+  }
 
   /* Shift to apply to the particles in each cell */
   const double shift_i[3] = {0., 0., 0.};
@@ -1269,15 +1283,34 @@ void runner_dopair_grav_pp(struct runner *r, struct cell *ci, struct cell *cj,
   const int allow_multipole_i = allow_mpole && ci->grav.count > 1;
   const int allow_multipole_j = allow_mpole && cj->grav.count > 1;
 
-  /* Fill the caches */
-  gravity_cache_populate(e->max_active_bin, allow_multipole_j, periodic, dim,
-                         ci_cache, ci->grav.parts, gcount_i, gcount_padded_i,
-                         shift_i, CoM_j, cj->grav.multipole, ci,
-                         e->gravity_properties);
-  gravity_cache_populate(e->max_active_bin, allow_multipole_i, periodic, dim,
-                         cj_cache, cj->grav.parts, gcount_j, gcount_padded_j,
-                         shift_j, CoM_i, ci->grav.multipole, cj,
-                         e->gravity_properties);
+  TIMER_TIC2;
+
+  /* Fill the caches, or only update the M2P flags if they already contain
+   * the particles of these cells from the previous pair */
+  if (reuse_caches && gravity_cache_holds_cell(ci_cache, ci)) {
+    gravity_cache_update_mpole(allow_multipole_j, periodic, dim, ci_cache,
+                               ci->grav.parts, gcount_i, gcount_padded_i, CoM_j,
+                               cj->grav.multipole, e->gravity_properties);
+  } else {
+    gravity_cache_populate(e->max_active_bin, allow_multipole_j, periodic, dim,
+                           ci_cache, ci->grav.parts, gcount_i, gcount_padded_i,
+                           shift_i, CoM_j, cj->grav.multipole, ci,
+                           e->gravity_properties);
+    if (reuse_caches) gravity_cache_set_cell(ci_cache, ci);
+  }
+  if (reuse_caches && gravity_cache_holds_cell(cj_cache, cj)) {
+    gravity_cache_update_mpole(allow_multipole_i, periodic, dim, cj_cache,
+                               cj->grav.parts, gcount_j, gcount_padded_j, CoM_i,
+                               ci->grav.multipole, e->gravity_properties);
+  } else {
+    gravity_cache_populate(e->max_active_bin, allow_multipole_i, periodic, dim,
+                           cj_cache, cj->grav.parts, gcount_j, gcount_padded_j,
+                           shift_j, CoM_i, ci->grav.multipole, cj,
+                           e->gravity_properties);
+    if (reuse_caches) gravity_cache_set_cell(cj_cache, cj);
+  }
+
+  TIMER_TOC2(timer_grav_cache_populate);
 
   /* Can we use the Newtonian version or do we need the truncated one ? */
   if (!periodic) {
@@ -1817,9 +1850,11 @@ void runner_doself_grav_pp(struct runner *r, struct cell *c) {
   const int gcount_padded = gcount - (gcount % VEC_SIZE) + VEC_SIZE;
 
   /* Fill the cache */
+  TIMER_TIC2;
   gravity_cache_populate_no_mpole(e->max_active_bin, ci_cache, c->grav.parts,
                                   gcount, gcount_padded, loc, c,
                                   e->gravity_properties);
+  TIMER_TOC2(timer_grav_cache_populate);
 
   /* Can we use the Newtonian version or do we need the truncated one ? */
   if (!periodic) {
@@ -2044,6 +2079,156 @@ static INLINE void runner_dopair_grav_mm(struct runner *r,
     runner_dopair_grav_mm_nonsym(r, cj, ci);
 }
 
+/**
+ * @brief A batch of M-M interactions waiting to be computed, along with the
+ * cells whose field tensors receive them.
+ */
+struct runner_grav_mm_batch {
+
+  /*! The interactions. */
+  struct gravity_M2L_batch m2l;
+
+  /*! The cells receiving the interactions. */
+  struct cell *ci[GRAVITY_M2L_BATCH_SIZE];
+};
+
+/**
+ * @brief Computes all the interactions of a #runner_grav_mm_batch and adds
+ * them to the field tensors of their cells. The batch is empty on return.
+ *
+ * @param r The #runner.
+ * @param b The #runner_grav_mm_batch.
+ */
+static INLINE void runner_dopair_grav_mm_batch_flush(
+    struct runner *r, struct runner_grav_mm_batch *b) {
+
+  /* Some constants */
+  const struct engine *e = r->e;
+  const int periodic = e->mesh->periodic;
+  const float r_s_inv = e->mesh->r_s_inv;
+
+  /* Anything to do here? */
+  if (b->m2l.count == 0) return;
+
+  TIMER_TIC;
+
+  /* Compute all the interactions at once */
+  gravity_M2L_batch_compute(&b->m2l, periodic, r_s_inv);
+
+#ifndef SWIFT_TASKS_WITHOUT_ATOMICS
+  /* Cell whose multipole we are currently holding.
+   * Note that the multipoles sourcing the interactions have already been
+   * copied to the batch, so we only ever hold one lock at a time. */
+  struct cell *locked = NULL;
+#endif
+
+  /* Add the results to the field tensors */
+  for (int n = 0; n < b->m2l.count; n++) {
+
+    struct cell *ci = b->ci[n];
+
+#ifndef SWIFT_TASKS_WITHOUT_ATOMICS
+    /* Lock the multipole (once for consecutive entries of the same cell) */
+    if (ci != locked) {
+      if (locked != NULL && lock_unlock(&locked->grav.mlock) != 0)
+        error("Failed to unlock multipole");
+      lock_lock(&ci->grav.mlock);
+      locked = ci;
+    }
+#endif
+
+    gravity_M2L_batch_apply(&ci->grav.multipole->pot, &b->m2l, n);
+  }
+
+#ifndef SWIFT_TASKS_WITHOUT_ATOMICS
+  /* Unlock the last multipole */
+  if (lock_unlock(&locked->grav.mlock) != 0)
+    error("Failed to unlock multipole");
+#endif
+
+  b->m2l.count = 0;
+
+  TIMER_TOC(timer_dopair_grav_mm);
+}
+
+/**
+ * @brief Adds the interaction of the field tensor in a cell with the
+ * multipole of another cell to a #runner_grav_mm_batch. The batch is
+ * computed when full.
+ *
+ * @param r The #runner.
+ * @param b The #runner_grav_mm_batch.
+ * @param ci The #cell with field tensor to interact.
+ * @param cj The #cell with the multipole.
+ */
+static INLINE void runner_dopair_grav_mm_batch_add(
+    struct runner *r, struct runner_grav_mm_batch *b, struct cell *restrict ci,
+    const struct cell *restrict cj) {
+
+  /* Some constants */
+  const struct engine *e = r->e;
+  const int periodic = e->mesh->periodic;
+  const double dim[3] = {e->mesh->dim[0], e->mesh->dim[1], e->mesh->dim[2]};
+
+  /* Short-cut to the multipole */
+  const struct multipole *multi_j = &cj->grav.multipole->m_pole;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (ci == cj) error("Interacting a cell with itself using M2L");
+
+  if (multi_j->num_gpart == 0)
+    error("Multipole does not seem to have been set.");
+
+  if (ci->grav.multipole->pot.ti_init != e->ti_current)
+    error("ci->grav tensor not initialised.");
+
+  if (cj->grav.ti_old_multipole != e->ti_current)
+    error(
+        "Undrifted multipole cj->grav.ti_old_multipole=%lld cj->nodeID=%d "
+        "ci->nodeID=%d e->ti_current=%lld",
+        cj->grav.ti_old_multipole, cj->nodeID, ci->nodeID, e->ti_current);
+#endif
+
+  const int n = gravity_M2L_batch_add(&b->m2l, multi_j, ci->grav.multipole->CoM,
+                                      cj->grav.multipole->CoM, periodic, dim);
+  b->ci[n] = ci;
+
+  if (b->m2l.count == GRAVITY_M2L_BATCH_SIZE)
+    runner_dopair_grav_mm_batch_flush(r, b);
+}
+
+/**
+ * @brief Adds the M-M interactions of two cells to a #runner_grav_mm_batch
+ * if they are active.
+ *
+ * This is the batched equivalent of runner_dopair_grav_mm().
+ *
+ * @param r The #runner object.
+ * @param b The #runner_grav_mm_batch.
+ * @param ci The first #cell.
+ * @param cj The second #cell.
+ */
+static INLINE void runner_dopair_grav_mm_batched(
+    struct runner *r, struct runner_grav_mm_batch *b, struct cell *restrict ci,
+    struct cell *restrict cj) {
+
+  const struct engine *e = r->e;
+
+  /* What do we need to do? */
+  const int do_i =
+      cell_is_active_gravity_mm(ci, e) && (ci->nodeID == e->nodeID);
+  const int do_j =
+      cell_is_active_gravity_mm(cj, e) && (cj->nodeID == e->nodeID);
+
+  /* Do we need drifting first? */
+  if (ci->grav.ti_old_multipole < e->ti_current) cell_drift_multipole(ci, e);
+  if (cj->grav.ti_old_multipole < e->ti_current) cell_drift_multipole(cj, e);
+
+  /* Queue the interactions */
+  if (do_i) runner_dopair_grav_mm_batch_add(r, b, ci, cj);
+  if (do_j) runner_dopair_grav_mm_batch_add(r, b, cj, ci);
+}
+
 /**
  * @brief Computes all the M-M interactions between all the well-separated (at
  * rebuild) pairs of progenies of the two cells.
@@ -2064,6 +2249,10 @@ void runner_dopair_grav_mm_progenies(struct runner *r, const long long flags,
   runner_clear_grav_flags(ci, e);
   runner_clear_grav_flags(cj, e);
 
+  /* Collect the interactions to compute them in batches */
+  struct runner_grav_mm_batch batch;
+  gravity_M2L_batch_init(&batch.m2l);
+
   /* Loop over all pairs of progenies */
   for (int i = 0; i < 8; i++) {
     if (ci->progeny[i] != NULL) {
@@ -2076,11 +2265,15 @@ void runner_dopair_grav_mm_progenies(struct runner *r, const long long flags,
           const int flag = i * 8 + j;
 
           /* Did we agree to use an M-M interaction here at the last rebuild? */
-          if (flags & (1ULL << flag)) runner_dopair_grav_mm(r, cpi, cpj);
+          if (flags & (1ULL << flag))
+            runner_dopair_grav_mm_batched(r, &batch, cpi, cpj);
         }
       }
     }
   }
+
+  /* Compute the remaining interactions */
+  runner_dopair_grav_mm_batch_flush(r, &batch);
 }
 
 void runner_dopair_recursive_grav_pm(struct runner *r, struct cell *ci,
@@ -2145,9 +2338,11 @@ void runner_dopair_recursive_grav_pm(struct runner *r, struct cell *ci,
 #endif
 
     /* Fill the cache */
+    TIMER_TIC2;
     gravity_cache_populate_all_mpole(
         e->max_active_bin, periodic, dim, ci_cache, ci->grav.parts, gcount_i,
         gcount_padded_i, ci, CoM_j, cj->grav.multipole, e->gravity_properties);
+    TIMER_TOC2(timer_grav_cache_populate);
 
     /* Can we use the Newtonian version or do we need the truncated one ? */
     if (!periodic) {
@@ -2414,15 +2609,174 @@ void runner_doself_recursive_grav(struct runner *r, struct cell *c,
   if (gettimer) TIMER_TOC(timer_dosub_self_grav);
 }
 
+/**
+ * @brief Replays the tree walk recorded in a #gravity_interaction_list.
+ *
+ * This does the same work as runner_doself_recursive_grav() or
+ * runner_dopair_recursive_grav() but without re-evaluating the MAC at every
+ * level of the tree. The M-M and out-of-range entries were only accepted
+ * with the rebuild data of the multipoles, so they are handed back to the
+ * recursive walk, which opens them further if they are not valid anymore.
+ * The other pair entries are handed back to it along with their sub-walk
+ * once the particles have moved further than the entry allows.
+ *
+ * @param r The #runner.
+ * @param list The #gravity_interaction_list of the task.
+ */
+static void runner_do_grav_interaction_list(
+    struct runner *r, const struct gravity_interaction_list *list) {
+
+  const struct engine *e = r->e;
+  const int nodeID = e->nodeID;
+
+  int i = 0;
+  while (i < list->count) {
+
+    const struct gravity_interaction *in = &list->entries[i];
+    struct cell *ci = in->ci;
+    struct cell *cj = in->cj;
+
+    /* Self interaction? */
+    if (cj == NULL) {
+
+      /* Clear the flags */
+      runner_clear_grav_flags(ci, e);
+
+      /* Anything to do here? If not, skip the whole sub-walk */
+      if (!cell_is_active_gravity(ci, e)) {
+        i = in->next;
+        continue;
+      }
+
+      if (in->type == gravity_interaction_self_pp) runner_doself_grav_pp(r, ci);
+
+      ++i;
+      continue;
+    }
+
+    /* Clear the flags */
+    runner_clear_grav_flags(ci, e);
+    runner_clear_grav_flags(cj, e);
+
+    /* Anything to do here? If not, skip the whole sub-walk */
+    if (!((cell_is_active_gravity(ci, e) && ci->nodeID == nodeID) ||
+          (cell_is_active_gravity(cj, e) && cj->nodeID == nodeID))) {
+      i = in->next;
+      continue;
+    }
+
+    /* Have the particles moved too much for the recorded decision?
+     * If so, walk the whole sub-tree again. */
+    if (in->type != gravity_interaction_pair_mm &&
+        in->type != gravity_interaction_pair_out_of_range &&
+        !gravity_interaction_list_entry_is_valid(in)) {
+      runner_dopair_recursive_grav(r, ci, cj, 0);
+      i = in->next;
+      continue;
+    }
+
+    switch (in->type) {
+      case gravity_interaction_pair_split:
+        /* Nothing to do, the progenies follow */
+        break;
+      case gravity_interaction_pair_pp:
+        runner_dopair_grav_pp(r, ci, cj, /*symmetric*/ 1, /*allow_mpoles=*/1);
+        break;
+      case gravity_interaction_pair_pp_no_cache:
+        runner_dopair_grav_pp_no_cache(r, ci, cj);
+        runner_dopair_grav_pp_no_cache(r, cj, ci);
+        break;
+      case gravity_interaction_pair_mm:
+      case gravity_interaction_pair_out_of_range:
+        runner_dopair_recursive_grav(r, ci, cj, 0);
+        break;
+      default:
+        error("Invalid gravity interaction type (%d).", in->type);
+    }
+
+    ++i;
+  }
+}
+
+/**
+ * @brief Computes the interaction of all the particles in a cell using the
+ * tree walk recorded when the tasks were constructed.
+ *
+ * @param r The #runner.
+ * @param list The #gravity_interaction_list of the task.
+ * @param gettimer Are we timing this ?
+ */
+void runner_doself_grav_interaction_list(
+    struct runner *r, const struct gravity_interaction_list *list,
+    const int gettimer) {
+
+  TIMER_TIC;
+
+  runner_do_grav_interaction_list(r, list);
+
+  if (gettimer) TIMER_TOC(timer_dosub_self_grav);
+}
+
+/**
+ * @brief Computes the interaction of all the particles in a cell with all the
+ * particles of another cell using the tree walk recorded when the tasks were
+ * constructed.
+ *
+ * @param r The #runner.
+ * @param list The #gravity_interaction_list of the task.
+ * @param gettimer Are we timing this ?
+ */
+void runner_dopair_grav_interaction_list(
+    struct runner *r, const struct gravity_interaction_list *list,
+    const int gettimer) {
+
+  TIMER_TIC;
+
+  runner_do_grav_interaction_list(r, list);
+
+  if (gettimer) TIMER_TOC(timer_dosub_pair_grav);
+}
+
+/**
+ * @brief Accounts for a top-level cell beyond the truncation radius in the
+ * long-range gravity task.
+ *
+ * @param multi_i The #gravity_tensors receiving the interactions.
+ * @param multi_j The #gravity_tensors of the distant cell.
+ */
+static INLINE void runner_grav_long_range_out_of_range(
+    struct gravity_tensors *const multi_i,
+    const struct gravity_tensors *const multi_j) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+  /* Need to account for the interactions we missed */
+  accumulate_add_ll(&multi_i->pot.num_interacted, multi_j->m_pole.num_gpart);
+#endif
+
+#ifdef SWIFT_GRAVITY_FORCE_CHECKS
+  /* Need to account for the interactions we missed */
+  accumulate_add_ll(&multi_i->pot.num_interacted_pm,
+                    multi_j->m_pole.num_gpart);
+#endif
+
+  /* Record that this multipole received a contribution */
+  multi_i->pot.interacted = 1;
+}
+
 /**
  * @brief Performs all M-M interactions between a given top-level cell and all
  * the other top-levels that are far enough.
  *
+ * If a #gravity_interaction_list is provided, the top-level cells recorded
+ * in it are used instead of testing all of them again.
+ *
  * @param r The thread #runner.
  * @param ci The #cell of interest.
+ * @param list The #gravity_interaction_list of the task (or NULL).
  * @param timer Are we timing this ?
  */
 void runner_do_grav_long_range(struct runner *r, struct cell *ci,
+                               const struct gravity_interaction_list *list,
                                const int timer) {
 
   /* Some constants */
@@ -2454,6 +2808,45 @@ void runner_do_grav_long_range(struct runner *r, struct cell *ci,
   struct cell *top = ci;
   while (top->parent != NULL) top = top->parent;
 
+  /* Does the field tensor of this cell need the interactions? */
+  const int do_mm = cell_is_active_gravity_mm(ci, e);
+
+  /* Collect the interactions to compute them in batches */
+  struct runner_grav_mm_batch batch;
+  gravity_M2L_batch_init(&batch.m2l);
+
+  /* Replay the interactions recorded at the last rebuild? */
+  if (list != NULL) {
+
+    for (int n = 0; n < list->count; ++n) {
+
+      const struct gravity_interaction *in = &list->entries[n];
+      struct cell *cj = in->cj;
+      struct gravity_tensors *const multi_j = cj->grav.multipole;
+
+      /* Skip empty cells */
+      if (multi_j->m_pole.M_000 == 0.f) continue;
+
+      if (in->type == gravity_interaction_pair_out_of_range) {
+        runner_grav_long_range_out_of_range(multi_i, multi_j);
+        continue;
+      }
+
+      if (do_mm) runner_dopair_grav_mm_batch_add(r, &batch, ci, cj);
+
+      /* Record that this multipole received a contribution */
+      multi_i->pot.interacted = 1;
+    }
+
+    if (list->has_out_of_range) multi_i->pot.interacted = 1;
+
+    /* Compute the remaining interactions */
+    runner_dopair_grav_mm_batch_flush(r, &batch);
+
+    if (timer) TIMER_TOC(timer_dograv_long_range);
+    return;
+  }
+
   /* Loop over all the top-level cells and go for a M-M interaction if
    * well-separated */
   for (int n = 0; n < nr_cells_with_particles; ++n) {
@@ -2478,20 +2871,7 @@ void runner_do_grav_long_range(struct runner *r, struct cell *ci,
       /* Are we beyond the distance where the truncated forces are 0 ?*/
       if (min_radius2 > max_distance2) {
 
-#ifdef SWIFT_DEBUG_CHECKS
-        /* Need to account for the interactions we missed */
-        accumulate_add_ll(&multi_i->pot.num_interacted,
-                          multi_j->m_pole.num_gpart);
-#endif
-
-#ifdef SWIFT_GRAVITY_FORCE_CHECKS
-        /* Need to account for the interactions we missed */
-        accumulate_add_ll(&multi_i->pot.num_interacted_pm,
-                          multi_j->m_pole.num_gpart);
-#endif
-
-        /* Record that this multipole received a contribution */
-        multi_i->pot.interacted = 1;
+        runner_grav_long_range_out_of_range(multi_i, multi_j);
 
         /* We are done here. */
         continue;
@@ -2502,7 +2882,7 @@ void runner_do_grav_long_range(struct runner *r, struct cell *ci,
                              /*is_tree_walk=*/0)) {
 
       /* Call the PM interaction fucntion on the active sub-cells of ci */
-      runner_dopair_grav_mm_nonsym(r, ci, cj);
+      if (do_mm) runner_dopair_grav_mm_batch_add(r, &batch, ci, cj);
       // runner_dopair_recursive_grav_pm(r, ci, cj);
 
       /* Record that this multipole received a contribution */
@@ -2511,5 +2891,8 @@ void runner_do_grav_long_range(struct runner *r, struct cell *ci,
     } /* We are in charge of this pair */
   }   /* Loop over top-level cells */
 
+  /* Compute the remaining interactions */
+  runner_dopair_grav_mm_batch_flush(r, &batch);
+
   if (timer) TIMER_TOC(timer_dograv_long_range);
 }
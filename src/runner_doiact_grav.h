@@ -24,6 +24,7 @@
 
 struct runner;
 struct cell;
+struct gravity_interaction_list;
 
 void runner_do_grav_down(struct runner *r, struct cell *c, int timer);
 
@@ -36,11 +37,21 @@ void runner_doself_recursive_grav(struct runner *r, struct cell *c,
 void runner_dopair_recursive_grav(struct runner *r, struct cell *ci,
                                   struct cell *cj, int gettimer);
 
+void runner_doself_grav_interaction_list(
+    struct runner *r, const struct gravity_interaction_list *list,
+    int gettimer);
+
+void runner_dopair_grav_interaction_list(
+    struct runner *r, const struct gravity_interaction_list *list,
+    int gettimer);
+
 void runner_dopair_grav_mm_progenies(struct runner *r, const long long flags,
                                      struct cell *restrict ci,
                                      struct cell *restrict cj);
 
-void runner_do_grav_long_range(struct runner *r, struct cell *ci, int timer);
+void runner_do_grav_long_range(struct runner *r, struct cell *ci,
+                               const struct gravity_interaction_list *list,
+                               int timer);
 
 /* Internal functions (for unit tests and debugging) */
 
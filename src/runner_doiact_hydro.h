@@ -95,6 +95,9 @@
 #define _DOSUB_SUBSET(f) PASTE(runner_dosub_subset, f)
 #define DOSUB_SUBSET _DOSUB_SUBSET(FUNCTION)
 
+#define _DOLIST_SUBSET(f) PASTE(runner_dolist_subset, f)
+#define DOLIST_SUBSET _DOLIST_SUBSET(FUNCTION)
+
 #define _IACT_NONSYM(f) PASTE(runner_iact_nonsym, f)
 #define IACT_NONSYM _IACT_NONSYM(FUNCTION)
 
@@ -124,6 +127,25 @@
   {}
 #endif
 
+#if (FUNCTION_TASK_LOOP == TASK_LOOP_FORCE) && defined(HYDRO_FLUX_BATCH)
+/* Schemes solving a Riemann problem per pair queue them in a batch */
+#define IACT_BATCH(r2, dx, hi, hj, pi, pj, a, H) \
+  runner_iact_force_batch(&flux_batch, r2, dx, hi, hj, pi, pj, a, H)
+#define IACT_NONSYM_BATCH(r2, dx, hi, hj, pi, pj, a, H) \
+  runner_iact_nonsym_force_batch(&flux_batch, r2, dx, hi, hj, pi, pj, a, H)
+#define IACT_BATCH_INIT()             \
+  struct hydro_flux_batch flux_batch; \
+  hydro_flux_batch_init(&flux_batch)
+#define IACT_BATCH_FLUSH() hydro_flux_batch_flush(&flux_batch)
+#else
+#define IACT_BATCH IACT
+#define IACT_NONSYM_BATCH IACT_NONSYM
+#define IACT_BATCH_INIT() \
+  {}
+#define IACT_BATCH_FLUSH() \
+  {}
+#endif
+
 #if (FUNCTION_TASK_LOOP == TASK_LOOP_RT_GRADIENT) || \
     (FUNCTION_TASK_LOOP == TASK_LOOP_RT_TRANSPORT)
 /* RT specific function calls */
@@ -189,3 +211,10 @@ void DOPAIR_SUBSET_BRANCH(struct runner *r, struct cell *restrict ci,
 
 void DOSUB_SUBSET(struct runner *r, struct cell *ci, struct part *parts,
                   int *ind, int count, struct cell *cj, int gettimer);
+
+#if (FUNCTION_TASK_LOOP == TASK_LOOP_DENSITY)
+void DOLIST_SUBSET(struct runner *r, struct part *restrict parts,
+                   const int *restrict ind, int count,
+                   const struct runner_ngb *restrict ngbs,
+                   const int *restrict first, const int *restrict num);
+#endif
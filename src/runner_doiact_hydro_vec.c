@@ -23,9 +23,11 @@
 /* This object's header. */
 #include "runner_doiact_hydro_vec.h"
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
 
+#ifdef HYDRO_VEC_FORCE_LOOP
 static const vector kernel_gamma2_vec = FILL_VEC(kernel_gamma2);
+#endif
 
 /**
  * @brief Compute the vector remainder interactions from the secondary cache.
@@ -637,7 +639,7 @@ __attribute__((always_inline)) INLINE static int populate_max_index_subset(
   }
 }
 
-#endif /* WITH_VECTORIZATION && GADGET2_SPH */
+#endif /* WITH_VECTORIZATION && HYDRO_VEC_DENSITY_LOOP */
 
 /**
  * @brief Compute the cell self-interaction (non-symmetric) using vector
@@ -648,7 +650,7 @@ __attribute__((always_inline)) INLINE static int populate_max_index_subset(
  */
 void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
 
   /* Get some local variables */
   const struct engine *e = r->e;
@@ -849,14 +851,9 @@ void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
     }
 
     /* Perform horizontal adds on vector sums and store result in pi. */
-    VEC_HADD(v_rhoSum, pi->rho);
-    VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
-    VEC_HADD(v_wcountSum, pi->density.wcount);
-    VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
-    VEC_HADD(v_div_vSum, pi->density.div_v);
-    VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
-    VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
-    VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
+    runner_iact_nonsym_vec_density_reduce(
+        pi, v_rhoSum, v_rho_dhSum, v_wcountSum, v_wcount_dhSum, v_div_vSum,
+        v_curlvxSum, v_curlvySum, v_curlvzSum);
 
     /* Reset interaction count. */
     icount = 0;
@@ -885,7 +882,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
                                       struct part *restrict parts,
                                       int *restrict ind, int pi_count) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
 
   const int count = c->hydro.count;
 
@@ -1083,14 +1080,9 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
 
     /* Perform horizontal adds on vector sums and store result in particle pi.
      */
-    VEC_HADD(v_rhoSum, pi->rho);
-    VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
-    VEC_HADD(v_wcountSum, pi->density.wcount);
-    VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
-    VEC_HADD(v_div_vSum, pi->density.div_v);
-    VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
-    VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
-    VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
+    runner_iact_nonsym_vec_density_reduce(
+        pi, v_rhoSum, v_rho_dhSum, v_wcountSum, v_wcount_dhSum, v_div_vSum,
+        v_curlvxSum, v_curlvySum, v_curlvzSum);
 
     /* Reset interaction count. */
     icount = 0;
@@ -1114,7 +1106,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
  */
 void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE_LOOP)
 
   const struct engine *e = r->e;
   const struct cosmology *restrict cosmo = e->cosmology;
@@ -1306,7 +1298,7 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
                                 struct cell *cj, const int sid,
                                 const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
 
   const struct engine *restrict e = r->e;
   const timebin_t max_active_bin = e->max_active_bin;
@@ -1538,14 +1530,9 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
       } /* loop over the parts in cj. */
 
       /* Perform horizontal adds on vector sums and store result in pi. */
-      VEC_HADD(v_rhoSum, pi->rho);
-      VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
-      VEC_HADD(v_wcountSum, pi->density.wcount);
-      VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
-      VEC_HADD(v_div_vSum, pi->density.div_v);
-      VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
-      VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
-      VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
+      runner_iact_nonsym_vec_density_reduce(
+          pi, v_rhoSum, v_rho_dhSum, v_wcountSum, v_wcount_dhSum, v_div_vSum,
+          v_curlvxSum, v_curlvySum, v_curlvzSum);
 
     } /* loop over the parts in ci. */
   }
@@ -1679,14 +1666,9 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
       } /* loop over the parts in ci. */
 
       /* Perform horizontal adds on vector sums and store result in pj. */
-      VEC_HADD(v_rhoSum, pj->rho);
-      VEC_HADD(v_rho_dhSum, pj->density.rho_dh);
-      VEC_HADD(v_wcountSum, pj->density.wcount);
-      VEC_HADD(v_wcount_dhSum, pj->density.wcount_dh);
-      VEC_HADD(v_div_vSum, pj->density.div_v);
-      VEC_HADD(v_curlvxSum, pj->density.rot_v[0]);
-      VEC_HADD(v_curlvySum, pj->density.rot_v[1]);
-      VEC_HADD(v_curlvzSum, pj->density.rot_v[2]);
+      runner_iact_nonsym_vec_density_reduce(
+          pj, v_rhoSum, v_rho_dhSum, v_wcountSum, v_wcount_dhSum, v_div_vSum,
+          v_curlvxSum, v_curlvySum, v_curlvzSum);
 
     } /* loop over the parts in cj. */
   }
@@ -1721,7 +1703,7 @@ void runner_dopair_subset_density_vec(struct runner *r,
                                       struct cell *restrict cj, const int sid,
                                       const int flipped, const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_DENSITY_LOOP)
 
   TIMER_TIC;
 
@@ -1882,14 +1864,9 @@ void runner_dopair_subset_density_vec(struct runner *r,
       } /* loop over the parts in cj. */
 
       /* Perform horizontal adds on vector sums and store result in pi. */
-      VEC_HADD(v_rhoSum, pi->rho);
-      VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
-      VEC_HADD(v_wcountSum, pi->density.wcount);
-      VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
-      VEC_HADD(v_div_vSum, pi->density.div_v);
-      VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
-      VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
-      VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
+      runner_iact_nonsym_vec_density_reduce(
+          pi, v_rhoSum, v_rho_dhSum, v_wcountSum, v_wcount_dhSum, v_div_vSum,
+          v_curlvxSum, v_curlvySum, v_curlvzSum);
 
     } /* loop over the parts in ci. */
   }
@@ -2030,14 +2007,9 @@ void runner_dopair_subset_density_vec(struct runner *r,
       } /* loop over the parts in cj. */
 
       /* Perform horizontal adds on vector sums and store result in pi. */
-      VEC_HADD(v_rhoSum, pi->rho);
-      VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
-      VEC_HADD(v_wcountSum, pi->density.wcount);
-      VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
-      VEC_HADD(v_div_vSum, pi->density.div_v);
-      VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
-      VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
-      VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
+      runner_iact_nonsym_vec_density_reduce(
+          pi, v_rhoSum, v_rho_dhSum, v_wcountSum, v_wcount_dhSum, v_div_vSum,
+          v_curlvxSum, v_curlvySum, v_curlvzSum);
 
     } /* loop over the parts in ci. */
   }
@@ -2060,7 +2032,7 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
                               struct cell *cj, const int sid,
                               const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#if defined(WITH_VECTORIZATION) && defined(HYDRO_VEC_FORCE_LOOP)
 
   const struct engine *restrict e = r->e;
   const struct cosmology *restrict cosmo = e->cosmology;
@@ -27,6 +27,10 @@
 #undef IACT_NONSYM
 #undef IACT_MHD
 #undef IACT_NONSYM_MHD
+#undef IACT_BATCH
+#undef IACT_NONSYM_BATCH
+#undef IACT_BATCH_INIT
+#undef IACT_BATCH_FLUSH
 #undef IACT_STARS
 #undef IACT_BH_GAS
 #undef IACT_BH_BH
@@ -22,6 +22,9 @@
 /* Config parameters. */
 #include <config.h>
 
+/* Some standard headers. */
+#include <string.h>
+
 /* This object's header. */
 #include "runner.h"
 
@@ -1075,6 +1078,230 @@ void runner_do_extra_ghost(struct runner *r, struct cell *c, int timer) {
 #endif
 }
 
+/**
+ * @brief Candidate neighbour lists of the particles of a cell whose smoothing
+ * length has not converged after the first pass of the ghost.
+ */
+struct ghost_ngb_lists {
+
+  /*! The cells the density loop interacts the particles with. */
+  struct cell **cells;
+
+  /*! The periodic shift to apply to the particles of each cell. */
+  double (*shifts)[3];
+
+  /*! The number of cells. */
+  int nr_cells;
+
+  /*! The recorded candidates. */
+  struct runner_ngb *ngbs;
+
+  /*! The number of candidates recorded and allocated. */
+  int size, alloc;
+
+  /*! Index of the first candidate of each particle. */
+  int *first;
+
+  /*! Number of candidates of each particle. */
+  int *num;
+
+  /*! Smoothing length up to which the candidates of a particle are complete
+   * (0 if no list was recorded yet). */
+  float *h;
+};
+
+/**
+ * @brief Collect the cells a leaf #cell interacts with in the density loop
+ * and allocate the lists of its particles.
+ *
+ * The candidates themselves are only allocated when they are recorded.
+ *
+ * @param lists The #ghost_ngb_lists to set up.
+ * @param e The #engine.
+ * @param c The leaf #cell.
+ * @param count The number of particles whose smoothing length has not
+ * converged yet. It can only decrease in the later iterations.
+ */
+static void ghost_ngb_lists_init(struct ghost_ngb_lists *lists,
+                                 const struct engine *e, struct cell *c,
+                                 const int count) {
+
+  /* Count the interactions all the way up the hierarchy. */
+  int nr_links = 0;
+  for (struct cell *finger = c; finger != NULL; finger = finger->parent)
+    for (struct link *l = finger->hydro.density; l != NULL; l = l->next)
+      nr_links++;
+
+  if ((lists->cells = (struct cell **)malloc(sizeof(struct cell *) *
+                                             nr_links)) == NULL ||
+      (lists->shifts = (double(*)[3])malloc(sizeof(double) * 3 * nr_links)) ==
+          NULL)
+    error("Can't allocate memory for the neighbour list cells.");
+
+  /* Record the other cell of each interaction, with its periodic shift. */
+  int nr_cells = 0;
+  for (struct cell *finger = c; finger != NULL; finger = finger->parent) {
+    for (struct link *l = finger->hydro.density; l != NULL; l = l->next) {
+
+      struct cell *cj;
+      if (l->t->type == task_type_self || l->t->type == task_type_sub_self)
+        cj = finger;
+      else if (l->t->ci == finger)
+        cj = l->t->cj;
+      else
+        cj = l->t->ci;
+
+      double *shift = lists->shifts[nr_cells];
+      for (int k = 0; k < 3; k++) {
+        shift[k] = 0.0;
+        if (cj->loc[k] - finger->loc[k] < -e->s->dim[k] / 2)
+          shift[k] = e->s->dim[k];
+        else if (cj->loc[k] - finger->loc[k] > e->s->dim[k] / 2)
+          shift[k] = -e->s->dim[k];
+      }
+      lists->cells[nr_cells++] = cj;
+    }
+  }
+  lists->nr_cells = nr_cells;
+
+  lists->ngbs = NULL;
+  lists->size = 0;
+  lists->alloc = 0;
+  if ((lists->first = (int *)malloc(sizeof(int) * count)) == NULL ||
+      (lists->num = (int *)malloc(sizeof(int) * count)) == NULL ||
+      (lists->h = (float *)calloc(count, sizeof(float))) == NULL)
+    error("Can't allocate memory for the neighbour lists.");
+}
+
+/**
+ * @brief Record new candidate lists for the particles whose smoothing length
+ * went beyond the one their list was recorded for.
+ *
+ * @param lists The #ghost_ngb_lists.
+ * @param e The #engine.
+ * @param parts The #part of the cell.
+ * @param pid The indices of the particles still iterating.
+ * @param count The number of particles in @c pid.
+ * @param h_factor The ratio of the list radius to the smoothing length.
+ */
+static void ghost_ngb_lists_update(struct ghost_ngb_lists *lists,
+                                   const struct engine *e,
+                                   struct part *restrict parts,
+                                   const int *pid, const int count,
+                                   const float h_factor) {
+
+  /* Count the lists to record and the candidates of the lists we keep. */
+  int nr_record = 0, nr_kept = 0;
+  for (int i = 0; i < count; i++) {
+    if (parts[pid[i]].h > lists->h[i])
+      nr_record++;
+    else
+      nr_kept += lists->num[i];
+  }
+  if (nr_record == 0) return;
+
+  /* Make room for the kept lists and the expected number of candidates of
+   * the new ones, i.e. the neighbours within the larger list radius. */
+  const float ngbs_per_list =
+      e->hydro_properties->target_neighbours * pow_dimension(h_factor);
+  const int alloc = nr_kept + (int)(nr_record * ngbs_per_list) + 1;
+  struct runner_ngb *ngbs =
+      (struct runner_ngb *)malloc(sizeof(struct runner_ngb) * alloc);
+  if (ngbs == NULL)
+    error("Can't allocate %d entries for the neighbour lists.", alloc);
+
+  /* Compact the lists we keep, dropping the ones of the particles that have
+   * converged or are about to be recorded again. */
+  int size = 0;
+  for (int i = 0; i < count; i++) {
+    if (parts[pid[i]].h > lists->h[i]) continue;
+    memcpy(&ngbs[size], &lists->ngbs[lists->first[i]],
+           sizeof(struct runner_ngb) * lists->num[i]);
+    lists->first[i] = size;
+    size += lists->num[i];
+  }
+  free(lists->ngbs);
+  lists->ngbs = ngbs;
+  lists->size = size;
+  lists->alloc = alloc;
+
+  for (int i = 0; i < count; i++) {
+
+    struct part *restrict pi = &parts[pid[i]];
+
+    /* Is the current list still complete? */
+    if (pi->h <= lists->h[i]) continue;
+
+    const float h_list = h_factor * pi->h;
+    const double r_list = kernel_gamma * h_list;
+    const float r2_list = r_list * r_list;
+
+    lists->first[i] = lists->size;
+    lists->num[i] = 0;
+    lists->h[i] = h_list;
+
+    for (int n = 0; n < lists->nr_cells; n++) {
+
+      const struct cell *cj = lists->cells[n];
+      const double *shift = lists->shifts[n];
+      const double pix[3] = {pi->x[0] - shift[0], pi->x[1] - shift[1],
+                             pi->x[2] - shift[2]};
+
+      /* Skip the cells out of reach. */
+      double d2 = 0.;
+      for (int k = 0; k < 3; k++) {
+        const double d = max(cj->loc[k] - pix[k],
+                             pix[k] - cj->loc[k] - cj->width[k]);
+        if (d > 0.) d2 += d * d;
+      }
+      if (d2 > r2_list) continue;
+
+      struct part *restrict parts_j = cj->hydro.parts;
+      for (int j = 0; j < cj->hydro.count; j++) {
+
+        struct part *restrict pj = &parts_j[j];
+        if (pj == pi) continue;
+
+        const float dx[3] = {(float)(pix[0] - pj->x[0]),
+                             (float)(pix[1] - pj->x[1]),
+                             (float)(pix[2] - pj->x[2])};
+        const float r2 = dx[0] * dx[0] + dx[1] * dx[1] + dx[2] * dx[2];
+        if (r2 >= r2_list) continue;
+
+        /* Make some room if needed. */
+        if (lists->size == lists->alloc) {
+          lists->alloc *= 2;
+          lists->ngbs = (struct runner_ngb *)realloc(
+              lists->ngbs, sizeof(struct runner_ngb) * lists->alloc);
+          if (lists->ngbs == NULL)
+            error("Can't grow the neighbour lists to %d entries.",
+                  lists->alloc);
+        }
+
+        struct runner_ngb *ngb = &lists->ngbs[lists->size++];
+        ngb->pj = pj;
+        ngb->dx[0] = dx[0];
+        ngb->dx[1] = dx[1];
+        ngb->dx[2] = dx[2];
+        ngb->r2 = r2;
+        lists->num[i]++;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Free the memory used by a #ghost_ngb_lists.
+ */
+static void ghost_ngb_lists_clean(struct ghost_ngb_lists *lists) {
+  free(lists->cells);
+  free(lists->shifts);
+  free(lists->ngbs);
+  free(lists->first);
+  free(lists->num);
+  free(lists->h);
+}
+
 /**
  * @brief Intermediate task after the density to check that the smoothing
  * lengths are correct.
@@ -1107,6 +1334,7 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
   const int use_mass_weighted_num_ngb =
       e->hydro_properties->use_mass_weighted_num_ngb;
   const int max_smoothing_iter = e->hydro_properties->max_smoothing_iterations;
+  const float ghost_list_h_factor = e->hydro_properties->ghost_list_h_factor;
   int redo = 0, count = 0;
 
   /* Running value of the maximal smoothing length */
@@ -1146,6 +1374,11 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
       error("Can't allocate memory for left.");
     if ((right = (float *)malloc(sizeof(float) * c->hydro.count)) == NULL)
       error("Can't allocate memory for right.");
+    /* Candidate neighbours of the particles needing more iterations, only
+     * recorded once some particles fail to converge in the first pass. */
+    struct ghost_ngb_lists lists = {0};
+    int with_lists = 0;
+
     for (int k = 0; k < c->hydro.count; k++)
       if (part_is_active(&parts[k], e)) {
         pid[count] = k;
@@ -1377,6 +1610,11 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
             h_0[redo] = h_0[i];
             left[redo] = left[i];
             right[redo] = right[i];
+            if (with_lists) {
+              lists.first[redo] = lists.first[i];
+              lists.num[redo] = lists.num[i];
+              lists.h[redo] = lists.h[i];
+            }
             redo += 1;
 
             /* Re-initialise everything */
@@ -1504,7 +1742,20 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
 
       /* Re-set the counter for the next loop (potentially). */
       count = redo;
-      if (count > 0) {
+      if (count > 0 && ghost_list_h_factor > 0.f) {
+
+        /* Serve the iteration from the candidate neighbour lists, recording
+         * them first where they do not cover the new smoothing length. */
+        if (!with_lists) {
+          ghost_ngb_lists_init(&lists, e, c, count);
+          with_lists = 1;
+        }
+        ghost_ngb_lists_update(&lists, e, parts, pid, count,
+                               ghost_list_h_factor);
+        runner_dolist_subset_density(r, parts, pid, count, lists.ngbs,
+                                     lists.first, lists.num);
+
+      } else if (count > 0) {
 
         /* Climb up the cell hierarchy. */
         for (struct cell *finger = c; finger != NULL; finger = finger->parent) {
@@ -1567,6 +1818,7 @@ void runner_do_ghost(struct runner *r, struct cell *c, int timer) {
     }
 
     /* Be clean */
+    if (with_lists) ghost_ngb_lists_clean(&lists);
     free(left);
     free(right);
     free(pid);
@@ -37,6 +37,7 @@
 #include "scheduler.h"
 #include "space_getsid.h"
 #include "timers.h"
+#include "trace.h"
 
 /* Import the gravity loop functions. */
 #include "runner_doiact_grav.h"
@@ -136,6 +137,9 @@ void *runner_main(void *data) {
   struct engine *e = r->e;
   struct scheduler *sched = &e->sched;
 
+  /* Get a trace buffer, if tracing. */
+  trace_thread_init("runner", r->id);
+
   /* Main loop. */
   while (1) {
 
@@ -149,6 +153,11 @@ void *runner_main(void *data) {
     struct task *t = NULL;
     struct task *prev = NULL;
 
+    /* The particles may have changed since the last call, so the content of
+     * the gravity caches cannot be re-used. */
+    gravity_cache_invalidate(&r->ci_gravity_cache);
+    gravity_cache_invalidate(&r->cj_gravity_cache);
+
     /* Loop while there are tasks... */
     while (1) {
 
@@ -204,6 +213,8 @@ void *runner_main(void *data) {
             runner_doself2_branch_force(r, ci);
           else if (t->subtype == task_subtype_limiter)
             runner_doself1_branch_limiter(r, ci);
+          else if (t->subtype == task_subtype_grav && t->grav_list != NULL)
+            runner_doself_grav_interaction_list(r, t->grav_list, 1);
           else if (t->subtype == task_subtype_grav)
             runner_doself_recursive_grav(r, ci, 1);
           else if (t->subtype == task_subtype_external_grav)
@@ -254,6 +265,8 @@ void *runner_main(void *data) {
             runner_dopair2_branch_force(r, ci, cj);
           else if (t->subtype == task_subtype_limiter)
             runner_dopair1_branch_limiter(r, ci, cj);
+          else if (t->subtype == task_subtype_grav && t->grav_list != NULL)
+            runner_dopair_grav_interaction_list(r, t->grav_list, 1);
           else if (t->subtype == task_subtype_grav)
             runner_dopair_recursive_grav(r, ci, cj, 1);
           else if (t->subtype == task_subtype_stars_density)
@@ -547,7 +560,7 @@ void *runner_main(void *data) {
           runner_do_grav_down(r, t->ci, 1);
           break;
         case task_type_grav_long_range:
-          runner_do_grav_long_range(r, t->ci, 1);
+          runner_do_grav_long_range(r, t->ci, t->grav_list, 1);
           break;
         case task_type_grav_mm:
           runner_dopair_grav_mm_progenies(r, t->flags, t->ci, t->cj);
@@ -617,6 +630,7 @@ void *runner_main(void *data) {
       /* We're done with this task, see if we get a next one. */
       prev = t;
       t = scheduler_done(sched, t);
+      if (trace_active) trace_record_task(prev);
 
     } /* main loop. */
   }
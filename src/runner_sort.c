@@ -34,6 +34,10 @@
 /*! The size of the sorting stack used at the leaf level */
 const int sort_stack_size = 10;
 
+/*! Average number of places an entry may move when updating an old sort
+ * before we give up and use a full sort instead */
+const int sort_incremental_max_moves = 8;
+
 /**
  * @brief Sorts again all the stars in a given cell hierarchy.
  *
@@ -162,6 +166,44 @@ void runner_do_sort_ascending(struct sort_entry *sort, int N) {
   }
 }
 
+/**
+ * @brief Sort the entries in ascending order using an insertion sort.
+ *
+ * This is meant for entries that are already almost sorted, e.g. the
+ * previous sort of a cell updated with the new positions of its particles.
+ * We give up if the entries have to move too far to reach their sorted
+ * position, in which case they are left in an arbitrary order.
+ *
+ * @param sort The entries
+ * @param N The number of entries.
+ *
+ * @return 1 if the entries are now sorted, 0 if we gave up.
+ */
+static int runner_do_sort_ascending_incremental(struct sort_entry *sort,
+                                                int N) {
+
+  const long long max_moves = (long long)sort_incremental_max_moves * N;
+  long long moves = 0;
+
+  for (int i = 1; i < N; i++) {
+
+    /* Shift the larger entries to make room for this one. */
+    const struct sort_entry temp = sort[i];
+    int j = i - 1;
+    while (j >= 0 && sort[j].d > temp.d) {
+      sort[j + 1] = sort[j];
+      j--;
+    }
+    sort[j + 1] = temp;
+
+    /* Is this still cheaper than starting from scratch? */
+    moves += i - 1 - j;
+    if (moves > max_moves) return 0;
+  }
+
+  return 1;
+}
+
 #ifdef SWIFT_DEBUG_CHECKS
 /**
  * @brief Recursively checks that the flags are consistent in a cell hierarchy.
@@ -249,6 +291,9 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
   if (c->hydro.sorted == 0) c->hydro.ti_sort = r->e->ti_current;
 #endif
 
+  /* The arrays already allocated still hold the order of their last sort. */
+  const int old_sorts = c->hydro.sort_allocated & flags;
+
   /* Allocate memory for sorting. */
   cell_malloc_hydro_sorts(c, flags);
 
@@ -375,18 +420,34 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
       c->hydro.dx_max_sort = 0.f;
     }
 
-    /* Fill the sort array. */
-    for (int k = 0; k < count; k++) {
-      const double px[3] = {parts[k].x[0], parts[k].x[1], parts[k].x[2]};
-      for (int j = 0; j < 13; j++)
-        if (flags & (1 << j)) {
-          struct sort_entry *entries = cell_get_hydro_sorts(c, j);
-          entries[k].i = k;
+    /* Fill the new sort arrays. */
+    const int new_sorts = flags & ~old_sorts;
+    if (new_sorts) {
+      for (int k = 0; k < count; k++) {
+        const double px[3] = {parts[k].x[0], parts[k].x[1], parts[k].x[2]};
+        for (int j = 0; j < 13; j++)
+          if (new_sorts & (1 << j)) {
+            struct sort_entry *entries = cell_get_hydro_sorts(c, j);
+            entries[k].i = k;
+            entries[k].d = px[0] * runner_shift[j][0] +
+                           px[1] * runner_shift[j][1] +
+                           px[2] * runner_shift[j][2];
+          }
+      }
+    }
+
+    /* Update the distances of the old ones, keeping their order. The
+     * particles have not moved much since, so they are almost sorted. */
+    for (int j = 0; j < 13; j++)
+      if (old_sorts & (1 << j)) {
+        struct sort_entry *entries = cell_get_hydro_sorts(c, j);
+        for (int k = 0; k < count; k++) {
+          const double *px = parts[entries[k].i].x;
           entries[k].d = px[0] * runner_shift[j][0] +
                          px[1] * runner_shift[j][1] +
                          px[2] * runner_shift[j][2];
         }
-    }
+      }
 
     /* Add the sentinel and sort. */
     for (int j = 0; j < 13; j++)
@@ -394,7 +455,9 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
         struct sort_entry *entries = cell_get_hydro_sorts(c, j);
         entries[count].d = FLT_MAX;
         entries[count].i = 0;
-        runner_do_sort_ascending(entries, count);
+        if (!(old_sorts & (1 << j)) ||
+            !runner_do_sort_ascending_incremental(entries, count))
+          runner_do_sort_ascending(entries, count);
         atomic_or(&c->hydro.sorted, 1 << j);
       }
   }
@@ -36,6 +36,11 @@
 #include <mpi.h>
 #endif
 
+/* NUMA headers. */
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
 /* This object's header. */
 #include "scheduler.h"
 
@@ -44,6 +49,7 @@
 #include "cycle.h"
 #include "engine.h"
 #include "error.h"
+#include "gravity_interaction_list.h"
 #include "intrinsics.h"
 #include "kernel_hydro.h"
 #include "memuse.h"
@@ -55,6 +61,7 @@
 #include "task.h"
 #include "threadpool.h"
 #include "timers.h"
+#include "trace.h"
 #include "version.h"
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -1727,8 +1734,10 @@ struct task *scheduler_addtask(struct scheduler *s, enum task_types type,
   t->wait = 0;
   t->ci = ci;
   t->cj = cj;
+  t->grav_list = NULL;
   t->skip = 1; /* Mark tasks as skip by default. */
   t->implicit = implicit;
+  t->qid = 0;
   t->weight = 0;
   t->rank = 0;
   t->nr_unlock_tasks = 0;
@@ -1846,6 +1855,180 @@ void scheduler_set_unlocks(struct scheduler *s) {
   swift_free("offsets", offsets);
 }
 
+/**
+ * @brief Can the given #task be fused into the task that unlocks it?
+ *
+ * This is the case for implicit tasks that are unlocked by a single task,
+ * as long as that task is not a communication task, which relies on
+ * knowing its unique dependent.
+ *
+ * @param s The #scheduler.
+ * @param t The #task.
+ * @param nr_preds The number of tasks unlocking each task.
+ * @param preds The (last) task unlocking each task.
+ */
+static int scheduler_task_is_fusable(const struct scheduler *s,
+                                     const struct task *t, const int *nr_preds,
+                                     const int *preds) {
+  const int tid = t - s->tasks;
+  if (!t->implicit || nr_preds[tid] != 1) return 0;
+  const struct task *pred = &s->tasks[preds[tid]];
+  return pred->type != task_type_send && pred->type != task_type_recv;
+}
+
+/**
+ * @brief Append the unlocks of a #task to a list, replacing the fusable
+ * tasks by their own unlocks.
+ *
+ * @param s The #scheduler.
+ * @param t The #task.
+ * @param nr_preds The number of tasks unlocking each task.
+ * @param preds The (last) task unlocking each task.
+ * @param list The list to append to, or NULL to only count.
+ * @param count The current length of the list.
+ *
+ * @return The new length of the list.
+ */
+static int scheduler_fused_unlocks(const struct scheduler *s,
+                                   const struct task *t, const int *nr_preds,
+                                   const int *preds, struct task **list,
+                                   int count) {
+
+  for (int k = 0; k < t->nr_unlock_tasks; k++) {
+    struct task *u = t->unlock_tasks[k];
+
+    if (scheduler_task_is_fusable(s, u, nr_preds, preds)) {
+      count = scheduler_fused_unlocks(s, u, nr_preds, preds, list, count);
+      continue;
+    }
+
+    /* Avoid duplicates, e.g. if the fused task unlocked one of our
+     * unlocks as well. */
+    if (list != NULL) {
+      int found = 0;
+      for (int j = 0; j < count && !found; j++) found = (list[j] == u);
+      if (found) continue;
+    }
+    if (list != NULL) list[count] = u;
+    count++;
+  }
+
+  return count;
+}
+
+/**
+ * @brief Fuse the chains of implicit tasks into the tasks that unlock them.
+ *
+ * An implicit task that has a single task unlocking it does no work of its
+ * own and only passes that dependency on. We let the unlocking task directly
+ * unlock the dependents of the implicit task instead, and leave the
+ * implicit task without any dependency. If the implicit task is active, it
+ * is then "run" straight away when the tasks are started instead of having
+ * to go through the unlock cascade in the middle of the step.
+ *
+ * This only ever adds constraints: if the unlocking task is active but the
+ * implicit task is not, the dependents now also wait for the unlocking task.
+ *
+ * Must be called after scheduler_set_unlocks().
+ *
+ * @param s The #scheduler.
+ * @param verbose Are we talkative?
+ */
+void scheduler_fuse_implicit_tasks(struct scheduler *s, const int verbose) {
+
+  const ticks tic = getticks();
+  const int nr_tasks = s->nr_tasks;
+
+  /* Count the predecessors of each task. */
+  int *nr_preds, *preds;
+  if ((nr_preds = (int *)swift_malloc("nr_preds", sizeof(int) * nr_tasks)) ==
+          NULL ||
+      (preds = (int *)swift_malloc("preds", sizeof(int) * nr_tasks)) == NULL)
+    error("Failed to allocate temporary predecessor arrays.");
+  bzero(nr_preds, sizeof(int) * nr_tasks);
+  for (int k = 0; k < nr_tasks; k++) {
+    const struct task *t = &s->tasks[k];
+    for (int j = 0; j < t->nr_unlock_tasks; j++) {
+      const int uid = t->unlock_tasks[j] - s->tasks;
+      nr_preds[uid]++;
+      preds[uid] = k;
+    }
+  }
+
+  /* Count the new unlocks of each task. */
+  int *counts;
+  if ((counts = (int *)swift_malloc("counts", sizeof(int) * nr_tasks)) == NULL)
+    error("Failed to allocate temporary counts array.");
+  int nr_unlocks = 0, nr_fused = 0;
+  for (int k = 0; k < nr_tasks; k++) {
+    const struct task *t = &s->tasks[k];
+    if (scheduler_task_is_fusable(s, t, nr_preds, preds)) {
+      counts[k] = 0;
+      nr_fused++;
+    } else {
+      counts[k] = scheduler_fused_unlocks(s, t, nr_preds, preds, NULL, 0);
+    }
+    nr_unlocks += counts[k];
+  }
+
+  /* Nothing to do? */
+  if (nr_fused == 0) {
+    swift_free("nr_preds", nr_preds);
+    swift_free("preds", preds);
+    swift_free("counts", counts);
+    return;
+  }
+
+  /* Fill the new unlocks. We over-count the duplicates, if any. */
+  struct task **unlocks;
+  int *unlock_ind;
+  if ((unlocks = (struct task **)swift_malloc(
+           "unlocks", sizeof(struct task *) * s->size_unlocks)) == NULL ||
+      (unlock_ind = (int *)swift_malloc("unlock_ind",
+                                        sizeof(int) * s->size_unlocks)) == NULL)
+    error("Failed to allocate the fused unlocks.");
+  if (nr_unlocks > s->size_unlocks)
+    error("Fused unlocks do not fit in the unlocks array.");
+
+  int offset = 0;
+  for (int k = 0; k < nr_tasks; k++) {
+    struct task *t = &s->tasks[k];
+    const int count =
+        counts[k] == 0 ? 0
+                       : scheduler_fused_unlocks(s, t, nr_preds, preds,
+                                                 &unlocks[offset], 0);
+    for (int j = 0; j < count; j++) unlock_ind[offset + j] = k;
+    counts[k] = count;
+    offset += count;
+  }
+
+  /* Now that all the lists have been read, point the tasks to them. */
+  offset = 0;
+  for (int k = 0; k < nr_tasks; k++) {
+    struct task *t = &s->tasks[k];
+    t->nr_unlock_tasks = counts[k];
+    t->unlock_tasks = &unlocks[offset];
+    offset += counts[k];
+  }
+
+  /* Swap the unlocks. */
+  swift_free("unlocks", s->unlocks);
+  swift_free("unlock_ind", s->unlock_ind);
+  s->unlocks = unlocks;
+  s->unlock_ind = unlock_ind;
+  s->nr_unlocks = offset;
+
+  if (verbose)
+    message("Fused %d implicit tasks (%d unlocks left) took %.3f %s.",
+            nr_fused, offset, clocks_from_ticks(getticks() - tic),
+            clocks_getunit());
+
+  /* Clean up. */
+  swift_free("nr_preds", nr_preds);
+  swift_free("preds", preds);
+  swift_free("counts", counts);
+}
+
 /**
  * @brief Sort the tasks in topological order over all queues.
  *
@@ -1908,6 +2091,21 @@ void scheduler_ranktasks(struct scheduler *s) {
 #endif
 }
 
+/**
+ * @brief Free the cached gravity interaction lists of all the tasks.
+ *
+ * @param s The #scheduler.
+ */
+static void scheduler_free_grav_lists(struct scheduler *s) {
+
+  if (s->tasks == NULL) return;
+
+  for (int i = 0; i < s->nr_tasks; i++) {
+    gravity_interaction_list_free(s->tasks[i].grav_list);
+    s->tasks[i].grav_list = NULL;
+  }
+}
+
 /**
  * @brief (Re)allocate the task arrays.
  *
@@ -1916,6 +2114,9 @@ void scheduler_ranktasks(struct scheduler *s) {
  */
 void scheduler_reset(struct scheduler *s, int size) {
 
+  /* Release the memory attached to the old tasks */
+  scheduler_free_grav_lists(s);
+
   /* Do we need to re-allocate? */
   if (size > s->size) {
     /* Free existing task lists if necessary. */
@@ -1950,396 +2151,573 @@ void scheduler_reset(struct scheduler *s, int size) {
 }
 
 /**
- * @brief Compute the task weights
+ * @brief Compute the analytic estimate of the cost of a task.
  *
- * @param s The #scheduler.
- * @param verbose Are we talkative?
+ * @param t The #task.
+ * @param nodeID The rank we are on.
  */
-void scheduler_reweight(struct scheduler *s, int verbose) {
-  const int nr_tasks = s->nr_tasks;
-  int *tid = s->tasks_ind;
-  struct task *tasks = s->tasks;
-  const int nodeID = s->nodeID;
+static float scheduler_analytic_cost(const struct task *t, const int nodeID) {
   const float wscale = 0.001f;
-  const ticks tic = getticks();
-
-  /* Run through the tasks backwards and set their weights. */
-  for (int k = nr_tasks - 1; k >= 0; k--) {
-    struct task *t = &tasks[tid[k]];
-    float cost = 0.f;
-    t->weight = 0.f;
-
-    for (int j = 0; j < t->nr_unlock_tasks; j++)
-      t->weight += t->unlock_tasks[j]->weight;
+  float cost = 0.f;
+
+  const float count_i = (t->ci != NULL) ? t->ci->hydro.count : 0.f;
+  const float count_j = (t->cj != NULL) ? t->cj->hydro.count : 0.f;
+  const float gcount_i = (t->ci != NULL) ? t->ci->grav.count : 0.f;
+  const float gcount_j = (t->cj != NULL) ? t->cj->grav.count : 0.f;
+  const float scount_i = (t->ci != NULL) ? t->ci->stars.count : 0.f;
+  const float scount_j = (t->cj != NULL) ? t->cj->stars.count : 0.f;
+  const float sink_count_i = (t->ci != NULL) ? t->ci->sinks.count : 0.f;
+  const float sink_count_j = (t->cj != NULL) ? t->cj->sinks.count : 0.f;
+  const float bcount_i = (t->ci != NULL) ? t->ci->black_holes.count : 0.f;
+  const float bcount_j = (t->cj != NULL) ? t->cj->black_holes.count : 0.f;
+
+  switch (t->type) {
+    case task_type_sort:
+    case task_type_rt_sort:
+      cost = wscale * intrinsics_popcount(t->flags) * count_i *
+             (sizeof(int) * 8 - (count_i ? intrinsics_clz(count_i) : 0));
+      break;
 
-    const float count_i = (t->ci != NULL) ? t->ci->hydro.count : 0.f;
-    const float count_j = (t->cj != NULL) ? t->cj->hydro.count : 0.f;
-    const float gcount_i = (t->ci != NULL) ? t->ci->grav.count : 0.f;
-    const float gcount_j = (t->cj != NULL) ? t->cj->grav.count : 0.f;
-    const float scount_i = (t->ci != NULL) ? t->ci->stars.count : 0.f;
-    const float scount_j = (t->cj != NULL) ? t->cj->stars.count : 0.f;
-    const float sink_count_i = (t->ci != NULL) ? t->ci->sinks.count : 0.f;
-    const float sink_count_j = (t->cj != NULL) ? t->cj->sinks.count : 0.f;
-    const float bcount_i = (t->ci != NULL) ? t->ci->black_holes.count : 0.f;
-    const float bcount_j = (t->cj != NULL) ? t->cj->black_holes.count : 0.f;
+    case task_type_stars_sort:
+      cost = wscale * intrinsics_popcount(t->flags) * scount_i *
+             (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
+      break;
 
-    switch (t->type) {
-      case task_type_sort:
-      case task_type_rt_sort:
-        cost = wscale * intrinsics_popcount(t->flags) * count_i *
-               (sizeof(int) * 8 - (count_i ? intrinsics_clz(count_i) : 0));
-        break;
+    case task_type_stars_resort:
+      cost = wscale * intrinsics_popcount(t->flags) * scount_i *
+             (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
+      break;
 
-      case task_type_stars_sort:
-        cost = wscale * intrinsics_popcount(t->flags) * scount_i *
-               (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
-        break;
+    case task_type_self:
+      if (t->subtype == task_subtype_grav) {
+        cost = 1.f * (wscale * gcount_i) * gcount_i;
+      } else if (t->subtype == task_subtype_external_grav)
+        cost = 1.f * wscale * gcount_i;
+      else if (t->subtype == task_subtype_stars_density ||
+               t->subtype == task_subtype_stars_prep1 ||
+               t->subtype == task_subtype_stars_prep2 ||
+               t->subtype == task_subtype_stars_feedback)
+        cost = 1.f * wscale * scount_i * count_i;
+      else if (t->subtype == task_subtype_sink_swallow ||
+               t->subtype == task_subtype_sink_do_gas_swallow)
+        cost = 1.f * wscale * count_i * sink_count_i;
+      else if (t->subtype == task_subtype_sink_do_sink_swallow)
+        cost = 1.f * wscale * sink_count_i * sink_count_i;
+      else if (t->subtype == task_subtype_bh_density ||
+               t->subtype == task_subtype_bh_swallow ||
+               t->subtype == task_subtype_bh_feedback)
+        cost = 1.f * wscale * bcount_i * count_i;
+      else if (t->subtype == task_subtype_do_gas_swallow)
+        cost = 1.f * wscale * count_i;
+      else if (t->subtype == task_subtype_do_bh_swallow)
+        cost = 1.f * wscale * bcount_i;
+      else if (t->subtype == task_subtype_density ||
+               t->subtype == task_subtype_gradient ||
+               t->subtype == task_subtype_force ||
+               t->subtype == task_subtype_limiter)
+        cost = 1.f * (wscale * count_i) * count_i;
+      else if (t->subtype == task_subtype_rt_gradient)
+        cost = 1.f * wscale * count_i * count_i;
+      else if (t->subtype == task_subtype_rt_transport)
+        cost = 1.f * wscale * count_i * count_i;
+      else
+        error("Untreated sub-type for selfs: %s",
+              subtaskID_names[t->subtype]);
+      break;
 
-      case task_type_stars_resort:
-        cost = wscale * intrinsics_popcount(t->flags) * scount_i *
-               (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
-        break;
+    case task_type_pair:
+      if (t->subtype == task_subtype_grav) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
+          cost = 3.f * (wscale * gcount_i) * gcount_j;
+        else
+          cost = 2.f * (wscale * gcount_i) * gcount_j;
 
-      case task_type_self:
-        if (t->subtype == task_subtype_grav) {
-          cost = 1.f * (wscale * gcount_i) * gcount_i;
-        } else if (t->subtype == task_subtype_external_grav)
-          cost = 1.f * wscale * gcount_i;
-        else if (t->subtype == task_subtype_stars_density ||
+      } else if (t->subtype == task_subtype_stars_density ||
                  t->subtype == task_subtype_stars_prep1 ||
                  t->subtype == task_subtype_stars_prep2 ||
-                 t->subtype == task_subtype_stars_feedback)
-          cost = 1.f * wscale * scount_i * count_i;
-        else if (t->subtype == task_subtype_sink_swallow ||
-                 t->subtype == task_subtype_sink_do_gas_swallow)
-          cost = 1.f * wscale * count_i * sink_count_i;
-        else if (t->subtype == task_subtype_sink_do_sink_swallow)
-          cost = 1.f * wscale * sink_count_i * sink_count_i;
-        else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_stars_feedback) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * scount_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * scount_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_sink_swallow ||
+                 t->subtype == task_subtype_sink_do_gas_swallow) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * sink_count_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * sink_count_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale *
+                 (sink_count_i * count_j + sink_count_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * sink_count_i * sink_count_j *
+                 sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * sink_count_i * sink_count_j *
+                 sid_scale[t->flags];
+        else
+          cost = 2.f * wscale *
+                 (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_bh_density ||
                  t->subtype == task_subtype_bh_swallow ||
-                 t->subtype == task_subtype_bh_feedback)
-          cost = 1.f * wscale * bcount_i * count_i;
-        else if (t->subtype == task_subtype_do_gas_swallow)
-          cost = 1.f * wscale * count_i;
-        else if (t->subtype == task_subtype_do_bh_swallow)
-          cost = 1.f * wscale * bcount_i;
-        else if (t->subtype == task_subtype_density ||
+                 t->subtype == task_subtype_bh_feedback) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * bcount_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * bcount_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_do_gas_swallow) {
+        cost = 1.f * wscale * (count_i + count_j);
+
+      } else if (t->subtype == task_subtype_do_bh_swallow) {
+        cost = 1.f * wscale * (bcount_i + bcount_j);
+
+      } else if (t->subtype == task_subtype_density ||
                  t->subtype == task_subtype_gradient ||
                  t->subtype == task_subtype_force ||
-                 t->subtype == task_subtype_limiter)
-          cost = 1.f * (wscale * count_i) * count_i;
-        else if (t->subtype == task_subtype_rt_gradient)
-          cost = 1.f * wscale * count_i * count_i;
-        else if (t->subtype == task_subtype_rt_transport)
-          cost = 1.f * wscale * count_i * count_i;
+                 t->subtype == task_subtype_limiter) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
+          cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
         else
-          error("Untreated sub-type for selfs: %s",
-                subtaskID_names[t->subtype]);
-        break;
-
-      case task_type_pair:
-        if (t->subtype == task_subtype_grav) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
-            cost = 3.f * (wscale * gcount_i) * gcount_j;
-          else
-            cost = 2.f * (wscale * gcount_i) * gcount_j;
-
-        } else if (t->subtype == task_subtype_stars_density ||
-                   t->subtype == task_subtype_stars_prep1 ||
-                   t->subtype == task_subtype_stars_prep2 ||
-                   t->subtype == task_subtype_stars_feedback) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * scount_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * scount_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_sink_swallow ||
-                   t->subtype == task_subtype_sink_do_gas_swallow) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * sink_count_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * sink_count_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale *
-                   (sink_count_i * count_j + sink_count_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * sink_count_i * sink_count_j *
-                   sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * sink_count_i * sink_count_j *
-                   sid_scale[t->flags];
-          else
-            cost = 2.f * wscale *
-                   (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_swallow ||
-                   t->subtype == task_subtype_bh_feedback) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * bcount_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * bcount_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_do_gas_swallow) {
-          cost = 1.f * wscale * (count_i + count_j);
-
-        } else if (t->subtype == task_subtype_do_bh_swallow) {
-          cost = 1.f * wscale * (bcount_i + bcount_j);
-
-        } else if (t->subtype == task_subtype_density ||
-                   t->subtype == task_subtype_gradient ||
-                   t->subtype == task_subtype_force ||
-                   t->subtype == task_subtype_limiter) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
-            cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_rt_gradient) {
-          cost = 1.f * wscale * count_i * count_j;
-        } else if (t->subtype == task_subtype_rt_transport) {
-          cost = 1.f * wscale * count_i * count_j;
-        } else {
-          error("Untreated sub-type for pairs: %s",
-                subtaskID_names[t->subtype]);
-        }
-        break;
+          cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_rt_gradient) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else if (t->subtype == task_subtype_rt_transport) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else {
+        error("Untreated sub-type for pairs: %s",
+              subtaskID_names[t->subtype]);
+      }
+      break;
 
-      case task_type_sub_pair:
+    case task_type_sub_pair:
 #ifdef SWIFT_DEBUG_CHECKS
-        if (t->flags < 0) error("Negative flag value!");
+      if (t->flags < 0) error("Negative flag value!");
 #endif
-        if (t->subtype == task_subtype_stars_density ||
-            t->subtype == task_subtype_stars_prep1 ||
-            t->subtype == task_subtype_stars_prep2 ||
-            t->subtype == task_subtype_stars_feedback) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * scount_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * scount_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
-                   sid_scale[t->flags];
-          }
+      if (t->subtype == task_subtype_stars_density ||
+          t->subtype == task_subtype_stars_prep1 ||
+          t->subtype == task_subtype_stars_prep2 ||
+          t->subtype == task_subtype_stars_feedback) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * scount_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * scount_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
+                 sid_scale[t->flags];
+        }
 
-        } else if (t->subtype == task_subtype_sink_swallow ||
-                   t->subtype == task_subtype_sink_do_gas_swallow) {
-          if (t->ci->nodeID != nodeID) {
-            cost =
-                3.f * (wscale * count_i) * sink_count_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost =
-                3.f * (wscale * sink_count_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale *
-                   (sink_count_i * count_j + sink_count_j * count_i) *
-                   sid_scale[t->flags];
-          }
+      } else if (t->subtype == task_subtype_sink_swallow ||
+                 t->subtype == task_subtype_sink_do_gas_swallow) {
+        if (t->ci->nodeID != nodeID) {
+          cost =
+              3.f * (wscale * count_i) * sink_count_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost =
+              3.f * (wscale * sink_count_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale *
+                 (sink_count_i * count_j + sink_count_j * count_i) *
+                 sid_scale[t->flags];
+        }
 
-        } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * sink_count_i) * sink_count_j *
-                   sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * sink_count_i) * sink_count_j *
-                   sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale *
-                   (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
-                   sid_scale[t->flags];
-          }
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_swallow ||
-                   t->subtype == task_subtype_bh_feedback) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * bcount_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * bcount_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
-                   sid_scale[t->flags];
-          }
+      } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * sink_count_i) * sink_count_j *
+                 sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * sink_count_i) * sink_count_j *
+                 sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale *
+                 (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
+                 sid_scale[t->flags];
+        }
+      } else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_bh_swallow ||
+                 t->subtype == task_subtype_bh_feedback) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * bcount_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * bcount_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
+                 sid_scale[t->flags];
+        }
 
-        } else if (t->subtype == task_subtype_do_gas_swallow) {
-          cost = 1.f * wscale * (count_i + count_j);
+      } else if (t->subtype == task_subtype_do_gas_swallow) {
+        cost = 1.f * wscale * (count_i + count_j);
 
-        } else if (t->subtype == task_subtype_do_bh_swallow) {
-          cost = 1.f * wscale * (bcount_i + bcount_j);
+      } else if (t->subtype == task_subtype_do_bh_swallow) {
+        cost = 1.f * wscale * (bcount_i + bcount_j);
 
-        } else if (t->subtype == task_subtype_density ||
-                   t->subtype == task_subtype_gradient ||
-                   t->subtype == task_subtype_force ||
-                   t->subtype == task_subtype_limiter) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          }
-        } else if (t->subtype == task_subtype_rt_gradient) {
-          cost = 1.f * wscale * count_i * count_j;
-        } else if (t->subtype == task_subtype_rt_transport) {
-          cost = 1.f * wscale * count_i * count_j;
+      } else if (t->subtype == task_subtype_density ||
+                 t->subtype == task_subtype_gradient ||
+                 t->subtype == task_subtype_force ||
+                 t->subtype == task_subtype_limiter) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
         } else {
-          error("Untreated sub-type for sub-pairs: %s",
-                subtaskID_names[t->subtype]);
+          cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
         }
-        break;
+      } else if (t->subtype == task_subtype_rt_gradient) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else if (t->subtype == task_subtype_rt_transport) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else {
+        error("Untreated sub-type for sub-pairs: %s",
+              subtaskID_names[t->subtype]);
+      }
+      break;
 
-      case task_type_sub_self:
-        if (t->subtype == task_subtype_stars_density ||
-            t->subtype == task_subtype_stars_prep1 ||
-            t->subtype == task_subtype_stars_prep2 ||
-            t->subtype == task_subtype_stars_feedback) {
-          cost = 1.f * (wscale * scount_i) * count_i;
-        } else if (t->subtype == task_subtype_sink_swallow ||
-                   t->subtype == task_subtype_sink_do_gas_swallow) {
-          cost = 1.f * (wscale * sink_count_i) * count_i;
-        } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
-          cost = 1.f * (wscale * sink_count_i) * sink_count_i;
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_swallow ||
-                   t->subtype == task_subtype_bh_feedback) {
-          cost = 1.f * (wscale * bcount_i) * count_i;
-        } else if (t->subtype == task_subtype_do_gas_swallow) {
-          cost = 1.f * wscale * count_i;
-        } else if (t->subtype == task_subtype_do_bh_swallow) {
-          cost = 1.f * wscale * bcount_i;
-        } else if (t->subtype == task_subtype_density ||
-                   t->subtype == task_subtype_gradient ||
-                   t->subtype == task_subtype_force ||
-                   t->subtype == task_subtype_limiter) {
-          cost = 1.f * (wscale * count_i) * count_i;
-        } else if (t->subtype == task_subtype_rt_gradient) {
-          cost = 1.f * wscale * scount_i * count_i;
-        } else if (t->subtype == task_subtype_rt_transport) {
-          cost = 1.f * wscale * scount_i * count_i;
-        } else {
-          error("Untreated sub-type for sub-selfs: %s",
-                subtaskID_names[t->subtype]);
-        }
-        break;
-      case task_type_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
-        break;
-      case task_type_extra_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
-        break;
-      case task_type_stars_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * scount_i;
-        break;
-      case task_type_bh_density_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
-        break;
-      case task_type_bh_swallow_ghost2:
-        if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
-        break;
-      case task_type_drift_part:
-        cost = wscale * count_i;
-        break;
-      case task_type_drift_gpart:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_drift_spart:
-        cost = wscale * scount_i;
-        break;
-      case task_type_drift_sink:
-        cost = wscale * sink_count_i;
-        break;
-      case task_type_drift_bpart:
-        cost = wscale * bcount_i;
-        break;
-      case task_type_init_grav:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_down:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_long_range:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_mm:
-        cost = wscale * (gcount_i + gcount_j);
-        break;
-      case task_type_end_hydro_force:
-        cost = wscale * count_i;
-        break;
-      case task_type_end_grav_force:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_cooling:
-        cost = wscale * count_i;
-        break;
-      case task_type_star_formation:
-        cost = wscale * (count_i + scount_i);
-        break;
-      case task_type_star_formation_sink:
-        cost = wscale * (sink_count_i + scount_i);
-        break;
-      case task_type_sink_formation:
-        cost = wscale * (count_i + sink_count_i);
-        break;
-      case task_type_rt_ghost1:
-        cost = wscale * count_i;
-        break;
-      case task_type_rt_ghost2:
-        cost = wscale * count_i;
-        break;
-      case task_type_rt_tchem:
-        cost = wscale * count_i;
-        break;
-      case task_type_rt_advance_cell_time:
-      case task_type_rt_collect_times:
-        cost = wscale;
-        break;
-      case task_type_csds:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_kick1:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_kick2:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_timestep:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_timestep_limiter:
-        cost = wscale * count_i;
-        break;
-      case task_type_timestep_sync:
-        cost = wscale * count_i;
-        break;
-      case task_type_send:
-        if (count_i < 1e5)
-          cost = 10.f * (wscale * count_i) * count_i;
-        else
-          cost = 2e9;
-        break;
-      case task_type_recv:
-        if (count_i < 1e5)
-          cost = 5.f * (wscale * count_i) * count_i;
-        else
-          cost = 1e9;
-        break;
-      default:
-        cost = 0;
-        break;
+    case task_type_sub_self:
+      if (t->subtype == task_subtype_stars_density ||
+          t->subtype == task_subtype_stars_prep1 ||
+          t->subtype == task_subtype_stars_prep2 ||
+          t->subtype == task_subtype_stars_feedback) {
+        cost = 1.f * (wscale * scount_i) * count_i;
+      } else if (t->subtype == task_subtype_sink_swallow ||
+                 t->subtype == task_subtype_sink_do_gas_swallow) {
+        cost = 1.f * (wscale * sink_count_i) * count_i;
+      } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
+        cost = 1.f * (wscale * sink_count_i) * sink_count_i;
+      } else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_bh_swallow ||
+                 t->subtype == task_subtype_bh_feedback) {
+        cost = 1.f * (wscale * bcount_i) * count_i;
+      } else if (t->subtype == task_subtype_do_gas_swallow) {
+        cost = 1.f * wscale * count_i;
+      } else if (t->subtype == task_subtype_do_bh_swallow) {
+        cost = 1.f * wscale * bcount_i;
+      } else if (t->subtype == task_subtype_density ||
+                 t->subtype == task_subtype_gradient ||
+                 t->subtype == task_subtype_force ||
+                 t->subtype == task_subtype_limiter) {
+        cost = 1.f * (wscale * count_i) * count_i;
+      } else if (t->subtype == task_subtype_rt_gradient) {
+        cost = 1.f * wscale * scount_i * count_i;
+      } else if (t->subtype == task_subtype_rt_transport) {
+        cost = 1.f * wscale * scount_i * count_i;
+      } else {
+        error("Untreated sub-type for sub-selfs: %s",
+              subtaskID_names[t->subtype]);
+      }
+      break;
+    case task_type_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
+      break;
+    case task_type_extra_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
+      break;
+    case task_type_stars_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * scount_i;
+      break;
+    case task_type_bh_density_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
+      break;
+    case task_type_bh_swallow_ghost2:
+      if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
+      break;
+    case task_type_drift_part:
+      cost = wscale * count_i;
+      break;
+    case task_type_drift_gpart:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_drift_spart:
+      cost = wscale * scount_i;
+      break;
+    case task_type_drift_sink:
+      cost = wscale * sink_count_i;
+      break;
+    case task_type_drift_bpart:
+      cost = wscale * bcount_i;
+      break;
+    case task_type_init_grav:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_down:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_long_range:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_mm:
+      cost = wscale * (gcount_i + gcount_j);
+      break;
+    case task_type_end_hydro_force:
+      cost = wscale * count_i;
+      break;
+    case task_type_end_grav_force:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_cooling:
+      cost = wscale * count_i;
+      break;
+    case task_type_star_formation:
+      cost = wscale * (count_i + scount_i);
+      break;
+    case task_type_star_formation_sink:
+      cost = wscale * (sink_count_i + scount_i);
+      break;
+    case task_type_sink_formation:
+      cost = wscale * (count_i + sink_count_i);
+      break;
+    case task_type_rt_ghost1:
+      cost = wscale * count_i;
+      break;
+    case task_type_rt_ghost2:
+      cost = wscale * count_i;
+      break;
+    case task_type_rt_tchem:
+      cost = wscale * count_i;
+      break;
+    case task_type_rt_advance_cell_time:
+    case task_type_rt_collect_times:
+      cost = wscale;
+      break;
+    case task_type_csds:
+      cost =
+          wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_kick1:
+      cost =
+          wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_kick2:
+      cost =
+          wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_timestep:
+      cost =
+          wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_timestep_limiter:
+      cost = wscale * count_i;
+      break;
+    case task_type_timestep_sync:
+      cost = wscale * count_i;
+      break;
+    case task_type_send:
+      if (count_i < 1e5)
+        cost = 10.f * (wscale * count_i) * count_i;
+      else
+        cost = 2e9;
+      break;
+    case task_type_recv:
+      if (count_i < 1e5)
+        cost = 5.f * (wscale * count_i) * count_i;
+      else
+        cost = 1e9;
+      break;
+    default:
+      cost = 0;
+      break;
+  }
+
+  return cost;
+}
+
+/**
+ * @brief Get the bin of the measured-cost model a task falls in.
+ *
+ * The bins are indexed by task type, sub-type and a logarithmic bin of the
+ * analytic cost estimate.
+ *
+ * @param t The #task.
+ * @param cost The analytic cost estimate of the task.
+ */
+__attribute__((always_inline)) INLINE static int scheduler_cost_model_bin(
+    const struct task *t, const float cost) {
+
+  int bin = 0;
+  if (cost >= 1.f) {
+    int exponent;
+    frexpf(cost, &exponent);
+    bin = min(1 + exponent / 2, scheduler_cost_model_nr_bins - 1);
+  }
+
+  return (t->type * task_subtype_count + t->subtype) *
+             scheduler_cost_model_nr_bins +
+         bin;
+}
+
+/**
+ * @brief Predict the cost of a task from the measured-cost model.
+ *
+ * Uses the linear fit of the measured run times against the analytic
+ * estimate in the task's bin, if it has seen enough tasks, otherwise the
+ * analytic estimate scaled by the mean ratio of measured to estimated
+ * costs. The result is in ticks.
+ *
+ * @param s The #scheduler.
+ * @param t The #task.
+ * @param cost The analytic cost estimate of the task.
+ */
+static float scheduler_measured_cost(const struct scheduler *s,
+                                     const struct task *t, const float cost) {
+
+  /* The communications have a large cost only to get them out early. Their
+   * measured times only cover the posting of the MPI calls, so give them a
+   * fixed multiple of the most expensive measured task instead. */
+  if (t->type == task_type_send)
+    return scheduler_cost_model_send_boost * s->cost_model_max;
+  if (t->type == task_type_recv)
+    return scheduler_cost_model_recv_boost * s->cost_model_max;
+
+  const struct scheduler_cost_bin *b =
+      &s->cost_model[scheduler_cost_model_bin(t, cost)];
+
+  if (b->n >= scheduler_cost_model_min_samples) {
+    const double det = b->n * b->sum_xx - b->sum_x * b->sum_x;
+    if (det > 1e-6 * b->n * b->sum_xx) {
+      const double slope = (b->n * b->sum_xy - b->sum_x * b->sum_y) / det;
+      const double intercept = (b->sum_y - slope * b->sum_x) / b->n;
+      if (slope >= 0.) return max(intercept + slope * cost, 0.);
     }
-    t->weight += cost;
+
+    /* All the tasks in this bin have the same estimate. */
+    return b->sum_y / b->n;
+  }
+
+  return cost * s->cost_model_ratio;
+}
+
+/**
+ * @brief #threadpool_map function which adds the run time of the tasks that
+ * ran in the last launch to the measured-cost model.
+ */
+void scheduler_update_cost_model_mapper(void *map_data, int num_elements,
+                                        void *extra_data) {
+
+  struct scheduler *s = (struct scheduler *)extra_data;
+  struct task *tasks = (struct task *)map_data;
+  const ticks launch_tic = s->cost_model_launch_tic;
+
+  /* Tasks of a given kind tend to be next to each other, so accumulate
+   * locally until the bin changes. */
+  int current = -1;
+  double n = 0., sum_x = 0., sum_y = 0., sum_xx = 0., sum_xy = 0.;
+
+  for (int i = 0; i <= num_elements; i++) {
+
+    int bin = -1;
+    double x = 0., y = 0.;
+    if (i < num_elements) {
+      const struct task *t = &tasks[i];
+      if (t->implicit || t->tic < launch_tic || t->toc <= t->tic) continue;
+
+      /* The communications are not modelled, see scheduler_measured_cost(). */
+      if (t->type == task_type_send || t->type == task_type_recv) continue;
+      x = scheduler_analytic_cost(t, s->nodeID);
+      y = (double)(t->toc - t->tic);
+      bin = scheduler_cost_model_bin(t, x);
+    }
+
+    /* Flush the local sums? */
+    if (bin != current && current >= 0) {
+      struct scheduler_cost_bin *b = &s->cost_model[current];
+      atomic_add_d(&b->n, n);
+      atomic_add_d(&b->sum_x, sum_x);
+      atomic_add_d(&b->sum_y, sum_y);
+      atomic_add_d(&b->sum_xx, sum_xx);
+      atomic_add_d(&b->sum_xy, sum_xy);
+      n = sum_x = sum_y = sum_xx = sum_xy = 0.;
+    }
+
+    current = bin;
+    n += 1.;
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+  }
+}
+
+/**
+ * @brief Add the run time of the tasks of the last launch to the
+ * measured-cost model.
+ *
+ * Each bin only keeps the equivalent of the last
+ * #scheduler_cost_model_window tasks, so that the model follows the changes
+ * in the run.
+ *
+ * @param s The #scheduler.
+ * @param launch_tic The start of the launch.
+ */
+void scheduler_update_cost_model(struct scheduler *s, const ticks launch_tic) {
+
+  if (s->cost_model == NULL) return;
+
+  s->cost_model_launch_tic = launch_tic;
+  threadpool_map(s->threadpool, scheduler_update_cost_model_mapper, s->tasks,
+                 s->nr_tasks, sizeof(struct task), threadpool_auto_chunk_size,
+                 s);
+
+  double sum_x = 0., sum_y = 0., max_cost = 0.;
+  const int nr_bins =
+      task_type_count * task_subtype_count * scheduler_cost_model_nr_bins;
+  for (int k = 0; k < nr_bins; k++) {
+    struct scheduler_cost_bin *b = &s->cost_model[k];
+    if (b->n > scheduler_cost_model_window) {
+      const double scale = scheduler_cost_model_window / b->n;
+      b->n *= scale;
+      b->sum_x *= scale;
+      b->sum_y *= scale;
+      b->sum_xx *= scale;
+      b->sum_xy *= scale;
+    }
+    sum_x += b->sum_x;
+    sum_y += b->sum_y;
+    if (b->n > 0.) max_cost = max(max_cost, b->sum_y / b->n);
+  }
+
+  /* Conversion of the analytic estimates for the tasks without a model. */
+  if (sum_x > 0. && sum_y > 0.) s->cost_model_ratio = sum_y / sum_x;
+
+  /* Reference for the weight of the communications. */
+  if (max_cost > 0.) s->cost_model_max = max_cost;
+}
+
+/**
+ * @brief Compute the task weights
+ *
+ * @param s The #scheduler.
+ * @param verbose Are we talkative?
+ */
+void scheduler_reweight(struct scheduler *s, int verbose) {
+  const int nr_tasks = s->nr_tasks;
+  int *tid = s->tasks_ind;
+  struct task *tasks = s->tasks;
+  const int nodeID = s->nodeID;
+  const ticks tic = getticks();
+
+  /* Run through the tasks backwards and set their weights. */
+  for (int k = nr_tasks - 1; k >= 0; k--) {
+    struct task *t = &tasks[tid[k]];
+    t->weight = 0.f;
+
+    for (int j = 0; j < t->nr_unlock_tasks; j++)
+      t->weight += t->unlock_tasks[j]->weight;
+
+    const float cost = scheduler_analytic_cost(t, nodeID);
+    if (s->cost_model != NULL)
+      t->weight += scheduler_measured_cost(s, t, cost);
+    else
+      t->weight += cost;
   }
 
   if (verbose)
@@ -2400,7 +2778,6 @@ void scheduler_enqueue_mapper(void *map_data, int num_elements,
       scheduler_enqueue(s, t);
     }
   }
-  pthread_cond_broadcast(&s->sleep_cond);
 }
 
 /**
@@ -2429,12 +2806,227 @@ void scheduler_start(struct scheduler *s) {
   /* Clear the list of active tasks. */
   s->active_count = 0;
 
-  /* To be safe, fire of one last sleep_cond in a safe way. */
-  pthread_mutex_lock(&s->sleep_mutex);
-  pthread_cond_broadcast(&s->sleep_cond);
-  pthread_mutex_unlock(&s->sleep_mutex);
+  /* To be safe, wake up everybody one last time. */
+  scheduler_wake_all(s);
 }
 
+/**
+ * @brief Wake up a runner to pick up a task that was put in a queue.
+ *
+ * We wake up one of the runners parked on that queue, or if there are
+ * none and stealing is allowed, one parked on the nearest queue in the
+ * stealing order. All the other runners are left alone.
+ *
+ * @param s The #scheduler.
+ * @param qid The ID of the #queue that received the task.
+ */
+void scheduler_wake(struct scheduler *s, int qid) {
+
+  if (s->nr_sleeping == 0) return;
+
+  if (queue_wake(&s->queues[qid], /*all=*/0)) return;
+
+  if (!(s->flags & scheduler_flag_steal)) return;
+
+  /* Nobody left to wake up there, try the next queues that can steal
+   * from this one. */
+  const int nr_queues = s->nr_queues;
+  const int *order = &s->steal_order[qid * (nr_queues - 1)];
+  for (int k = 0; k < nr_queues - 1; k++)
+    if (queue_wake(&s->queues[order[k]], /*all=*/0)) return;
+}
+
+/**
+ * @brief Wake up all the parked runners, e.g. when there is no work left.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_wake_all(struct scheduler *s) {
+
+  for (int k = 0; k < s->nr_queues; k++) queue_wake(&s->queues[k], /*all=*/1);
+}
+
+#ifdef WITH_MPI
+
+/* The state of the MPI progress thread. */
+struct scheduler_mpi_progress {
+
+  /* The thread itself. */
+  pthread_t thread;
+
+  /* Lock and condition protecting the hand-over of new requests. */
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+
+  /* Send and recv tasks posted but not yet picked up by the thread. */
+  struct task **incoming;
+  volatile int nr_incoming;
+  int size_incoming;
+
+  /* Should the thread exit? */
+  volatile int stop;
+};
+
+/**
+ * @brief Hand a send or recv #task over to the MPI progress thread once its
+ * request has been posted.
+ *
+ * @param s The #scheduler.
+ * @param t The #task.
+ */
+static void scheduler_mpi_progress_add(struct scheduler *s, struct task *t) {
+
+  struct scheduler_mpi_progress *p = s->mpi_progress;
+  pthread_mutex_lock(&p->lock);
+  if (p->nr_incoming == p->size_incoming) {
+    p->size_incoming *= 2;
+    if ((p->incoming = (struct task **)realloc(
+             p->incoming, sizeof(struct task *) * p->size_incoming)) == NULL)
+      error("Failed to grow the MPI progress incoming list.");
+  }
+  p->incoming[p->nr_incoming++] = t;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * @brief Body of the MPI progress thread.
+ *
+ * The thread owns the requests of all the send and recv tasks in flight and
+ * tests them in batches with MPI_Testsome(). Completed tasks are put in the
+ * runner queues straight away, where they no longer have to poll their
+ * request.
+ *
+ * @param data The #scheduler.
+ */
+static void *scheduler_mpi_progress_main(void *data) {
+
+  struct scheduler *s = (struct scheduler *)data;
+  struct scheduler_mpi_progress *p = s->mpi_progress;
+  trace_thread_init("mpi progress", 0);
+
+  int nr_active = 0, size_active = 0;
+  struct task **tasks = NULL;
+  MPI_Request *reqs = NULL;
+  int *indices = NULL;
+
+  while (1) {
+
+    /* Collect the new requests, sleeping if there is nothing to do. */
+    if (nr_active == 0 || p->nr_incoming > 0 || p->stop) {
+      pthread_mutex_lock(&p->lock);
+      while (!p->stop && nr_active == 0 && p->nr_incoming == 0)
+        pthread_cond_wait(&p->cond, &p->lock);
+      if (p->stop) {
+        pthread_mutex_unlock(&p->lock);
+        break;
+      }
+      if (nr_active + p->nr_incoming > size_active) {
+        size_active = 2 * (nr_active + p->nr_incoming);
+        if ((tasks = (struct task **)realloc(
+                 tasks, sizeof(struct task *) * size_active)) == NULL ||
+            (reqs = (MPI_Request *)realloc(
+                 reqs, sizeof(MPI_Request) * size_active)) == NULL ||
+            (indices = (int *)realloc(indices, sizeof(int) * size_active)) ==
+                NULL)
+          error("Failed to grow the MPI progress request list.");
+      }
+      for (int k = 0; k < p->nr_incoming; k++) {
+        tasks[nr_active] = p->incoming[k];
+        reqs[nr_active] = p->incoming[k]->req;
+        nr_active++;
+      }
+      p->nr_incoming = 0;
+      pthread_mutex_unlock(&p->lock);
+    }
+
+    /* Test all the requests in one go. */
+    int nr_done = 0;
+    const int err = MPI_Testsome(nr_active, reqs, &nr_done, indices,
+                                 MPI_STATUSES_IGNORE);
+    if (err != MPI_SUCCESS) mpi_error(err, "Failed to test the requests.");
+    if (nr_done == MPI_UNDEFINED || nr_done == 0) continue;
+
+    /* Release the completed tasks to the runners. */
+    const ticks tic = getticks();
+    for (int k = 0; k < nr_done; k++) {
+      struct task *t = tasks[indices[k]];
+      mpiuse_log_allocation(t->type, t->subtype, &t->req, 0, 0, 0, 0);
+      if (trace_active) trace_record_mpi(t, tic);
+      t->req = MPI_REQUEST_NULL;
+      tasks[indices[k]] = NULL;
+
+      const int qid = (t->type == task_type_send) ? 0 : 1 % s->nr_queues;
+      t->qid = qid;
+      queue_insert(&s->queues[qid], t);
+      scheduler_wake(s, qid);
+    }
+
+    /* Compact the lists. */
+    int count = 0;
+    for (int k = 0; k < nr_active; k++) {
+      if (tasks[k] == NULL) continue;
+      tasks[count] = tasks[k];
+      reqs[count] = reqs[k];
+      count++;
+    }
+    nr_active = count;
+  }
+
+  free(tasks);
+  free(reqs);
+  free(indices);
+  return NULL;
+}
+
+/**
+ * @brief Start the MPI progress thread.
+ *
+ * @param s The #scheduler.
+ */
+static void scheduler_mpi_progress_start(struct scheduler *s) {
+
+  struct scheduler_mpi_progress *p;
+  if ((p = (struct scheduler_mpi_progress *)calloc(
+           1, sizeof(struct scheduler_mpi_progress))) == NULL)
+    error("Failed to allocate the MPI progress thread.");
+  p->size_incoming = scheduler_mpi_progress_init_size;
+  if ((p->incoming = (struct task **)malloc(sizeof(struct task *) *
+                                            p->size_incoming)) == NULL)
+    error("Failed to allocate the MPI progress incoming list.");
+  if (pthread_mutex_init(&p->lock, NULL) != 0 ||
+      pthread_cond_init(&p->cond, NULL) != 0)
+    error("Failed to initialise the MPI progress lock.");
+  s->mpi_progress = p;
+
+  if (pthread_create(&p->thread, NULL, &scheduler_mpi_progress_main, s) != 0)
+    error("Failed to create the MPI progress thread.");
+}
+
+/**
+ * @brief Stop the MPI progress thread and release its resources.
+ *
+ * @param s The #scheduler.
+ */
+static void scheduler_mpi_progress_stop(struct scheduler *s) {
+
+  struct scheduler_mpi_progress *p = s->mpi_progress;
+  pthread_mutex_lock(&p->lock);
+  p->stop = 1;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->lock);
+  if (pthread_join(p->thread, NULL) != 0)
+    error("Failed to join the MPI progress thread.");
+
+  pthread_mutex_destroy(&p->lock);
+  pthread_cond_destroy(&p->cond);
+  free(p->incoming);
+  free(p);
+  s->mpi_progress = NULL;
+}
+
+#endif /* WITH_MPI */
+
 /**
  * @brief Put a task on one of the queues.
  *
@@ -2731,8 +3323,21 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
     /* Increase the waiting counter. */
     atomic_inc(&s->waiting);
 
+#ifdef WITH_MPI
+    /* Leave the communications to the progress thread until they are done. */
+    if (s->mpi_progress != NULL &&
+        (t->type == task_type_send || t->type == task_type_recv)) {
+      scheduler_mpi_progress_add(s, t);
+      return;
+    }
+#endif
+
     /* Insert the task into that queue. */
+    t->qid = qid;
     queue_insert(&s->queues[qid], t);
+
+    /* And get a runner to pick it up. */
+    scheduler_wake(s, qid);
   }
 }
 
@@ -2767,10 +3372,14 @@ struct task *scheduler_done(struct scheduler *s, struct task *t) {
   if (!t->implicit) {
     t->toc = getticks();
     t->total_ticks += t->toc - t->tic;
-    pthread_mutex_lock(&s->sleep_mutex);
-    atomic_dec(&s->waiting);
-    pthread_cond_broadcast(&s->sleep_cond);
-    pthread_mutex_unlock(&s->sleep_mutex);
+    if (atomic_dec(&s->waiting) == 1) {
+      scheduler_wake_all(s);
+    } else {
+      /* The cell locks we just released may have been blocking a task.
+       * The tasks using the same cells are sent to the same queue, so let
+       * one runner parked there have another look. */
+      scheduler_wake(s, t->qid);
+    }
   }
 
   /* Mark the task as skip. */
@@ -2808,10 +3417,7 @@ struct task *scheduler_unlock(struct scheduler *s, struct task *t) {
   if (!t->implicit) {
     t->toc = getticks();
     t->total_ticks += t->toc - t->tic;
-    pthread_mutex_lock(&s->sleep_mutex);
-    atomic_dec(&s->waiting);
-    pthread_cond_broadcast(&s->sleep_cond);
-    pthread_mutex_unlock(&s->sleep_mutex);
+    if (atomic_dec(&s->waiting) == 1) scheduler_wake_all(s);
   }
 
   /* Return the next best task. Note that we currently do not
@@ -2905,6 +3511,8 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
   struct task *res = NULL;
   const int nr_queues = s->nr_queues;
   unsigned int seed = qid;
+  enum scheduler_steal_types stolen = scheduler_steal_none;
+  int woken = 0;
 
   /* Check qid. */
   if (qid >= nr_queues || qid < 0) error("Bad queue ID.");
@@ -2922,41 +3530,73 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
         if (res != NULL) break;
       }
 
-      /* If unsuccessful, try stealing from the other queues. */
+      /* If unsuccessful, try stealing from the other queues, starting with
+       * the ones in the same cache or memory domain. */
       if (s->flags & scheduler_flag_steal) {
-        int count = 0, qids[nr_queues];
-        for (int k = 0; k < nr_queues; k++)
-          if (s->queues[k].count > 0 || s->queues[k].count_incoming > 0) {
-            qids[count++] = k;
-          }
-        for (int k = 0; k < scheduler_maxsteal && count > 0; k++) {
-          const int ind = rand_r(&seed) % count;
-          TIMER_TIC
-          res = queue_gettask(&s->queues[qids[ind]], prev, 0);
-          TIMER_TOC(timer_qsteal);
-          if (res != NULL) {
-            break;
-          } else {
-            qids[ind] = qids[--count];
+        const int *order = &s->steal_order[qid * (nr_queues - 1)];
+        const int nr_local = s->steal_nr_local[qid];
+        for (int pass = 0; pass < 2 && res == NULL; pass++) {
+          const int first = (pass == 0) ? 0 : nr_local;
+          const int last = (pass == 0) ? nr_local : nr_queues - 1;
+          int count = 0, qids[nr_queues];
+          for (int k = first; k < last; k++)
+            if (queue_can_steal(&s->queues[order[k]])) {
+              qids[count++] = order[k];
+            }
+          for (int k = 0; k < scheduler_maxsteal && count > 0; k++) {
+            const int ind = rand_r(&seed) % count;
+            TIMER_TIC
+            res = queue_steal(&s->queues[qids[ind]], prev);
+            TIMER_TOC(timer_qsteal);
+            if (res != NULL) {
+              stolen = (pass == 0) ? scheduler_steal_local
+                                   : scheduler_steal_remote;
+              atomic_inc(&s->queues[qids[ind]]
+                              .counters[(pass == 0)
+                                            ? queue_counter_steal_local
+                                            : queue_counter_steal_remote]);
+              break;
+            } else {
+              qids[ind] = qids[--count];
+            }
           }
         }
         if (res != NULL) break;
       }
     }
 
-/* If we failed, take a short nap. */
+/* If we failed, take a short nap. The runners of the queues holding the
+ * communications keep polling them, unless the progress thread does. */
 #ifdef WITH_MPI
-    if (res == NULL && qid > 1)
+    if (res == NULL && (qid > 1 || s->mpi_progress != NULL))
 #else
     if (res == NULL)
 #endif
     {
-      pthread_mutex_lock(&s->sleep_mutex);
-      res = queue_gettask(&s->queues[qid], prev, 1);
-      if (res == NULL && s->waiting > 0) {
-        pthread_cond_wait(&s->sleep_cond, &s->sleep_mutex);
+      struct queue *q = &s->queues[qid];
+
+      /* Park on our queue, unless something arrived in the meantime. */
+      atomic_inc(&s->nr_sleeping);
+      const int seq = queue_sleep_prepare(q);
+      res = queue_gettask(q, prev, 1);
+
+      /* A task put in a queue we could steal from after our scan above
+       * would not wake us up, as we were not registered yet. */
+      int can_steal = 0;
+      if (res == NULL && (s->flags & scheduler_flag_steal)) {
+        const int *order = &s->steal_order[qid * (nr_queues - 1)];
+        for (int k = 0; k < nr_queues - 1 && !can_steal; k++)
+          can_steal = queue_can_steal(&s->queues[order[k]]);
+      }
+
+      if (res == NULL && !can_steal && s->waiting > 0) {
+        if (woken) atomic_inc(&q->counters[queue_counter_wakeup_spurious]);
+        atomic_inc(&q->counters[queue_counter_sleep]);
+        woken = queue_sleep(q, seq);
+      } else {
+        queue_sleep_cancel(q);
       }
-      pthread_mutex_unlock(&s->sleep_mutex);
+      atomic_dec(&s->nr_sleeping);
     }
 
     scheduler_check_deadlock(s);
@@ -2968,6 +3608,9 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
     res->tic = getticks();
 #ifdef SWIFT_DEBUG_TASKS
     res->rid = qid;
+    res->stolen = stolen;
+#else
+    (void)stolen;
 #endif
   }
 
@@ -2998,12 +3641,23 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
     error("Failed to allocate queues.");
 
   /* Initialize each queue. */
-  for (int k = 0; k < nr_queues; k++) queue_init(&s->queues[k], NULL);
+  for (int k = 0; k < nr_queues; k++)
+    queue_init(&s->queues[k], NULL, s->queue_type);
+
+  /* By default, steal from all the other queues alike. */
+  if ((s->steal_order = (int *)malloc(sizeof(int) * nr_queues *
+                                      max(nr_queues - 1, 1))) == NULL ||
+      (s->steal_nr_local = (int *)malloc(sizeof(int) * nr_queues)) == NULL)
+    error("Failed to allocate the steal order.");
+  for (int k = 0; k < nr_queues; k++) {
+    int count = 0;
+    for (int j = 0; j < nr_queues; j++)
+      if (j != k) s->steal_order[k * (nr_queues - 1) + count++] = j;
+    s->steal_nr_local[k] = count;
+  }
 
-  /* Init the sleep mutex and cond. */
-  if (pthread_cond_init(&s->sleep_cond, NULL) != 0 ||
-      pthread_mutex_init(&s->sleep_mutex, NULL) != 0)
-    error("Failed to initialize sleep barrier.");
+  /* Nobody is sleeping yet. */
+  s->nr_sleeping = 0;
 
   /* Init the unlocks. */
   if ((s->unlocks = (struct task **)swift_malloc(
@@ -3015,6 +3669,18 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
   s->nr_unlocks = 0;
   s->size_unlocks = scheduler_init_nr_unlocks;
 
+  /* Allocate the measured-cost model, if needed. */
+  s->cost_model = NULL;
+  s->cost_model_ratio = 1.;
+  s->cost_model_max = 1.;
+  if (s->use_measured_costs) {
+    const size_t nr_bins =
+        task_type_count * task_subtype_count * scheduler_cost_model_nr_bins;
+    if ((s->cost_model = (struct scheduler_cost_bin *)calloc(
+             nr_bins, sizeof(struct scheduler_cost_bin))) == NULL)
+      error("Failed to allocate the measured-cost model.");
+  }
+
   /* Set the scheduler variables. */
   s->nr_queues = nr_queues;
   s->flags = flags;
@@ -3032,6 +3698,107 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
   s->e = space->e;
   s->last_successful_task_fetch = 0LL;
 #endif
+
+  /* Start the MPI progress thread, if needed. */
+  s->mpi_progress = NULL;
+#ifdef WITH_MPI
+  if (s->use_mpi_progress) {
+    scheduler_mpi_progress_start(s);
+    if (nodeID == 0) message("Using a dedicated MPI progress thread.");
+  }
+#endif
+}
+
+/**
+ * @brief Get the cache or memory domain of a CPU.
+ *
+ * This is the ID of the L3 cache of the CPU, as given by sysfs, or its NUMA
+ * node if that is not available.
+ *
+ * @param cpuid The ID of the CPU.
+ *
+ * @return The domain, or -1 if it could not be determined.
+ */
+static int scheduler_get_cpu_domain(const int cpuid) {
+
+  if (cpuid < 0) return -1;
+
+  /* Look for the L3 cache of this CPU. */
+  for (int index = 0;; index++) {
+    char path[128];
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpuid, index);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) break;
+    int level = 0;
+    const int nr_read = fscanf(file, "%d", &level);
+    fclose(file);
+    if (nr_read != 1 || level != 3) continue;
+
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cache/index%d/id", cpuid, index);
+    if ((file = fopen(path, "r")) == NULL) break;
+    int id = -1;
+    if (fscanf(file, "%d", &id) != 1) id = -1;
+    fclose(file);
+    if (id >= 0) return id;
+    break;
+  }
+
+#if defined(HAVE_LIBNUMA) && defined(_GNU_SOURCE)
+  if (numa_available() >= 0) return numa_node_of_cpu(cpuid);
+#endif
+
+  return -1;
+}
+
+/**
+ * @brief Set the order in which the queues steal from each other.
+ *
+ * Queues whose runners share an L3 cache (or a NUMA node, if the caches
+ * cannot be identified) with the thief are tried first, the others only if
+ * none of these had any work. Queues whose CPU is unknown steal from all the
+ * others alike.
+ *
+ * @param s The #scheduler.
+ * @param queue_cpuid The CPU of the runners of each queue, -1 if unknown.
+ * @param verbose Are we talkative?
+ */
+void scheduler_init_steal_order(struct scheduler *s, const int *queue_cpuid,
+                                int verbose) {
+
+  const int nr_queues = s->nr_queues;
+
+  int *domain = (int *)malloc(sizeof(int) * nr_queues);
+  if (domain == NULL) error("Failed to allocate queue domains.");
+  for (int k = 0; k < nr_queues; k++)
+    domain[k] = scheduler_get_cpu_domain(queue_cpuid[k]);
+
+  int nr_local_min = nr_queues, nr_local_max = 0;
+  for (int k = 0; k < nr_queues; k++) {
+    int *order = &s->steal_order[k * (nr_queues - 1)];
+    int count = 0;
+
+    /* Local queues first... */
+    for (int j = 0; j < nr_queues; j++)
+      if (j != k && (domain[k] < 0 || domain[j] == domain[k]))
+        order[count++] = j;
+    s->steal_nr_local[k] = count;
+
+    /* ...and the remote ones after. */
+    for (int j = 0; j < nr_queues; j++)
+      if (j != k && !(domain[k] < 0 || domain[j] == domain[k]))
+        order[count++] = j;
+
+    nr_local_min = min(nr_local_min, s->steal_nr_local[k]);
+    nr_local_max = max(nr_local_max, s->steal_nr_local[k]);
+  }
+
+  if (verbose)
+    message("Queues steal first from %d to %d queues in the same domain.",
+            nr_local_min, nr_local_max);
+
+  free(domain);
 }
 
 /**
@@ -3063,17 +3830,24 @@ void scheduler_print_tasks(const struct scheduler *s, const char *fileName) {
  * @brief Frees up the memory allocated for this #scheduler
  */
 void scheduler_clean(struct scheduler *s) {
+#ifdef WITH_MPI
+  if (s->mpi_progress != NULL) scheduler_mpi_progress_stop(s);
+#endif
   scheduler_free_tasks(s);
   swift_free("unlocks", s->unlocks);
   swift_free("unlock_ind", s->unlock_ind);
   for (int i = 0; i < s->nr_queues; ++i) queue_clean(&s->queues[i]);
   swift_free("queues", s->queues);
+  free(s->steal_order);
+  free(s->steal_nr_local);
+  free(s->cost_model);
 }
 
 /**
  * @brief Free the task arrays allocated by this #scheduler.
  */
 void scheduler_free_tasks(struct scheduler *s) {
+  scheduler_free_grav_lists(s);
   if (s->tasks != NULL) {
     swift_free("tasks", s->tasks);
     s->tasks = NULL;
@@ -3257,3 +4031,28 @@ void scheduler_report_task_times(const struct scheduler *s,
   message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
           clocks_getunit());
 }
+
+/**
+ * @brief Report the contention counters of the queues and reset them.
+ *
+ * @param s The #scheduler.
+ * @param call What kind of launch the counters were collected for.
+ */
+void scheduler_report_queue_counters(struct scheduler *s, const char *call) {
+
+  long long counters[queue_counter_count] = {0};
+  for (int k = 0; k < s->nr_queues; k++) {
+    for (int j = 0; j < queue_counter_count; j++)
+      counters[j] += s->queues[k].counters[j];
+    queue_reset_counters(&s->queues[k]);
+  }
+
+  char buffer[512];
+  int len = 0;
+  for (int j = 0; j < queue_counter_count; j++)
+    len += snprintf(buffer + len, sizeof(buffer) - len, "%s%s: %lld",
+                    j > 0 ? ", " : "", queue_counter_names[j], counters[j]);
+
+  message("(%s) %s queues: %s.", call,
+          s->queue_type == queue_type_deque ? "deque" : "heap", buffer);
+}
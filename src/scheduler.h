@@ -50,14 +50,42 @@
        break engine_addlink as it assumes \
        a maximum number of tasks per cell. */
 
+/* Constants of the measured-cost model. */
+#define scheduler_cost_model_nr_bins 16
+#define scheduler_cost_model_min_samples 10
+#define scheduler_cost_model_window 1000.
+#define scheduler_cost_model_send_boost 20.
+#define scheduler_cost_model_recv_boost 10.
+#define scheduler_mpi_progress_init_size 256
+
 /* Flags . */
 #define scheduler_flag_none 0
 #define scheduler_flag_steal (1 << 1)
 
+/* Where a task was stolen from. */
+enum scheduler_steal_types {
+  scheduler_steal_none = 0,
+  scheduler_steal_local,
+  scheduler_steal_remote,
+};
+
 #ifdef SWIFT_DEBUG_CHECKS
 extern int activate_by_unskip;
 #endif
 
+/**
+ * @brief Running sums of the linear fit of the measured cost of the tasks
+ * of one type, sub-type and range of analytic cost estimates.
+ */
+struct scheduler_cost_bin {
+
+  /* Number of tasks. */
+  double n;
+
+  /* Sums of the analytic estimates (x) and measured costs (y). */
+  double sum_x, sum_y, sum_xx, sum_xy;
+};
+
 /* Data of a scheduler. */
 struct scheduler {
   /* Scheduler flags. */
@@ -69,6 +97,18 @@ struct scheduler {
   /* Array of queues. */
   struct queue *queues;
 
+  /* The back-end used by the queues. */
+  enum queue_types queue_type;
+
+  /* Order in which each queue steals from the others, the queues sharing
+   * the same L3 cache or NUMA node come first. Row-major, one row of
+   * nr_queues - 1 entries per queue. */
+  int *steal_order;
+
+  /* Number of queues in the same L3 cache or NUMA domain, in each row of
+   * steal_order. */
+  int *steal_nr_local;
+
   /* Total number of tasks. */
   int nr_tasks, size, tasks_next;
 
@@ -93,9 +133,8 @@ struct scheduler {
   /* Lock for this scheduler. */
   swift_lock_type lock;
 
-  /* Waiting queue. */
-  pthread_mutex_t sleep_mutex;
-  pthread_cond_t sleep_cond;
+  /* Number of runners parked on their queue. */
+  volatile int nr_sleeping;
 
   /* The space associated with this scheduler. */
   struct space *space;
@@ -110,9 +149,33 @@ struct scheduler {
    * MPI. */
   size_t mpi_message_limit;
 
+  /* Are we using a dedicated thread to progress the communications? */
+  int use_mpi_progress;
+
+  /* The MPI progress thread, NULL if not used. */
+  struct scheduler_mpi_progress *mpi_progress;
+
   /* Total ticks spent running the tasks */
   ticks total_ticks;
 
+  /* Are we using measured costs to compute the task weights? */
+  int use_measured_costs;
+
+  /* Are we fusing the implicit tasks into the tasks unlocking them? */
+  int fuse_implicit_tasks;
+
+  /* The measured-cost model, NULL if not used. */
+  struct scheduler_cost_bin *cost_model;
+
+  /* Mean ratio of the measured to the analytic costs. */
+  double cost_model_ratio;
+
+  /* Largest mean measured cost of a bin, used to weight the communications. */
+  double cost_model_max;
+
+  /* Start of the launch whose tasks are being added to the model. */
+  ticks cost_model_launch_tic;
+
   struct {
     /* Total ticks spent waiting for runners to come home. */
     ticks waiting_ticks;
@@ -295,6 +358,7 @@ void scheduler_start(struct scheduler *s);
 void scheduler_reset(struct scheduler *s, int nr_tasks);
 void scheduler_ranktasks(struct scheduler *s);
 void scheduler_reweight(struct scheduler *s, int verbose);
+void scheduler_update_cost_model(struct scheduler *s, const ticks launch_tic);
 struct task *scheduler_addtask(struct scheduler *s, enum task_types type,
                                enum task_subtypes subtype, long long flags,
                                int implicit, struct cell *ci, struct cell *cj);
@@ -304,6 +368,7 @@ struct task *scheduler_done(struct scheduler *s, struct task *t);
 struct task *scheduler_unlock(struct scheduler *s, struct task *t);
 void scheduler_addunlock(struct scheduler *s, struct task *ta, struct task *tb);
 void scheduler_set_unlocks(struct scheduler *s);
+void scheduler_fuse_implicit_tasks(struct scheduler *s, const int verbose);
 void scheduler_dump_queue(struct scheduler *s);
 void scheduler_print_tasks(const struct scheduler *s, const char *fileName);
 void scheduler_clean(struct scheduler *s);
@@ -315,5 +380,10 @@ void scheduler_write_task_level(const struct scheduler *s, int step);
 void scheduler_dump_queues(struct engine *e);
 void scheduler_report_task_times(const struct scheduler *s,
                                  const int nr_threads);
+void scheduler_wake(struct scheduler *s, int qid);
+void scheduler_wake_all(struct scheduler *s);
+void scheduler_report_queue_counters(struct scheduler *s, const char *call);
+void scheduler_init_steal_order(struct scheduler *s, const int *queue_cpuid,
+                                int verbose);
 
 #endif /* SWIFT_SCHEDULER_H */
@@ -100,6 +100,7 @@
 #include "timeline.h"
 #include "timers.h"
 #include "tools.h"
+#include "trace.h"
 #include "units.h"
 #include "velociraptor_interface.h"
 #include "version.h"
@@ -47,6 +47,7 @@
 #include "inline.h"
 #include "lock.h"
 #include "mpiuse.h"
+#include "trace.h"
 
 /* Task type names. */
 const char *taskID_names[task_type_count] = {
@@ -705,6 +706,37 @@ void task_unlock(struct task *t) {
   }
 }
 
+/**
+ * @brief Check whether a hydro interaction #task is in conflict with the
+ * running tasks, without trying to lock anything.
+ *
+ * A failed task_lock() on a pair task can take and release the locks and
+ * holds of a whole branch of the tree before giving up. Checking both cells
+ * with plain loads first lets the queues pass over the tasks that are
+ * bound to fail for free.
+ *
+ * @param t the #task.
+ * @return 1 if task_lock() would currently fail, 0 if it may succeed.
+ */
+int task_conflicts(const struct task *t) {
+
+  const enum task_types type = t->type;
+  const enum task_subtypes subtype = t->subtype;
+
+  if (type != task_type_self && type != task_type_sub_self &&
+      type != task_type_pair && type != task_type_sub_pair)
+    return 0;
+
+  /* Only the tasks locking the gas particles alone. */
+  if (subtype != task_subtype_density && subtype != task_subtype_gradient &&
+      subtype != task_subtype_force)
+    return 0;
+
+  if (cell_hydro_is_locked(t->ci)) return 1;
+  if (t->cj != NULL && cell_hydro_is_locked(t->cj)) return 1;
+  return 0;
+}
+
 /**
  * @brief Try to lock the cells associated with this task.
  *
@@ -726,6 +758,9 @@ int task_lock(struct task *t) {
     case task_type_recv:
     case task_type_send:
 #ifdef WITH_MPI
+      /* Already completed by the MPI progress thread? */
+      if (t->req == MPI_REQUEST_NULL) return 1;
+
       /* Check the status of the MPI request. */
       if ((err = MPI_Test(&t->req, &res, &stat)) != MPI_SUCCESS) {
         char buff[MPI_MAX_ERROR_STRING];
@@ -740,6 +775,7 @@ int task_lock(struct task *t) {
       /* And log deactivation, if logging enabled. */
       if (res) {
         mpiuse_log_allocation(t->type, t->subtype, &t->req, 0, 0, 0, 0);
+        if (trace_active) trace_record_mpi(t, getticks());
       }
 
       return res;
@@ -1442,6 +1478,9 @@ void task_dump_stats(const char *dumpfile, struct engine *e,
     }
   }
 
+  /* Number of tasks stolen from queues in the same and in other domains. */
+  int steals[2] = {0, 0};
+
   double stepdt = (double)e->toc_step - (double)e->tic_step;
   double total[1] = {0.0};
   int dumped_plot_data = 0;
@@ -1472,6 +1511,11 @@ void task_dump_stats(const char *dumpfile, struct engine *e,
       }
       total[0] += dt;
 
+#ifdef SWIFT_DEBUG_TASKS
+      if (e->sched.tasks[l].stolen == scheduler_steal_local) steals[0] += 1;
+      if (e->sched.tasks[l].stolen == scheduler_steal_remote) steals[1] += 1;
+#endif
+
       /* Check if this is a problematic task and make a report. */
       if (dump_tasks_threshold > 0. && dt / stepdt > dump_tasks_threshold) {
 
@@ -1528,6 +1572,10 @@ void task_dump_stats(const char *dumpfile, struct engine *e,
     res = MPI_Reduce((engine_rank == 0 ? MPI_IN_PLACE : total), total, 1,
                      MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
     if (res != MPI_SUCCESS) mpi_error(res, "Failed to reduce task total time");
+
+    res = MPI_Reduce((engine_rank == 0 ? MPI_IN_PLACE : steals), steals, 2,
+                     MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (res != MPI_SUCCESS) mpi_error(res, "Failed to reduce task steals");
   }
 
   if (!allranks || (engine_rank == 0 && (allranks || header))) {
@@ -1573,6 +1621,8 @@ void task_dump_stats(const char *dumpfile, struct engine *e,
         }
       }
     }
+    if (!header)
+      fprintf(dfile, "# steals: local %d remote %d\n", steals[0], steals[1]);
     fclose(dfile);
 #ifdef WITH_MPI
   }
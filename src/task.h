@@ -33,6 +33,7 @@
 /* Forward declarations to avoid circular inclusion dependencies. */
 struct cell;
 struct engine;
+struct gravity_interaction_list;
 
 #define task_align 128
 
@@ -241,6 +242,9 @@ struct task {
   /*! Flags used to carry additional information (e.g. sort directions) */
   long long flags;
 
+  /*! Cached tree walk of the gravity tasks (NULL if not used) */
+  struct gravity_interaction_list *grav_list;
+
 #ifdef WITH_MPI
 
   /*! Buffer for this task's communications */
@@ -275,12 +279,18 @@ struct task {
   /*! Is this task implicit (i.e. does not do anything) ? */
   char implicit;
 
+  /*! ID of the queue this task was last put in */
+  short int qid;
+
 #ifdef SWIFT_DEBUG_TASKS
   /*! ID of the queue or runner owning this task */
   short int rid;
 
   /*! Information about the direction of the pair task */
   short int sid;
+
+  /*! Where was this task stolen from, a #scheduler_steal_types */
+  char stolen;
 #endif
 
   /*! Start and end time of this task */
@@ -306,6 +316,7 @@ struct task {
 void task_unlock(struct task *t);
 float task_overlap(const struct task *ta, const struct task *tb);
 int task_lock(struct task *t);
+int task_conflicts(const struct task *t);
 struct task *task_get_unique_dependent(const struct task *t);
 void task_print(const struct task *t);
 void task_dump_all(struct engine *e, int step);
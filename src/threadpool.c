@@ -39,6 +39,7 @@
 #include "clocks.h"
 #include "error.h"
 #include "minmax.h"
+#include "trace.h"
 
 /* Keys for thread specific data. */
 static pthread_key_t threadpool_tid;
@@ -80,6 +81,64 @@ static void threadpool_log(struct threadpool *tp, int tid, size_t chunk_size,
   entry->toc = toc;
   entry->map_function = tp->map_function;
   log->count++;
+
+  /* Accumulate the load-balance statistics of the current call. */
+  if (tid >= 0) {
+    tp->call_busy[tid] += toc - tic;
+    if (toc > tp->call_finish[tid]) tp->call_finish[tid] = toc;
+  }
+}
+
+/**
+ * @brief Re-set the load-balance statistics before a new call.
+ */
+static void threadpool_start_call(struct threadpool *tp) {
+  for (int k = 0; k < tp->num_threads; k++) {
+    tp->call_busy[k] = 0;
+    tp->call_finish[k] = 0;
+  }
+  tp->call_nr_steals = 0;
+}
+
+/**
+ * @brief Store the load-balance statistics of a finished call.
+ */
+static void threadpool_end_call(struct threadpool *tp,
+                                threadpool_map_function map_function,
+                                int chunk, size_t N) {
+
+  /* Check if we need to re-allocate the statistics buffer. */
+  if (tp->call_stats_count == tp->call_stats_size) {
+    tp->call_stats_size *= 2;
+    struct mapper_call_stats *new_stats;
+    if ((new_stats = (struct mapper_call_stats *)malloc(
+             sizeof(struct mapper_call_stats) * tp->call_stats_size)) == NULL)
+      error("Failed to re-allocate mapper call statistics.");
+    memcpy(new_stats, tp->call_stats,
+           sizeof(struct mapper_call_stats) * tp->call_stats_count);
+    free(tp->call_stats);
+    tp->call_stats = new_stats;
+  }
+
+  ticks busy_max = 0, busy_total = 0;
+  ticks finish_min = 0, finish_max = 0;
+  for (int k = 0; k < tp->num_threads; k++) {
+    busy_total += tp->call_busy[k];
+    if (tp->call_busy[k] > busy_max) busy_max = tp->call_busy[k];
+    if (tp->call_finish[k] == 0) continue;
+    if (finish_min == 0 || tp->call_finish[k] < finish_min)
+      finish_min = tp->call_finish[k];
+    if (tp->call_finish[k] > finish_max) finish_max = tp->call_finish[k];
+  }
+
+  struct mapper_call_stats *stats = &tp->call_stats[tp->call_stats_count++];
+  stats->map_function = map_function;
+  stats->chunk = chunk;
+  stats->N = N;
+  stats->nr_steals = tp->call_nr_steals;
+  stats->busy_max = busy_max;
+  stats->busy_mean = busy_total / tp->num_threads;
+  stats->tail = finish_max - finish_min;
 }
 
 void threadpool_dump_log(struct threadpool *tp, const char *filename,
@@ -137,11 +196,154 @@ void threadpool_dump_log(struct threadpool *tp, const char *filename,
     if (reset) log->count = 0;
   }
 
+  /* Append the load-balance statistics of each call as comments. The chunk
+   * mode is the chunk argument of the call: 0 for automatic chunks, -1 for
+   * uniform chunks, -2 for work stealing, a fixed chunk size otherwise. */
+  fprintf(fd,
+          "# imbalance: map_function chunk_mode N steals busy_max busy_mean "
+          "tail\n");
+  for (int k = 0; k < tp->call_stats_count; k++) {
+    const struct mapper_call_stats *stats = &tp->call_stats[k];
+    Dl_info dl_info;
+    dladdr(stats->map_function, &dl_info);
+    fprintf(fd, "# imbalance: %s %i %zu %i %lli %lli %lli\n",
+            dl_info.dli_sname, stats->chunk, stats->N, stats->nr_steals,
+            stats->busy_max, stats->busy_mean, stats->tail);
+  }
+  if (reset) tp->call_stats_count = 0;
+
   /* Close the file. */
   fclose(fd);
 }
 #endif  // SWIFT_DEBUG_THREADPOOL
 
+/**
+ * @brief Steal half of the remaining elements of the most loaded thread.
+ *
+ * @param tp The #threadpool.
+ * @param tid The ID of the stealing thread, whose range must be empty.
+ *
+ * @return 1 if something was stolen, 0 if there is no work left.
+ */
+static int threadpool_steal(struct threadpool *tp, int tid) {
+
+  while (1) {
+
+    /* Find the thread with the most remaining elements. */
+    int victim = -1;
+    unsigned int max_left = 0;
+    for (int k = 0; k < tp->num_threads; k++) {
+      if (k == tid) continue;
+      const unsigned long long range = tp->ranges[k].range;
+      const unsigned int begin = range >> 32, end = range & 0xffffffffULL;
+      if (end > begin && end - begin > max_left) {
+        max_left = end - begin;
+        victim = k;
+      }
+    }
+    if (victim < 0) return 0;
+
+    /* Try to take the upper half of its range. */
+    const unsigned long long old_range = tp->ranges[victim].range;
+    const unsigned int begin = old_range >> 32, end = old_range & 0xffffffffULL;
+    if (end <= begin) continue;
+    const unsigned int half = (end - begin + 1) / 2;
+    const unsigned long long new_range =
+        ((unsigned long long)begin << 32) | (end - half);
+    if (atomic_cas(&tp->ranges[victim].range, old_range, new_range) !=
+        old_range)
+      continue;
+
+    /* Make it ours. */
+    __atomic_store_n(&tp->ranges[tid].range,
+                     ((unsigned long long)(end - half) << 32) | end,
+                     __ATOMIC_SEQ_CST);
+#ifdef SWIFT_DEBUG_THREADPOOL
+    atomic_inc(&tp->call_nr_steals);
+#endif
+    return 1;
+  }
+}
+
+/**
+ * @brief Get the next chunk of elements in work-stealing mode.
+ *
+ * Each thread takes guided chunks, half of what is left but at most
+ * map_data_chunk elements, from the front of its own range. Once its range
+ * is empty, it steals the upper half of the range of the most loaded thread.
+ *
+ * @param tp The #threadpool.
+ * @param tid The ID of the calling thread.
+ * @param task_ind (return) The index of the first element of the chunk.
+ * @param chunk_size (return) The number of elements in the chunk.
+ *
+ * @return 1 if a chunk was found, 0 if there is no work left.
+ */
+static int threadpool_get_chunk_steal(struct threadpool *tp, int tid,
+                                      size_t *task_ind,
+                                      ptrdiff_t *chunk_size) {
+
+  struct threadpool_range *own = &tp->ranges[tid];
+  while (1) {
+    const unsigned long long old_range = own->range;
+    const unsigned int begin = old_range >> 32, end = old_range & 0xffffffffULL;
+
+    /* Nothing left here? Go and get some more. */
+    if (begin >= end) {
+      if (!threadpool_steal(tp, tid)) return 0;
+      continue;
+    }
+
+    unsigned int chunk = (end - begin) / 2;
+    if ((ptrdiff_t)chunk > tp->map_data_chunk) chunk = tp->map_data_chunk;
+    if (chunk < 1) chunk = 1;
+    const unsigned long long new_range =
+        ((unsigned long long)(begin + chunk) << 32) | end;
+    if (atomic_cas(&own->range, old_range, new_range) != old_range) continue;
+
+    *task_ind = begin;
+    *chunk_size = chunk;
+    return 1;
+  }
+}
+
+/**
+ * @brief Get the next chunk of elements from the shared counter.
+ *
+ * @param tp The #threadpool.
+ * @param tid The ID of the calling thread.
+ * @param task_ind (return) The index of the first element of the chunk.
+ * @param chunk_size (return) The number of elements in the chunk.
+ *
+ * @return 1 if a chunk was found, 0 if there is no work left.
+ */
+static int threadpool_get_chunk(struct threadpool *tp, int tid,
+                                size_t *task_ind, ptrdiff_t *chunk_size) {
+
+  /* Compute the desired chunk size. */
+  ptrdiff_t size;
+  if (tp->map_data_chunk == threadpool_uniform_chunk_size) {
+    size = ((tid + 1) * tp->map_data_size / tp->num_threads) -
+           (tid * tp->map_data_size / tp->num_threads);
+  } else {
+    size = (tp->map_data_size - tp->map_data_count) / (2 * tp->num_threads);
+    if (size > tp->map_data_chunk) size = tp->map_data_chunk;
+  }
+  if (size < 1) size = 1;
+
+  /* A chunk cannot exceed INT_MAX, as we use int elements in map_function. */
+  if (size > INT_MAX) size = INT_MAX;
+
+  /* Get a chunk and check its size. */
+  const size_t ind = atomic_add(&tp->map_data_count, size);
+  if (ind >= tp->map_data_size) return 0;
+  if (ind + size > tp->map_data_size) size = tp->map_data_size - ind;
+
+  *task_ind = ind;
+  *chunk_size = size;
+  return 1;
+}
+
 /**
  * @brief Runner main loop, get a chunk and call the mapper function.
  */
@@ -153,31 +355,21 @@ static void threadpool_chomp(struct threadpool *tp, int tid) {
 
   /* Loop until we can't get a chunk. */
   while (1) {
-    /* Compute the desired chunk size. */
+
+    /* Get a chunk. */
+    size_t task_ind;
     ptrdiff_t chunk_size;
-    if (tp->map_data_chunk == threadpool_uniform_chunk_size) {
-      chunk_size = ((tid + 1) * tp->map_data_size / tp->num_threads) -
-                   (tid * tp->map_data_size / tp->num_threads);
+    if (tp->map_steal) {
+      if (!threadpool_get_chunk_steal(tp, tid, &task_ind, &chunk_size)) break;
     } else {
-      chunk_size =
-          (tp->map_data_size - tp->map_data_count) / (2 * tp->num_threads);
-      if (chunk_size > tp->map_data_chunk) chunk_size = tp->map_data_chunk;
+      if (!threadpool_get_chunk(tp, tid, &task_ind, &chunk_size)) break;
     }
-    if (chunk_size < 1) chunk_size = 1;
-
-    /* A chunk cannot exceed INT_MAX, as we use int elements in map_function. */
-    if (chunk_size > INT_MAX) chunk_size = INT_MAX;
-
-    /* Get a chunk and check its size. */
-    size_t task_ind = atomic_add(&tp->map_data_count, chunk_size);
-    if (task_ind >= tp->map_data_size) break;
-    if (task_ind + chunk_size > tp->map_data_size)
-      chunk_size = tp->map_data_size - task_ind;
 
 /* Call the mapper function. */
 #ifdef SWIFT_DEBUG_THREADPOOL
     ticks tic = getticks();
 #endif
+    const ticks tic_trace = trace_active ? getticks() : 0;
 
     tp->map_function((char *)tp->map_data + (tp->map_data_stride * task_ind),
                      chunk_size, tp->map_extra_data);
@@ -185,6 +377,9 @@ static void threadpool_chomp(struct threadpool *tp, int tid) {
 #ifdef SWIFT_DEBUG_THREADPOOL
     threadpool_log(tp, tid, chunk_size, tic, getticks());
 #endif
+    if (trace_active)
+      trace_record_chunk((const void *)tp->map_function, chunk_size, tic_trace,
+                         getticks());
   }
 }
 
@@ -201,6 +396,9 @@ static void *threadpool_runner(void *data) {
   /* Our affinity, if set. */
   threadpool_apply_affinity_mask();
 
+  /* Get a trace buffer, if tracing. */
+  trace_thread_init("threadpool", -1);
+
   /* Main loop. */
   while (1) {
 
@@ -248,8 +446,23 @@ void threadpool_init(struct threadpool *tp, int num_threads) {
              sizeof(struct mapper_log_entry) * tp->logs[k].size)) == NULL)
       error("Failed to allocate mapper log.");
   }
+  if ((tp->call_busy = (ticks *)malloc(sizeof(ticks) * num_threads)) == NULL ||
+      (tp->call_finish = (ticks *)malloc(sizeof(ticks) * num_threads)) ==
+          NULL)
+    error("Failed to allocate mapper call timers.");
+  tp->call_stats_size = threadpool_log_initial_size;
+  tp->call_stats_count = 0;
+  if ((tp->call_stats = (struct mapper_call_stats *)malloc(
+           sizeof(struct mapper_call_stats) * tp->call_stats_size)) == NULL)
+    error("Failed to allocate mapper call statistics.");
 #endif
 
+  /* The ranges for the work-stealing mode. */
+  tp->map_steal = 0;
+  if (posix_memalign((void **)&tp->ranges, threadpool_range_align,
+                     sizeof(struct threadpool_range) * num_threads) != 0)
+    error("Failed to allocate threadpool ranges.");
+
   /* If there is only a single thread, do nothing more as of here as
      we will just do work in the (blocked) calling thread. */
   if (num_threads == 1) return;
@@ -298,7 +511,10 @@ void threadpool_init(struct threadpool *tp, int num_threads) {
  *        or #threadpool_auto_chunk_size to choose the number dynamically
  *        depending on the number of threads and tasks (recommended), or
  *        #threadpool_uniform_chunk_size to spread the tasks evenly over the
- *        threads in one go.
+ *        threads in one go, or #threadpool_steal_chunk_size to give each
+ *        thread its own range of elements to work through and let idle
+ *        threads steal from the others (recommended for very uneven
+ *        per-element costs).
  * @param extra_data Addtitional pointer that will be passed to the mapping
  *        function, may contain additional data.
  */
@@ -308,13 +524,18 @@ void threadpool_map(struct threadpool *tp, threadpool_map_function map_function,
 
 #ifdef SWIFT_DEBUG_THREADPOOL
   ticks tic_total = getticks();
+  threadpool_start_call(tp);
 #endif
 
   /* If we just have a single thread, call the map function directly. */
   if (tp->num_threads == 1) {
 
     if (N <= INT_MAX) {
+      const ticks tic_trace = trace_active ? getticks() : 0;
       map_function(map_data, N, extra_data);
+      if (trace_active)
+        trace_record_chunk((const void *)map_function, N, tic_trace,
+                           getticks());
 
 #ifdef SWIFT_DEBUG_THREADPOOL
       tp->map_function = map_function;
@@ -346,6 +567,9 @@ void threadpool_map(struct threadpool *tp, threadpool_map_function map_function,
       }
     }
 
+#ifdef SWIFT_DEBUG_THREADPOOL
+    threadpool_end_call(tp, map_function, chunk, N);
+#endif
     return;
   }
 
@@ -358,9 +582,24 @@ void threadpool_map(struct threadpool *tp, threadpool_map_function map_function,
         max((N / (tp->num_threads * threadpool_default_chunk_ratio)), 1U);
   } else if (chunk == threadpool_uniform_chunk_size) {
     tp->map_data_chunk = threadpool_uniform_chunk_size;
+  } else if (chunk == threadpool_steal_chunk_size) {
+    tp->map_data_chunk =
+        max((N / (tp->num_threads * threadpool_default_chunk_ratio)), 1U);
   } else {
     tp->map_data_chunk = chunk;
   }
+
+  /* Split the elements evenly over the threads when stealing. The ranges are
+   * stored as two 32-bit indices, so fall back to the automatic chunks for
+   * larger arrays. */
+  tp->map_steal = (chunk == threadpool_steal_chunk_size && N < UINT_MAX);
+  if (tp->map_steal) {
+    for (int k = 0; k < tp->num_threads; k++) {
+      const unsigned long long begin = k * N / tp->num_threads;
+      const unsigned long long end = (k + 1) * N / tp->num_threads;
+      tp->ranges[k].range = (begin << 32) | end;
+    }
+  }
   tp->map_function = map_function;
   tp->map_data = map_data;
   tp->map_extra_data = extra_data;
@@ -378,6 +617,7 @@ void threadpool_map(struct threadpool *tp, threadpool_map_function map_function,
 #ifdef SWIFT_DEBUG_THREADPOOL
   /* Log the total call time to thread id -1. */
   threadpool_log(tp, -1, N, tic_total, getticks());
+  threadpool_end_call(tp, map_function, chunk, N);
 #endif
 }
 
@@ -387,6 +627,7 @@ void threadpool_map(struct threadpool *tp, threadpool_map_function map_function,
 #ifdef SWIFT_DEBUG_THREADPOOL
 void threadpool_reset_log(struct threadpool *tp) {
   for (int k = 0; k < tp->num_threads; k++) tp->logs[k].count = 0;
+  tp->call_stats_count = 0;
 }
 #endif
 
@@ -420,7 +661,11 @@ void threadpool_clean(struct threadpool *tp) {
     free(tp->logs[k].log);
   }
   free(tp->logs);
+  free(tp->call_busy);
+  free(tp->call_finish);
+  free(tp->call_stats);
 #endif
+  free(tp->ranges);
 }
 
 /**
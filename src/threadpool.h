@@ -35,6 +35,8 @@
 #define threadpool_default_chunk_ratio 7
 #define threadpool_auto_chunk_size 0
 #define threadpool_uniform_chunk_size -1
+#define threadpool_steal_chunk_size -2
+#define threadpool_range_align 64
 
 /* Function type for mappings. */
 typedef void (*threadpool_map_function)(void *map_data, int num_elements,
@@ -56,6 +58,28 @@ struct mapper_log_entry {
   ticks tic, toc;
 };
 
+/* Load-balance statistics of a single threadpool_map() call. */
+struct mapper_call_stats {
+
+  /* Pointer to the mapper function. */
+  threadpool_map_function map_function;
+
+  /* Chunking mode, i.e. the chunk argument of the call. */
+  int chunk;
+
+  /* Number of elements mapped. */
+  size_t N;
+
+  /* Number of ranges stolen (work-stealing mode only). */
+  int nr_steals;
+
+  /* Maximal and mean time spent in the mapper by a thread. */
+  ticks busy_max, busy_mean;
+
+  /* Time between the first and last thread running out of work. */
+  ticks tail;
+};
+
 struct mapper_log {
   /* Log of threadpool mapper calls. */
   struct mapper_log_entry *log;
@@ -67,6 +91,12 @@ struct mapper_log {
   int count;
 };
 
+/* Range of elements owned by a thread in work-stealing mode, packed as
+ * (begin << 32) | end so that it can be updated with a single CAS. */
+struct threadpool_range {
+  volatile unsigned long long range;
+} __attribute__((aligned(threadpool_range_align)));
+
 /* Data of a threadpool. */
 struct threadpool {
 
@@ -83,6 +113,12 @@ struct threadpool {
   volatile ptrdiff_t map_data_chunk;
   volatile threadpool_map_function map_function;
 
+  /* Are the elements handed out from per-thread ranges with stealing? */
+  volatile int map_steal;
+
+  /* The per-thread ranges of elements for the work-stealing mode. */
+  struct threadpool_range *ranges;
+
   /* Number of threads in this pool. */
   int num_threads;
 
@@ -91,6 +127,14 @@ struct threadpool {
 
 #ifdef SWIFT_DEBUG_THREADPOOL
   struct mapper_log *logs;
+
+  /* Per-thread busy time and finishing time of the current call. */
+  ticks *call_busy, *call_finish;
+  volatile int call_nr_steals;
+
+  /* Load-balance statistics of the calls. */
+  struct mapper_call_stats *call_stats;
+  int call_stats_size, call_stats_count;
 #endif
 };
 
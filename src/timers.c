@@ -73,6 +73,7 @@ const char* timers_names[timer_count] = {
     "dopair_bh_feedback",
     "dopair_grav_mm",
     "dopair_grav_pp",
+    "grav_cache_populate",
     "dopair_sink_swallow",
     "dograv_external",
     "dograv_down",
@@ -105,6 +106,7 @@ const char* timers_names[timer_count] = {
     "dopair_subset",
     "dopair_subset_naive",
     "dosub_subset",
+    "dolist_subset",
     "do_ghost",
     "do_extra_ghost",
     "do_stars_ghost",
@@ -73,6 +73,7 @@ enum {
   timer_dopair_bh_feedback,
   timer_dopair_grav_mm,
   timer_dopair_grav_pp,
+  timer_grav_cache_populate,
   timer_dopair_sink_swallow,
   timer_dograv_external,
   timer_dograv_down,
@@ -105,6 +106,7 @@ enum {
   timer_dopair_subset,
   timer_dopair_subset_naive,
   timer_dosub_subset,
+  timer_dolist_subset,
   timer_do_ghost,
   timer_do_extra_ghost,
   timer_do_stars_ghost,
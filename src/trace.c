@@ -0,0 +1,330 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/**
+ *  @file trace.c
+ *  @brief Recording of the task, threadpool, MPI and engine phase activity
+ *  of a step and export to the Chrome trace format, which can be loaded in
+ *  Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ *  Each thread writes its events to its own ring buffer, so recording needs
+ *  no locks or atomics. When a buffer is full, the oldest events of that
+ *  thread are overwritten.
+ */
+
+/* Config parameters. */
+#include <config.h>
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef SWIFT_DEBUG_THREADPOOL
+#include <dlfcn.h>
+#endif
+
+/* This object's header. */
+#include "trace.h"
+
+/* Local includes. */
+#include "atomic.h"
+#include "cell.h"
+#include "clocks.h"
+#include "error.h"
+#include "task.h"
+
+/* Maximal number of threads that can record events. */
+#define trace_max_threads 4096
+
+/* A recorded event. */
+struct trace_event {
+
+  /* Start and end of the event. */
+  ticks tic, toc;
+
+  /* Name of the event, or map function for threadpool events. */
+  const void *name;
+
+  /* Sub-name of the event, i.e. the task subtype, if any. */
+  const char *subname;
+
+  /* Kind of event, see #trace_event_types. */
+  int type;
+
+  /* Extra information: peer rank or chunk size. */
+  int arg;
+};
+
+/* The events of a single thread. */
+struct trace_buffer {
+
+  /* Name of the thread. */
+  char name[trace_thread_name_length];
+
+  /* Total number of events recorded since the last trace_start(). */
+  unsigned long long count;
+
+  /* The ring of events. */
+  struct trace_event events[trace_buffer_size];
+};
+
+/* Is the tracing of the current step switched on? */
+volatile int trace_active = 0;
+
+/* Has tracing been requested at all? */
+static int trace_enabled = 0;
+
+/* Start of the current trace. */
+static ticks trace_tic = 0;
+
+/* The buffers of all the threads. */
+static struct trace_buffer *trace_buffers[trace_max_threads];
+static volatile int trace_nr_buffers = 0;
+
+/* The buffer of the calling thread. */
+static __thread struct trace_buffer *trace_local = NULL;
+
+/**
+ * @brief Switch on tracing. Must be called before any thread is started.
+ */
+void trace_init(void) { trace_enabled = 1; }
+
+/**
+ * @brief Set up the buffer of the calling thread.
+ *
+ * @param name Name of the thread in the trace.
+ * @param id Index appended to the name, the index of the buffer if negative.
+ */
+void trace_thread_init(const char *name, int id) {
+
+  if (!trace_enabled || trace_local != NULL) return;
+
+  const int ind = atomic_inc(&trace_nr_buffers);
+  if (ind >= trace_max_threads) error("Too many threads to trace.");
+
+  struct trace_buffer *buff =
+      (struct trace_buffer *)malloc(sizeof(struct trace_buffer));
+  if (buff == NULL) error("Failed to allocate trace buffer.");
+  snprintf(buff->name, trace_thread_name_length, "%s %d", name,
+           id >= 0 ? id : ind);
+  buff->count = 0;
+
+  trace_local = buff;
+  trace_buffers[ind] = buff;
+}
+
+/**
+ * @brief Start recording a new trace, dropping any old events.
+ *
+ * Must be called when no other thread is recording.
+ */
+void trace_start(void) {
+
+  if (!trace_enabled) return;
+
+  const int nr_buffers = trace_nr_buffers;
+  for (int k = 0; k < nr_buffers; k++)
+    if (trace_buffers[k] != NULL) trace_buffers[k]->count = 0;
+
+  trace_tic = getticks();
+  trace_active = 1;
+}
+
+/**
+ * @brief Stop recording events.
+ */
+void trace_stop(void) { trace_active = 0; }
+
+/**
+ * @brief Append an event to the buffer of the calling thread.
+ */
+static void trace_record(const void *name, const char *subname, int type,
+                         int arg, ticks tic, ticks toc) {
+
+  if (trace_local == NULL) trace_thread_init("thread", -1);
+  if (trace_local == NULL) return;
+
+  struct trace_buffer *buff = trace_local;
+  struct trace_event *ev =
+      &buff->events[buff->count & (trace_buffer_size - 1)];
+  ev->tic = tic;
+  ev->toc = toc;
+  ev->name = name;
+  ev->subname = subname;
+  ev->type = type;
+  ev->arg = arg;
+  buff->count++;
+}
+
+/**
+ * @brief Record the execution of a #task.
+ *
+ * @param t The #task, with its tic and toc set.
+ */
+void trace_record_task(const struct task *t) {
+
+  const int type = (t->type == task_type_send || t->type == task_type_recv)
+                       ? trace_event_mpi
+                       : trace_event_task;
+  trace_record(taskID_names[t->type], subtaskID_names[t->subtype], type, -1,
+               t->tic, t->toc);
+}
+
+/**
+ * @brief Record the completion of the MPI request of a send or recv #task.
+ *
+ * @param t The send or recv #task.
+ * @param tic The time at which the completion was detected.
+ */
+void trace_record_mpi(const struct task *t, ticks tic) {
+
+  const int rank =
+      (t->type == task_type_send) ? t->cj->nodeID : t->ci->nodeID;
+  trace_record(taskID_names[t->type], subtaskID_names[t->subtype],
+               trace_event_mpi, rank, tic, tic);
+}
+
+/**
+ * @brief Record a chunk of a threadpool_map() call.
+ *
+ * @param map_function The mapper function.
+ * @param chunk_size The number of elements in the chunk.
+ * @param tic Start of the chunk.
+ * @param toc End of the chunk.
+ */
+void trace_record_chunk(const void *map_function, int chunk_size, ticks tic,
+                        ticks toc) {
+  trace_record(map_function, NULL, trace_event_threadpool, chunk_size, tic,
+               toc);
+}
+
+/**
+ * @brief Record an engine phase, e.g. a part of a rebuild.
+ *
+ * @param name The name of the phase, must be a string literal.
+ * @param tic Start of the phase.
+ * @param toc End of the phase.
+ */
+void trace_record_phase(const char *name, ticks tic, ticks toc) {
+  trace_record(name, NULL, trace_event_phase, -1, tic, toc);
+}
+
+/**
+ * @brief Convert a time in ticks to micro-seconds since the trace start.
+ */
+static double trace_time(const ticks tic) {
+  if (tic < trace_tic) return -clocks_from_ticks(trace_tic - tic) * 1000.;
+  return clocks_from_ticks(tic - trace_tic) * 1000.;
+}
+
+/**
+ * @brief Write the recorded events to a Chrome trace JSON file.
+ *
+ * Must be called when no other thread is recording.
+ *
+ * @param filename The name of the file.
+ * @param rank The MPI rank, used as process ID in the trace.
+ */
+void trace_dump(const char *filename, int rank) {
+
+  FILE *file = fopen(filename, "w");
+  if (file == NULL) error("Could not create file '%s'.", filename);
+
+  static const char *categories[] = {"task", "mpi", "threadpool", "phase"};
+  unsigned long long dropped = 0;
+
+  fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  fprintf(file,
+          "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+          "\"args\": {\"name\": \"rank %d\"}}",
+          rank, rank);
+
+  const int nr_buffers = trace_nr_buffers;
+  for (int k = 0; k < nr_buffers; k++) {
+    const struct trace_buffer *buff = trace_buffers[k];
+    if (buff == NULL) continue;
+
+    fprintf(file,
+            ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, "
+            "\"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+            rank, k, buff->name);
+
+    /* Only the last trace_buffer_size events are still there. */
+    unsigned long long first = 0;
+    if (buff->count > trace_buffer_size) {
+      first = buff->count - trace_buffer_size;
+      dropped += first;
+    }
+
+    for (unsigned long long i = first; i < buff->count; i++) {
+      const struct trace_event *ev =
+          &buff->events[i & (trace_buffer_size - 1)];
+
+      /* Get a name for the event. */
+      char name[64];
+      if (ev->type == trace_event_threadpool) {
+#ifdef SWIFT_DEBUG_THREADPOOL
+        Dl_info dl_info;
+        if (dladdr(ev->name, &dl_info) != 0 && dl_info.dli_sname != NULL)
+          snprintf(name, sizeof(name), "%s", dl_info.dli_sname);
+        else
+#endif
+          snprintf(name, sizeof(name), "mapper %p", ev->name);
+      } else if (ev->subname != NULL &&
+                 strcmp(ev->subname, subtaskID_names[task_subtype_none])) {
+        snprintf(name, sizeof(name), "%s/%s", (const char *)ev->name,
+                 ev->subname);
+      } else {
+        snprintf(name, sizeof(name), "%s", (const char *)ev->name);
+      }
+
+      fprintf(file,
+              ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"pid\": %d, "
+              "\"tid\": %d, \"ts\": %.3f, ",
+              name, categories[ev->type], rank, k, trace_time(ev->tic));
+
+      if (ev->type == trace_event_mpi && ev->arg >= 0)
+        fprintf(file,
+                "\"ph\": \"i\", \"s\": \"t\", \"args\": {\"rank\": %d}}",
+                ev->arg);
+      else if (ev->type == trace_event_threadpool)
+        fprintf(file, "\"ph\": \"X\", \"dur\": %.3f, \"args\": {\"chunk\": %d}}",
+                trace_time(ev->toc) - trace_time(ev->tic), ev->arg);
+      else
+        fprintf(file, "\"ph\": \"X\", \"dur\": %.3f}",
+                trace_time(ev->toc) - trace_time(ev->tic));
+    }
+  }
+
+  fprintf(file, "\n], \"otherData\": {\"dropped_events\": %llu}}\n", dropped);
+  fclose(file);
+}
+
+/**
+ * @brief Free the buffers of all the threads.
+ */
+void trace_clean(void) {
+
+  const int nr_buffers = trace_nr_buffers;
+  for (int k = 0; k < nr_buffers; k++) {
+    free(trace_buffers[k]);
+    trace_buffers[k] = NULL;
+  }
+  trace_nr_buffers = 0;
+  trace_active = 0;
+}
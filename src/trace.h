@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_TRACE_H
+#define SWIFT_TRACE_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Local includes. */
+#include "cycle.h"
+
+/* Number of events kept per thread, must be a power of two. */
+#define trace_buffer_size (1 << 16)
+
+/* Length of the thread names. */
+#define trace_thread_name_length 32
+
+/* Forward declarations. */
+struct task;
+
+/* The kind of traced events. */
+enum trace_event_types {
+  trace_event_task = 0,
+  trace_event_mpi,
+  trace_event_threadpool,
+  trace_event_phase,
+};
+
+/* Is the tracing of the current step switched on? */
+extern volatile int trace_active;
+
+/* API. */
+void trace_init(void);
+void trace_thread_init(const char *name, int id);
+void trace_start(void);
+void trace_stop(void);
+void trace_record_task(const struct task *t);
+void trace_record_mpi(const struct task *t, ticks tic);
+void trace_record_chunk(const void *map_function, int chunk_size, ticks tic,
+                        ticks toc);
+void trace_record_phase(const char *name, ticks tic, ticks toc);
+void trace_dump(const char *filename, int rank);
+void trace_clean(void);
+
+#endif /* SWIFT_TRACE_H */
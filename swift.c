@@ -169,6 +169,7 @@ int main(int argc, char *argv[]) {
   int dump_tasks = 0;
   int dump_cells = 0;
   int dump_threadpool = 0;
+  int dump_trace = 0;
   int nsteps = -2;
   int restart = 0;
   int with_cosmology = 0;
@@ -356,6 +357,10 @@ int main(int argc, char *argv[]) {
       OPT_INTEGER('Y', "threadpool-dumps", &dump_threadpool,
                   "Time-step frequency at which threadpool tasks are dumped.",
                   NULL, 0, 0),
+      OPT_INTEGER(0, "trace-dumps", &dump_trace,
+                  "Time-step frequency at which Chrome/Perfetto traces of "
+                  "the tasks, threadpool and MPI activity are dumped.",
+                  NULL, 0, 0),
       OPT_FLOAT(0, "dump-tasks-threshold", &dump_tasks_threshold,
                 "Fraction of the total step's time spent in a task to trigger "
                 "a dump of the task plot on this step",
@@ -518,6 +523,12 @@ int main(int argc, char *argv[]) {
   }
 #endif
 
+  /* Get the trace buffers ready before any thread is started. */
+  if (dump_trace) {
+    trace_init();
+    trace_thread_init("main", -1);
+  }
+
 #ifdef WITH_MPI
   if (with_sinks) {
     pretime_message("Error: sink particles are not available yet with MPI.");
@@ -1717,9 +1728,26 @@ int main(int argc, char *argv[]) {
     /* Reset timers */
     timers_reset_all();
 
+    /* Trace this step? */
+    const int trace_step =
+        dump_trace && (dump_trace == 1 || j % dump_trace == 1);
+    if (trace_step) trace_start();
+
     /* Take a step. */
     force_stop = engine_step(&e);
 
+    /* Dump the trace of that step. */
+    if (trace_step) {
+      trace_stop();
+      char dumpfile[80];
+#ifdef WITH_MPI
+      snprintf(dumpfile, 80, "trace-rank%d-step%d.json", engine_rank, j + 1);
+#else
+      snprintf(dumpfile, 80, "trace-step%d.json", j + 1);
+#endif  // WITH_MPI
+      trace_dump(dumpfile, engine_rank);
+    }
+
     /* Print the timers. */
     if (with_verbose_timers) timers_print(e.step);
 
@@ -1926,8 +1954,10 @@ int main(int argc, char *argv[]) {
   if (with_lightcone) lightcone_array_clean(e.lightcone_array_properties);
   if (with_rt) rt_clean(e.rt_props, restart);
   if (with_power) power_clean(e.power_data);
+  if (with_hydro) eos_clean(&eos);
   extra_io_clean(e.io_extra_props);
   engine_clean(&e, /*fof=*/0, restart);
+  if (dump_trace) trace_clean();
   free(params);
   if (restart) free(refparams);
   free(output_options);
@@ -47,6 +47,131 @@
 #define ENGINE_POLICY engine_policy_none
 #endif
 
+#ifdef EOS_PLANETARY
+/**
+ * @brief Write a synthetic SESAME-style table (SI units) of a material with
+ * a cold compression term, which has a region of zero pressure at low
+ * densities and temperatures.
+ *
+ * @param filename The name of the table file.
+ */
+void write_SESAME_test_table(const char *filename) {
+
+  const int num_rho = 120, num_T = 100;
+  const double gamma = 5. / 3., cv = 1e3, rho_0 = 5e3, A = 1e10;
+
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) error("Could not open the test table file!");
+
+  for (int i = 0; i < 12; i++) fprintf(f, "# Synthetic SESAME-style table\n");
+  fprintf(f, "0\n%d %d\n", num_rho + 1, num_T + 1);
+
+  // Densities and temperatures, after the ignored zero first elements
+  double A1_rho[num_rho + 1], A1_T[num_T + 1];
+  A1_rho[0] = 0.;
+  A1_T[0] = 0.;
+  for (int i = 1; i <= num_rho; i++)
+    A1_rho[i] = pow(10., -3. + 8. * (i - 1) / (num_rho - 1));
+  for (int i = 1; i <= num_T; i++)
+    A1_T[i] = pow(10., 1. + 5. * (i - 1) / (num_T - 1));
+  for (int i = 0; i <= num_rho; i++) fprintf(f, "%.8e ", A1_rho[i]);
+  fprintf(f, "\n");
+  for (int i = 0; i <= num_T; i++) fprintf(f, "%.8e ", A1_T[i]);
+  fprintf(f, "\n");
+
+  // u, P, c, s for each T then each rho
+  for (int i_T = 0; i_T <= num_T; i_T++) {
+    for (int i_rho = 0; i_rho <= num_rho; i_rho++) {
+      const double rho = A1_rho[i_rho], T = A1_T[i_T];
+      const double x = rho / rho_0 - 1.;
+      const double u = cv * T + 0.5 * A / rho_0 * x * x;
+      double P = (gamma - 1.) * rho * cv * T + A * x;
+      if (P < 0.) P = 0.;
+      const double c = (rho > 0.) ? sqrt(gamma * P / rho + A / rho_0) : 0.;
+      const double s = (T > 0.) ? cv * log(T) : 0.;
+      fprintf(f, "%.8e %.8e %.8e %.8e\n", u, P, c, s);
+    }
+  }
+
+  fclose(f);
+}
+
+/**
+ * @brief Comparison function for qsort.
+ */
+int compare_floats(const void *a, const void *b) {
+  const float fa = *(const float *)a, fb = *(const float *)b;
+  return (fa > fb) - (fa < fb);
+}
+
+/**
+ * @brief Check the lookups in the tables resampled on the uniform grid
+ * against the direct interpolation of the original tables, at random points
+ * in the range of the tables.
+ *
+ * @param mat The material, resampled with a non-zero grid refinement.
+ */
+void check_SESAME_grid(const struct SESAME_params *mat) {
+
+  const int num_points = 100000;
+  float *err_P = (float *)malloc(num_points * sizeof(float));
+  float *err_c = (float *)malloc(num_points * sizeof(float));
+  if (err_P == NULL || err_c == NULL) error("Error allocating the errors.");
+  if (mat->grid_coeffs == NULL) error("The table was not resampled!");
+
+  const float log_rho_min = mat->table_log_rho[0];
+  const float log_rho_max = mat->table_log_rho[mat->num_rho - 1];
+  const float log_u_min = mat->grid_log_u_min;
+  const float log_u_max =
+      log_u_min + (mat->grid_num_u - 1) / mat->grid_inv_log_u_step;
+
+  int num_P = 0, num_zero_mismatch = 0;
+  for (int i = 0; i < num_points; i++) {
+    const float rho = expf(random_uniform(log_rho_min, log_rho_max));
+    const float u = expf(random_uniform(log_u_min, log_u_max));
+
+    float P, c;
+    SESAME_pressure_and_soundspeed_from_internal_energy(rho, u, mat, &P, &c);
+    const float P_direct =
+        SESAME_pressure_from_internal_energy_direct(rho, u, mat);
+    const float c_direct =
+        SESAME_soundspeed_from_internal_energy_direct(rho, u, mat);
+
+    if (P > 0.f && P_direct > 0.f)
+      err_P[num_P++] = fabsf(logf(P / P_direct));
+    else if (P > 0.f || P_direct > 0.f)
+      num_zero_mismatch++;
+    err_c[i] = fabsf(logf(c / c_direct));
+  }
+
+  qsort(err_P, num_P, sizeof(float), compare_floats);
+  qsort(err_c, num_points, sizeof(float), compare_floats);
+  const float P_median = err_P[num_P / 2], P_95 = err_P[(95 * num_P) / 100];
+  const float P_99 = err_P[(99 * num_P) / 100];
+  const float c_median = err_c[num_points / 2];
+  const float c_99 = err_c[(99 * num_points) / 100];
+  const float zero_mismatch = (float)num_zero_mismatch / num_points;
+
+  message(
+      "Resampled SESAME table, errors in log(P): median %.2e, 95%% %.2e, "
+      "99%% %.2e",
+      P_median, P_95, P_99);
+  message("Resampled SESAME table, errors in log(c): median %.2e, 99%% %.2e",
+          c_median, c_99);
+  message("Resampled SESAME table, zero pressure mismatches: %.2e",
+          zero_mismatch);
+
+  // The cells next to the zero pressure region use the original tables, so
+  // the largest remaining errors in P are where it is small but positive
+  if (P_median > 1e-4f || P_95 > 5e-3f || P_99 > 1e-1f || c_median > 1e-4f ||
+      c_99 > 1e-2f || zero_mismatch > 1e-3f)
+    error("The resampled SESAME table does not match the original one!");
+
+  free(err_P);
+  free(err_c);
+}
+#endif
+
 /**
  * @brief Write a list of densities, energies, and resulting pressures to file
  *  from an equation of state.
@@ -256,9 +381,26 @@ int main(int argc, char *argv[]) {
                    "EoS:planetary_SS08_water_table_file:"
                    "../examples/planetary_SS08_water.txt");
 
+  // Synthetic SESAME-style table to check the resampled grid lookups
+  write_SESAME_test_table("testEOS_SESAME_table.txt");
+  parser_set_param(params, "EoS:planetary_use_custom_0:1");
+  parser_set_param(params,
+                   "EoS:planetary_custom_0_table_file:"
+                   "testEOS_SESAME_table.txt");
+  parser_set_param(params, "EoS:planetary_SESAME_grid_refinement:2");
+
   // Initialise the EOS materials
   eos_init(&eos, phys_const, &us, params);
 
+  // Check the resampled grid against the direct interpolation of the table
+  check_SESAME_grid(&eos.custom[0]);
+
+  // The tests below need the downloaded HM80 tables, which are not loaded
+  if (eos.HM80_ice.table_log_P_rho_u == NULL) {
+    eos_clean(&eos);
+    return 0;
+  }
+
   // Manual debug testing
   if (1) {
     printf("\n ### MANUAL DEBUG TESTING ### \n");
@@ -268,6 +410,7 @@ int main(int argc, char *argv[]) {
     P = gas_pressure_from_internal_energy(rho, u, eos_planetary_id_HM80_ice);
     printf("u = %.2e,    rho = %.2e,    P = %.2e \n", u, rho, P);
 
+    eos_clean(&eos);
     return 0;
   }
 
@@ -340,6 +483,7 @@ int main(int argc, char *argv[]) {
   }
   fclose(f);
 
+  eos_clean(&eos);
   return 0;
 }
 #else
@@ -26,6 +26,7 @@
 #include <unistd.h>
 
 /* Local headers. */
+#include "multipole_batch.h"
 #include "runner_doiact_grav.h"
 #include "swift.h"
 
@@ -33,6 +34,85 @@ const int num_M2L_runs = 1 << 23;
 const int num_M2P_runs = 1 << 23;
 const int num_PP_runs = 1;  // << 8;
 
+/**
+ * @brief Check the terms of one rank of a field tensor computed in a batched
+ * M2L against the same terms from the non-symmetric M2L.
+ *
+ * The terms are compared relative to the norm of the rank in the reference.
+ *
+ * @param batch The terms from the batched M2L.
+ * @param scalar The terms from the non-symmetric M2L.
+ * @param num_terms The number of terms in the rank.
+ * @param rank The rank of the terms.
+ * @param periodic Was the calculation periodic?
+ */
+void check_M2L_batch_rank(const float *batch, const float *scalar,
+                          const int num_terms, const int rank,
+                          const int periodic) {
+
+  const float tol = 1e-5f;
+  float norm2 = 0.f;
+  for (int i = 0; i < num_terms; ++i) norm2 += scalar[i] * scalar[i];
+  const float norm = sqrtf(norm2);
+
+  for (int i = 0; i < num_terms; ++i)
+    if (fabsf(batch[i] - scalar[i]) > tol * norm)
+      error(
+          "Batched M2L differs from the non-symmetric M2L! periodic=%d "
+          "rank=%d term=%d [%e %e] (norm of the rank %e)",
+          periodic, rank, i, batch[i], scalar[i], norm);
+}
+
+/* The terms of each rank of a #grav_tensor */
+#define M2L_RANK_0(l) {l->F_000}
+#define M2L_RANK_1(l) {l->F_100, l->F_010, l->F_001}
+#define M2L_RANK_2(l) {l->F_200, l->F_020, l->F_002, l->F_110, l->F_101, l->F_011}
+#define M2L_RANK_3(l)                                                   \
+  {l->F_300, l->F_030, l->F_003, l->F_210, l->F_201, l->F_120, l->F_021, l->F_102, \
+   l->F_012, l->F_111}
+#define M2L_RANK_4(l)                                                   \
+  {l->F_400, l->F_040, l->F_004, l->F_310, l->F_301, l->F_130, l->F_031, l->F_103, \
+   l->F_013, l->F_220, l->F_202, l->F_022, l->F_211, l->F_121, l->F_112}
+#define M2L_RANK_5(l)                                                   \
+  {l->F_005, l->F_014, l->F_023, l->F_032, l->F_041, l->F_050, l->F_104,         \
+   l->F_113, l->F_122, l->F_131, l->F_140, l->F_203, l->F_212, l->F_221,         \
+   l->F_230, l->F_302, l->F_311, l->F_320, l->F_401, l->F_410, l->F_500}
+
+/**
+ * @brief Check all the terms of a field tensor computed in a batched M2L
+ * against the non-symmetric M2L.
+ *
+ * @param l_batch The field tensor from the batched M2L.
+ * @param l_scalar The field tensor from the non-symmetric M2L.
+ * @param periodic Was the calculation periodic?
+ */
+void check_M2L_batch(const struct grav_tensor *l_batch,
+                     const struct grav_tensor *l_scalar, const int periodic) {
+
+  const float b0[] = M2L_RANK_0(l_batch), s0[] = M2L_RANK_0(l_scalar);
+  check_M2L_batch_rank(b0, s0, 1, 0, periodic);
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  const float b1[] = M2L_RANK_1(l_batch), s1[] = M2L_RANK_1(l_scalar);
+  check_M2L_batch_rank(b1, s1, 3, 1, periodic);
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  const float b2[] = M2L_RANK_2(l_batch), s2[] = M2L_RANK_2(l_scalar);
+  check_M2L_batch_rank(b2, s2, 6, 2, periodic);
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  const float b3[] = M2L_RANK_3(l_batch), s3[] = M2L_RANK_3(l_scalar);
+  check_M2L_batch_rank(b3, s3, 10, 3, periodic);
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  const float b4[] = M2L_RANK_4(l_batch), s4[] = M2L_RANK_4(l_scalar);
+  check_M2L_batch_rank(b4, s4, 15, 4, periodic);
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  const float b5[] = M2L_RANK_5(l_batch), s5[] = M2L_RANK_5(l_scalar);
+  check_M2L_batch_rank(b5, s5, 21, 5, periodic);
+#endif
+}
+
 void make_cell(struct cell *c, int N, const double loc[3], double width,
                int id_base, const struct gravity_props *grav_props) {
 
@@ -264,6 +344,54 @@ int main(int argc, char *argv[]) {
           SELF_GRAVITY_MULTIPOLE_ORDER,
           (int)(1e6 * clocks_from_ticks(toc - tic) / num_M2L_runs), "ns");
 
+  /********
+   * Batched M2L (checked against the non-symmetric M2L)
+   ********/
+  struct gravity_M2L_batch batch;
+  gravity_M2L_batch_init(&batch);
+  for (int periodic = 0; periodic < 2; ++periodic) {
+
+    tic = getticks();
+    for (int n = 0; n < num_M2L_runs; n += GRAVITY_M2L_BATCH_SIZE) {
+
+      for (int k = 0; k < GRAVITY_M2L_BATCH_SIZE; ++k)
+        gravity_M2L_batch_add(&batch, &tensors_j[n + k].m_pole,
+                              tensors_i[n + k].CoM, tensors_j[n + k].CoM,
+                              periodic, dim);
+
+      gravity_M2L_batch_compute(&batch, periodic, r_s_inv);
+
+      for (int k = 0; k < GRAVITY_M2L_BATCH_SIZE; ++k)
+        gravity_M2L_batch_apply(&tensors_i[n + k].pot, &batch, k);
+      batch.count = 0;
+    }
+    toc = getticks();
+    message("%30s at order %d took %4d %s.",
+            periodic ? "Batched periodic M2L" : "Batched non-periodic M2L",
+            SELF_GRAVITY_MULTIPOLE_ORDER,
+            (int)(1e6 * clocks_from_ticks(toc - tic) / num_M2L_runs), "ns");
+
+    /* Check a partially filled batch against the scalar version */
+    const int num_checks = GRAVITY_M2L_BATCH_SIZE - 3;
+    struct grav_tensor l_scalar[GRAVITY_M2L_BATCH_SIZE];
+    struct grav_tensor l_batch[GRAVITY_M2L_BATCH_SIZE];
+    for (int k = 0; k < num_checks; ++k) {
+      gravity_field_tensors_init(&l_scalar[k], e.ti_current);
+      gravity_field_tensors_init(&l_batch[k], e.ti_current);
+      gravity_M2L_nonsym(&l_scalar[k], &tensors_j[k].m_pole,
+                         tensors_i[k].CoM, tensors_j[k].CoM, &grav_props,
+                         periodic, dim, r_s_inv);
+      gravity_M2L_batch_add(&batch, &tensors_j[k].m_pole, tensors_i[k].CoM,
+                            tensors_j[k].CoM, periodic, dim);
+    }
+    gravity_M2L_batch_compute(&batch, periodic, r_s_inv);
+    for (int k = 0; k < num_checks; ++k) {
+      gravity_M2L_batch_apply(&l_batch[k], &batch, k);
+      check_M2L_batch(&l_batch[k], &l_scalar[k], periodic);
+    }
+    batch.count = 0;
+  }
+
   /* Now run a series of M2L kernels */
 
   /********
@@ -90,6 +90,94 @@ double acceleration(double mass, double r, double H, double rlr) {
   return r * acc * (4. * x * S_prime(2 * x) - 2. * S(2. * x) + 2.);
 }
 
+/**
+ * @brief Fill a #cell with randomly placed massive particles.
+ *
+ * @param c The #cell (zeroed) to fill.
+ * @param loc The location of the #cell.
+ * @param count The number of particles to create.
+ * @param props The #gravity_props.
+ */
+void make_random_cell(struct cell *c, const double loc[3], const int count,
+                      const struct gravity_props *props) {
+
+  c->nodeID = 0;
+  for (int k = 0; k < 3; ++k) {
+    c->loc[k] = loc[k];
+    c->width[k] = 1.;
+  }
+  c->grav.count = count;
+  c->grav.ti_old_part = 8;
+  c->grav.ti_old_multipole = 8;
+  c->grav.ti_end_min = 8;
+
+  if (posix_memalign((void **)&c->grav.parts, gpart_align,
+                     count * sizeof(struct gpart)) != 0)
+    error("Error allocating gparts for a random cell");
+  bzero(c->grav.parts, count * sizeof(struct gpart));
+
+  for (int n = 0; n < count; ++n) {
+
+    struct gpart *gp = &c->grav.parts[n];
+
+    for (int k = 0; k < 3; ++k) gp->x[k] = loc[k] + random_uniform(0., 1.);
+    gp->mass = random_uniform(0.5, 1.);
+    gp->time_bin = 1;
+    gp->type = swift_type_dark_matter;
+    gp->id_or_neg_offset = n + 1;
+#ifdef MULTI_SOFTENING_GRAVITY
+    gp->epsilon = eps;
+#endif
+#ifdef SWIFT_DEBUG_CHECKS
+    gp->ti_drift = 8;
+    gp->initialised = 1;
+#endif
+  }
+
+  c->grav.multipole =
+      (struct gravity_tensors *)malloc(sizeof(struct gravity_tensors));
+  bzero(c->grav.multipole, sizeof(struct gravity_tensors));
+  gravity_P2M(c->grav.multipole, c->grav.parts, count, props);
+}
+
+/**
+ * @brief Run a sequence of P-P pairs and record the accelerations after each
+ * of them.
+ *
+ * @param r The #runner.
+ * @param pairs The pairs of #cell to interact.
+ * @param num_pairs The number of pairs.
+ * @param cells All the #cell involved in the pairs.
+ * @param num_cells The number of #cell.
+ * @param out The accelerations of all the particles after each pair.
+ */
+void run_pairs(struct runner *r, struct cell *pairs[][2], const int num_pairs,
+               struct cell *cells[], const int num_cells, float *out) {
+
+  for (int k = 0; k < num_cells; ++k)
+    for (int n = 0; n < cells[k]->grav.count; ++n)
+      gravity_init_gpart(&cells[k]->grav.parts[n]);
+
+  int ind = 0;
+  for (int p = 0; p < num_pairs; ++p) {
+
+    runner_dopair_grav_pp(r, pairs[p][0], pairs[p][1], /*symmetric=*/1,
+                          /*allow_mpoles=*/1);
+
+    for (int k = 0; k < num_cells; ++k) {
+      for (int n = 0; n < cells[k]->grav.count; ++n) {
+        const struct gpart *gp = &cells[k]->grav.parts[n];
+        out[ind++] = gp->a_grav[0];
+        out[ind++] = gp->a_grav[1];
+        out[ind++] = gp->a_grav[2];
+#if defined(POTENTIAL_GRAVITY)
+        out[ind++] = gp->potential;
+#endif
+      }
+    }
+  }
+}
+
 int main(int argc, char *argv[]) {
 
   /* Initialize CPU frequency, this also starts time. */
@@ -444,6 +532,83 @@ int main(int argc, char *argv[]) {
 
 #endif
 
+  /***************************************************/
+  /* Test the re-use of the caches between the pairs */
+  /***************************************************/
+
+  /* Three cells such that A-B, A-C and C-A share a cell with the pair
+   * before them */
+  struct cell cell_a, cell_b, cell_c;
+  bzero(&cell_a, sizeof(struct cell));
+  bzero(&cell_b, sizeof(struct cell));
+  bzero(&cell_c, sizeof(struct cell));
+  const double loc_a[3] = {2., 2., 2.};
+  const double loc_b[3] = {3., 2., 2.};
+  const double loc_c[3] = {2., 3., 2.};
+  make_random_cell(&cell_a, loc_a, 37, &props);
+  make_random_cell(&cell_b, loc_b, 50, &props);
+  make_random_cell(&cell_c, loc_c, 23, &props);
+
+  struct cell *cells[3] = {&cell_a, &cell_b, &cell_c};
+  struct cell *pairs[4][2] = {{&cell_a, &cell_b},
+                              {&cell_a, &cell_c},
+                              {&cell_c, &cell_a},
+                              {&cell_b, &cell_a}};
+  const int num_pairs = 4;
+#if defined(POTENTIAL_GRAVITY)
+  const int num_fields = 4;
+#else
+  const int num_fields = 3;
+#endif
+  const int out_size = num_pairs * (37 + 50 + 23) * num_fields;
+  float *out_reuse = (float *)malloc(out_size * sizeof(float));
+  float *out_fresh = (float *)malloc(out_size * sizeof(float));
+
+  /* Allow some M2P interactions */
+  props.theta_crit = 0.7;
+
+  for (int periodic = 0; periodic < 2; ++periodic) {
+
+    mesh.periodic = periodic;
+    s.periodic = periodic;
+
+    /* Re-use the caches whenever possible... */
+    r.reuse_gravity_caches = 1;
+    gravity_cache_invalidate(&r.ci_gravity_cache);
+    gravity_cache_invalidate(&r.cj_gravity_cache);
+    run_pairs(&r, pairs, num_pairs, cells, 3, out_reuse);
+
+    /* The last pair must have left both of its cells in the caches */
+    if (!(gravity_cache_holds_cell(&r.ci_gravity_cache, &cell_a) ||
+          gravity_cache_holds_cell(&r.cj_gravity_cache, &cell_a)) ||
+        !(gravity_cache_holds_cell(&r.ci_gravity_cache, &cell_b) ||
+          gravity_cache_holds_cell(&r.cj_gravity_cache, &cell_b)))
+      error("The caches were not tagged for re-use");
+
+    /* ... and compare to filling them for every pair */
+    r.reuse_gravity_caches = 0;
+    gravity_cache_invalidate(&r.ci_gravity_cache);
+    gravity_cache_invalidate(&r.cj_gravity_cache);
+    run_pairs(&r, pairs, num_pairs, cells, 3, out_fresh);
+
+    for (int n = 0; n < out_size; ++n)
+      if (out_reuse[n] != out_fresh[n])
+        error(
+            "Re-used caches give a different result: %12.15e vs %12.15e "
+            "(periodic=%d, pair=%d)",
+            out_reuse[n], out_fresh[n], periodic,
+            n / ((37 + 50 + 23) * num_fields));
+  }
+
+  message("\n\t\t re-used caches all good\n");
+
+  free(out_reuse);
+  free(out_fresh);
+  for (int k = 0; k < 3; ++k) {
+    free(cells[k]->grav.multipole);
+    free(cells[k]->grav.parts);
+  }
+
   free(ci.grav.multipole);
   free(cj.grav.multipole);
   free(ci.grav.parts);
@@ -37,6 +37,7 @@
 const float max_abs_error = 1e-3f;
 const float max_rel_error = 1e-3f;
 const float min_threshold = 1e-2f;
+const float batch_rel_error = 1e-5f;
 
 /**
  * @brief Checks whether two numbers are opposite of each others.
@@ -147,6 +148,127 @@ void check_riemann_symmetry(void) {
   }
 }
 
+/**
+ * @brief Draws a random Riemann problem.
+ *
+ * @param with_vacuum Whether one of the states may be vacuum.
+ */
+void random_riemann_problem(float *WL, float *WR, float *n_unit, float *vij,
+                            const int with_vacuum) {
+
+  WL[0] = random_uniform(0.1f, 1.0f);
+  WL[1] = random_uniform(-10.0f, 10.0f);
+  WL[2] = random_uniform(-10.0f, 10.0f);
+  WL[3] = random_uniform(-10.0f, 10.0f);
+  WL[4] = random_uniform(0.1f, 1.0f);
+  WR[0] = random_uniform(0.1f, 1.0f);
+  WR[1] = random_uniform(-10.0f, 10.0f);
+  WR[2] = random_uniform(-10.0f, 10.0f);
+  WR[3] = random_uniform(-10.0f, 10.0f);
+  WR[4] = random_uniform(0.1f, 1.0f);
+
+  if (with_vacuum) {
+    const int vacuum = rand() % 8;
+    if (vacuum == 0) {
+      WL[0] = 0.0f;
+      WL[4] = 0.0f;
+    } else if (vacuum == 1) {
+      WR[0] = 0.0f;
+      WR[4] = 0.0f;
+    }
+  }
+
+  n_unit[0] = random_uniform(-1.0f, 1.0f);
+  n_unit[1] = random_uniform(-1.0f, 1.0f);
+  n_unit[2] = random_uniform(-1.0f, 1.0f);
+
+  const float n_norm = sqrtf(n_unit[0] * n_unit[0] + n_unit[1] * n_unit[1] +
+                             n_unit[2] * n_unit[2]);
+  n_unit[0] /= n_norm;
+  n_unit[1] /= n_norm;
+  n_unit[2] /= n_norm;
+
+  vij[0] = random_uniform(-10.0f, 10.0f);
+  vij[1] = random_uniform(-10.0f, 10.0f);
+  vij[2] = random_uniform(-10.0f, 10.0f);
+}
+
+/**
+ * @brief Checks whether the flux of a batch agrees with the scalar one.
+ *
+ * The fluxes are compared relative to a flux scale built from the states,
+ * since the middle state fluxes can be small differences of large numbers.
+ */
+int fluxes_agree(const float *WL, const float *WR, const float *vij,
+                 const float *batch_flux, const float *flux) {
+
+  float v = sqrtf(vij[0] * vij[0] + vij[1] * vij[1] + vij[2] * vij[2]);
+  v += max(sqrtf(WL[1] * WL[1] + WL[2] * WL[2] + WL[3] * WL[3]),
+           sqrtf(WR[1] * WR[1] + WR[2] * WR[2] + WR[3] * WR[3]));
+  const float rho = max(WL[0], WR[0]);
+  const float P = max(WL[4], WR[4]);
+  const float scale = (rho * v * v + P) * (1.f + v);
+
+  for (int k = 0; k < 5; k++)
+    if (fabsf(batch_flux[k] - flux[k]) > batch_rel_error * scale) return 0;
+  return 1;
+}
+
+/**
+ * @brief Check a batch of random Riemann problems solved by the vector HLLC
+ * solver against the scalar solver.
+ *
+ * @param count Number of problems in the batch (the batch is partially
+ * filled if this is smaller than #RIEMANN_BATCH_SIZE).
+ * @param middle_state Check the middle state fluxes instead of the full
+ * fluxes.
+ */
+void check_riemann_batch(const int count, const int middle_state) {
+
+  struct riemann_batch b;
+  float WL[RIEMANN_BATCH_SIZE][5], WR[RIEMANN_BATCH_SIZE][5];
+  float n_unit[RIEMANN_BATCH_SIZE][3], vij[RIEMANN_BATCH_SIZE][3];
+
+  /* The scalar middle state solver does not handle a vacuum state */
+  for (int i = 0; i < count; i++) {
+    random_riemann_problem(WL[i], WR[i], n_unit[i], vij[i], !middle_state);
+    riemann_batch_set_problem(&b, i, WL[i], WR[i], n_unit[i], vij[i]);
+  }
+
+  if (middle_state)
+    riemann_solve_batch_for_middle_state_flux(&b, count);
+  else
+    riemann_solve_batch_for_flux(&b, count);
+
+  for (int i = 0; i < count; i++) {
+    float batch_flux[5], flux[5];
+    riemann_batch_get_flux(&b, i, batch_flux);
+    if (middle_state)
+      riemann_solve_for_middle_state_flux(WL[i], WR[i], n_unit[i], vij[i],
+                                          flux);
+    else
+      riemann_solve_for_flux(WL[i], WR[i], n_unit[i], vij[i], flux);
+
+    if (!fluxes_agree(WL[i], WR[i], vij[i], batch_flux, flux)) {
+      message("Problem %d of %d", i, count);
+      message("WL=[%.8e, %.8e, %.8e, %.8e, %.8e]", WL[i][0], WL[i][1],
+              WL[i][2], WL[i][3], WL[i][4]);
+      message("WR=[%.8e, %.8e, %.8e, %.8e, %.8e]", WR[i][0], WR[i][1],
+              WR[i][2], WR[i][3], WR[i][4]);
+      message("n_unit=[%.8e, %.8e, %.8e]", n_unit[i][0], n_unit[i][1],
+              n_unit[i][2]);
+      message("vij=[%.8e, %.8e, %.8e]", vij[i][0], vij[i][1], vij[i][2]);
+      message(
+          "Batch and scalar %s fluxes differ: [%.6e,%.6e,%.6e,%.6e,%.6e] != "
+          "[%.6e,%.6e,%.6e,%.6e,%.6e]",
+          middle_state ? "middle state" : "full", batch_flux[0],
+          batch_flux[1], batch_flux[2], batch_flux[3], batch_flux[4], flux[0],
+          flux[1], flux[2], flux[3], flux[4]);
+      error("Batch solution differs from the scalar one!");
+    }
+  }
+}
+
 /**
  * @brief Check the HLLC Riemann solver
  */
@@ -171,5 +293,13 @@ int main(int argc, char *argv[]) {
     check_riemann_symmetry();
   }
 
+  /* batch test: full batches and a partially filled final batch */
+  for (int i = 0; i < 10000; i++) {
+    for (int middle_state = 0; middle_state < 2; middle_state++) {
+      check_riemann_batch(RIEMANN_BATCH_SIZE, middle_state);
+      check_riemann_batch(1 + rand() % RIEMANN_BATCH_SIZE, middle_state);
+    }
+  }
+
   return 0;
 }
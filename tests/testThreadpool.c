@@ -70,6 +70,16 @@ void map_function_check_uniform(void *map_data, int num_elements,
   printf("    map_function_check_uniform handled %d elements\n", num_elements);
 }
 
+void map_function_check_steal(void *map_data, int num_elements,
+                              void *extra_data) {
+  int *hits = (int *)map_data;
+  for (int ind = 0; ind < num_elements; ind++) {
+    /* Make the first elements much more expensive than the others. */
+    if (&hits[ind] - (int *)extra_data < 50) usleep(1000);
+    atomic_inc(&hits[ind]);
+  }
+}
+
 int main(int argc, char *argv[]) {
 
   // Some constants for this test.
@@ -169,5 +179,31 @@ int main(int argc, char *argv[]) {
 
   printf("# passed uniform checks\n");
 
+  printf("# threadpool_steal_chunk_size checks\n");
+
+  /* Check that work stealing maps every element exactly once. */
+  for (int num_thread = 1; num_thread <= 16; num_thread *= 4) {
+    struct threadpool stp;
+    threadpool_init(&stp, num_thread);
+
+    for (int nr_hits = 0; nr_hits <= 1000; nr_hits += 333) {
+      int hits[1000] = {0};
+      threadpool_map(&stp, map_function_check_steal, hits, nr_hits,
+                     sizeof(int), threadpool_steal_chunk_size, hits);
+      for (int k = 0; k < 1000; k++) {
+        if (hits[k] != (k < nr_hits ? 1 : 0)) {
+          printf("  work stealing not correct, element %d mapped %d times\n",
+                 k, hits[k]);
+          fflush(stdout);
+          exit(1);
+        }
+      }
+    }
+
+    threadpool_clean(&stp);
+  }
+
+  printf("# passed steal checks\n");
+
   return 0;
 }
@@ -330,6 +330,133 @@ if order > 0:
 print("")
 print("-------------------------------------------------")
 
+print("struct gravity_M2L_batch:")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d\n" % (order - 1))
+
+if order != 1:
+    print("/*! %s order terms of the multipoles. */" % ordinal(order))
+    for i in range(order + 1):
+        for j in range(order + 1):
+            for k in range(order + 1):
+                if i + j + k == order:
+                    print(
+                        "float M_%d%d%d[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;"
+                        % (i, j, k)
+                    )
+    print("")
+
+print("/*! %s order terms of the field tensors. */" % ordinal(order))
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print(
+                    "float F_%d%d%d[GRAVITY_M2L_BATCH_SIZE] SWIFT_CACHE_ALIGN;"
+                    % (i, j, k)
+                )
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch_add():")
+print("-------------------------------------------------\n")
+
+if order > 1:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+if order != 1:
+    for i in range(order + 1):
+        for j in range(order + 1):
+            for k in range(order + 1):
+                if i + j + k == order:
+                    print("b->M_%d%d%d[n] = m_a->M_%d%d%d;" % (i, j, k, i, j, k))
+
+if order > 1:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch_compute():")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d\n" % (order - 1))
+
+if order != 1:
+    for i in range(order + 1):
+        for j in range(order + 1):
+            for k in range(order + 1):
+                if i + j + k == order:
+                    print("const float M_%d%d%d = b->M_%d%d%d[n];" % (i, j, k, i, j, k))
+    print("")
+
+# Loop over LHS order (the dipole terms vanish when using the CoM)
+for l in range(order + 1):
+    if order - l == 1:
+        continue
+    print(
+        "/* %s order terms (%s rank %d) */"
+        % (ordinal(order), "contribution to" if l < order else "start of", l)
+    )
+
+    for i in range(l + 1):
+        for j in range(l + 1):
+            for k in range(l + 1):
+                if i + j + k == l:
+                    print(
+                        "b->F_%d%d%d[n] %s"
+                        % (i, j, k, "+=" if l < order else "="),
+                        end=" ",
+                    )
+
+                    first = True
+                    for ii in range(order + 1):
+                        for jj in range(order + 1):
+                            for kk in range(order + 1):
+                                if ii + jj + kk == order - l:
+                                    if first:
+                                        first = False
+                                    else:
+                                        print("+", end=" ")
+                                    print(
+                                        "M_%d%d%d * pot.D_%d%d%d"
+                                        % (ii, jj, kk, i + ii, j + jj, k + kk),
+                                        end=" ",
+                                    )
+                    print(";")
+    print("")
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch_apply():")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print("l_b->F_%d%d%d += b->F_%d%d%d[n];" % (i, j, k, i, j, k))
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
 print("gravity_P2L():")
 print("-------------------------------------------------\n")
 